@@ -27,9 +27,20 @@ struct Parameters {
     std::string pd_algorithm;
     std::string infile;
     std::string outfile;
+    std::string output_format;
     std::string configfile;
+    std::string coordinator;
+    std::string worker;
+    std::string manifest;
+    int precision;
     int tuple_size;
     long tuple_limit;
+    int strata;
+    long bootstrap;
+    double confidence;
+    unsigned seed;
+    double top_fraction;
+    long sample;
     int num_threads;
     bool cache;
 };
@@ -92,12 +103,20 @@ int main(int argc, char *argv[]) {
     Parameters dparam;
     dparam.tuple_size = 2;
     dparam.tuple_limit = 0;
+    dparam.strata = -1;
+    dparam.bootstrap = 0;
+    dparam.confidence = 0.95;
+    dparam.seed = 0;
+    dparam.top_fraction = 0;
+    dparam.sample = 100000;
     dparam.num_threads = 2;
     dparam.cache = true;
     dparam.measure = "symmetricdelta";
     dparam.tuple_algorithm = "completion";
     dparam.pd_algorithm = "vector";
     dparam.outfile = "/dev/stdout";
+    dparam.output_format = "csv";
+    dparam.precision = 6;
 
     //
     // Argument processing
@@ -112,10 +131,26 @@ int main(int argc, char *argv[]) {
         ("help,h", "Print this help")
         ("input-file,i", po::value(&param.infile), "Input NxM matrix file, CSV and TSV formats accepted")
         ("output-file,o", po::value(&param.outfile)->default_value(dparam.outfile), "Results output file")
+        ("output-format", po::value(&param.output_format)->default_value(dparam.output_format), "Results file format: csv, binary (float64) or binary32 (float32)")
+        ("precision", po::value(&param.precision)->default_value(dparam.precision), "Significant digits of CSV values, 0 for the shortest exact representation")
         ("config-file,c", po::value(&param.configfile), "YML Config file")
         ("tuple-size,s", po::value(&param.tuple_size)->default_value(dparam.tuple_size), "Number of variables in each tuple")
         ("tuple-limit,l", po::value(&param.tuple_limit)->default_value(dparam.tuple_limit), "Maximum number of tuples to process")
         ("measure,m", po::value(&param.measure)->default_value(dparam.measure), "Information Theory Measure")
+        ("strata", po::value(&param.strata)->default_value(dparam.strata), "Input column with the stratum label of each sample, the measure is computed per stratum")
+        ("strata-differences", "Also output the difference of each stratum from stratum 0")
+        ("bootstrap", po::value(&param.bootstrap)->default_value(dparam.bootstrap), "Number of bootstrap replicates for confidence intervals")
+        ("confidence", po::value(&param.confidence)->default_value(dparam.confidence), "Confidence level of bootstrap intervals")
+        ("seed", po::value(&param.seed)->default_value(dparam.seed), "Random number generator seed")
+        ("top-fraction", po::value(&param.top_fraction)->default_value(dparam.top_fraction), "Set the cutoff to keep about this fraction of tuples, estimated from a random sample of tuples")
+        ("sample", po::value(&param.sample)->default_value(dparam.sample), "Number of tuples sampled for --top-fraction")
+        ("deduplicate", "Collapse identical samples, counting each by its multiplicity")
+        ("compact-bins", "Remap the values of each variable to contiguous bins from 0")
+        ("ordered", "Write results in tuple order, the same for any number of threads")
+        ("shards", "Each thread writes its results to output-file.shard<i>, listed in output-file.manifest")
+        ("merge-shards", "Write shards and merge them into output-file after the search")
+        ("reduce-variables", "Leave constant and duplicate variables out of the search, duplicates get copies of their representative's results")
+        ("omit-duplicates", "With --reduce-variables, do not output tuples with duplicate variables")
         ("progress,p", "Print progress to stderr")
         ("version,v", "Print version string and exit")
     ;
@@ -127,9 +162,16 @@ int main(int argc, char *argv[]) {
         ("threads,t", po::value(&param.num_threads)->default_value(dparam.num_threads), "Number of threads")
     ;
 
+    po::options_description opt_dist("Multi-process options");
+    opt_dist.add_options()
+        ("coordinator", po::value(&param.coordinator), "Hand out chunks of the search to workers listening on this socket")
+        ("worker", po::value(&param.worker), "Search chunks from the coordinator on this socket, output goes to output-file.PID")
+        ("manifest", po::value(&param.manifest), "Coordinator writes the shard byte range of each chunk to this file")
+    ;
+
     // combine options groups
     po::options_description opts;
-    opts.add(opt_basic).add(opt_perf);
+    opts.add(opt_basic).add(opt_perf).add(opt_dist);
 
     // add in positional options
     po::positional_options_description p;
@@ -182,8 +224,29 @@ int main(int argc, char *argv[]) {
     mist.set_ranks(param.num_threads);
     mist.set_show_progress(progress);
     mist.set_outfile(param.outfile);
+    mist.set_output_format(param.output_format);
+    mist.set_output_precision(param.precision);
+    mist.set_ordered_output(vm.count("ordered"));
+    if (vm.count("shards") || vm.count("merge-shards"))
+        mist.set_output_shards(true, vm.count("merge-shards"));
+    mist.set_deduplicate(vm.count("deduplicate"));
+    mist.set_compact_bins(vm.count("compact-bins"));
     mist.load_file(param.infile);
-    mist.start();
+    if (param.strata >= 0)
+        mist.set_strata(param.strata, vm.count("strata-differences"));
+    if (vm.count("reduce-variables"))
+        mist.set_reduce_variables(true, !vm.count("omit-duplicates"));
+    if (param.bootstrap > 0)
+        mist.set_bootstrap(param.bootstrap, param.confidence, param.seed);
+    if (param.top_fraction > 0)
+        mist.estimate_cutoff(param.top_fraction, param.sample, param.seed);
+    if (!param.coordinator.empty()) {
+        mist.start_coordinator(param.coordinator, param.manifest);
+    } else if (!param.worker.empty()) {
+        mist.start_worker(param.worker);
+    } else {
+        mist.start();
+    }
     if (debug)
         mist.printCacheStats();
     return 0;
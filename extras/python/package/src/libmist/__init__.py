@@ -1,2 +1,3 @@
 from libmist.libmist import *
+from libmist.results import open_mapped_results, read_binary_results, square_pair_matrix
 __version__ = "1.3.0"
@@ -0,0 +1,45 @@
+import struct
+
+import numpy as np
+
+MAGIC = b"MISTBIN1"
+
+
+def read_binary_results(filename):
+    """Read a results file written with output_format "binary" or "binary32".
+
+    Returns (tuples, values, names): an N x d uint32 array of the variables
+    of each tuple, an N x n array of their values, float64 or float32 as
+    written, and the column names. The arrays are views of one buffer read
+    from the file, without per-record conversion.
+    """
+    with open(filename, "rb") as f:
+        fixed = f.read(len(MAGIC) + 20)
+        if fixed[:len(MAGIC)] != MAGIC:
+            raise ValueError("'%s' is not a binary results file" % filename)
+        size, d, n, value_size, names_length = struct.unpack(
+            "=5I", fixed[len(MAGIC):])
+        names = f.read(names_length).decode().split(",")
+    value_type = np.float32 if value_size == 4 else np.float64
+    record = np.dtype([("tuple", np.uint32, (d,)), ("values", value_type, (n,))])
+    records = np.fromfile(filename, dtype=record, offset=size)
+    return records["tuple"], records["values"], names
+
+
+def open_mapped_results(filename, ncols, mode="r"):
+    """Open the results file of Search.results_map_file as an N x ncols
+    numpy.memmap of float64, ncols the number of columns of the results.
+    """
+    return np.memmap(filename, dtype=np.float64, mode=mode).reshape(-1, ncols)
+
+
+def square_pair_matrix(plane, diagonal=np.nan):
+    """Unpack a plane of Search.get_pair_matrix, packed as the pairs i < j
+    in the order of numpy.tril_indices(n, -1), into a symmetric n x n array.
+    """
+    n = int(round((1 + np.sqrt(1 + 8 * len(plane))) / 2))
+    matrix = np.full((n, n), diagonal, dtype=plane.dtype)
+    rows, cols = np.tril_indices(n, -1)
+    matrix[rows, cols] = plane
+    matrix[cols, rows] = plane
+    return matrix
@@ -36,3 +36,20 @@ def test_count_tuples_custom():
 def test_constructor_exception():
     with pytest.raises(Exception) as e_info:
         ts = lm.TupleSpace(10,0)
+
+def test_tuple_list_range():
+    ts = lm.TupleSpace()
+    ts.addTuples(np.array([[0,1,9]], dtype='int64'))
+    search = lm.Search()
+    search.load_file_column_major(filename)
+    search.tuple_space = ts
+    search.start()
+    ts = lm.TupleSpace()
+    ts.addTuples(np.array([[0,1,10]], dtype='int64'))
+    search.tuple_space = ts
+    with pytest.raises(Exception):
+        search.start()
+    with pytest.raises(Exception):
+        lm.TupleSpace().addTuples(np.array([[0,-1]], dtype='int64'))
+    with pytest.raises(Exception):
+        lm.TupleSpace().addTuples(np.array([[0,2**32]], dtype='uint64'))
@@ -0,0 +1,31 @@
+import libmist as pld
+import numpy as np
+import pytest
+
+filename = "sample_data.csv"
+
+def sort_results(res):
+    return res[np.lexsort(res[:,:3].T[::-1])]
+
+def new_search():
+    mist = pld.Search()
+    mist.load_file_column_major(filename)
+    mist.tuple_size = 3
+    mist.threads = 3
+    return mist
+
+def test_batches():
+    full = new_search().start()
+    mist = new_search()
+    batches = [batch for batch in mist.start_batches(7)]
+    assert(max(len(batch) for batch in batches) <= 7)
+    np.testing.assert_array_equal(sort_results(np.concatenate(batches)),
+                                  sort_results(full))
+
+def test_batches_abandoned():
+    # another search drops the batches of a running one
+    full = new_search().start()
+    mist = new_search()
+    batches = mist.start_batches(1)
+    next(batches)
+    np.testing.assert_array_equal(sort_results(mist.start()), sort_results(full))
@@ -0,0 +1,73 @@
+import libmist as pld
+import numpy as np
+import multiprocessing as mp
+import os
+import signal
+import time
+import pytest
+
+# Variables with a common source at both ends of the variable list, so the
+# screen keeps tuples of the first and last ranks. The last rank has few of
+# them and finishes long before the others.
+def screened_data():
+    rng = np.random.default_rng(1)
+    n, nvar = 2000, 80
+    z = rng.integers(0, 3, size=n)
+    x = rng.integers(0, 3, size=(n, nvar))
+    for v in list(range(0, 30)) + list(range(68, 80)):
+        noise = rng.random(n) < 0.3
+        x[:, v] = np.where(noise, rng.integers(0, 3, size=n), z)
+    return np.asfortranarray(x.astype('int8'))
+
+def new_search(data, outfile):
+    mist = pld.Search()
+    mist.load_ndarray(data)
+    mist.tuple_size = 3
+    mist.ranks = 3
+    mist.set_screen("MutualInformation", 0.05)
+    mist.outfile = outfile
+    return mist
+
+def read_rows(outfile):
+    rows = np.genfromtxt(outfile, delimiter=',', skip_header=1)
+    return rows[np.lexsort(rows[:,:3].T[::-1])]
+
+def checkpoint_workers(filename):
+    try:
+        with open(filename) as f:
+            return [[int(x) for x in line.split()[1:]]
+                    for line in f if line.startswith("worker")]
+    except OSError:
+        return []
+
+def run_checkpointed(data, outfile, checkpoint):
+    mist = new_search(data, outfile)
+    mist.set_checkpoint(checkpoint, 1)
+    mist.start()
+
+def test_resume_after_kill(tmp_path):
+    data = screened_data()
+    full = str(tmp_path / "full.csv")
+    part = str(tmp_path / "part.csv")
+    checkpoint = str(tmp_path / "part.ckpt")
+
+    new_search(data, full).start()
+
+    # kill once the checkpoint has a finished worker and an unfinished one
+    proc = mp.get_context("fork").Process(target=run_checkpointed,
+                                          args=(data, part, checkpoint))
+    proc.start()
+    while proc.is_alive():
+        workers = checkpoint_workers(checkpoint)
+        done = [w[0] == w[1] for w in workers]
+        if any(done) and not all(done):
+            break
+        time.sleep(0.01)
+    assert(proc.is_alive())
+    os.kill(proc.pid, signal.SIGKILL)
+    proc.join()
+
+    mist = new_search(data, part)
+    mist.resume(checkpoint)
+    assert(not os.path.exists(checkpoint))
+    np.testing.assert_array_equal(read_rows(full), read_rows(part))
@@ -0,0 +1,56 @@
+import libmist as pld
+import numpy as np
+import multiprocessing as mp
+import os
+import time
+import pytest
+
+def new_search(filename):
+    mist = pld.Search()
+    mist.load_file_column_major(filename)
+    mist.tuple_size = 3
+    mist.ranks = 2
+    return mist
+
+def run_coordinator(filename, socket, manifest):
+    new_search(filename).start_coordinator(socket, manifest)
+
+def run_worker(filename, socket, outfile):
+    mist = new_search(filename)
+    mist.outfile = outfile
+    mist.start_worker(socket)
+
+def test_coordinator_workers(tmp_path):
+    socket = str(tmp_path / "mist.sock")
+    manifest = str(tmp_path / "results.manifest")
+    outfile = str(tmp_path / "results.csv")
+    # large enough that both workers join before the search is done
+    filename = str(tmp_path / "data.csv")
+    rng = np.random.default_rng(1)
+    np.savetxt(filename, rng.integers(0, 3, size=(500, 40)), fmt='%d', delimiter=',')
+
+    ctx = mp.get_context("fork")
+    coordinator = ctx.Process(target=run_coordinator,
+                              args=(filename, socket, manifest))
+    coordinator.start()
+    while not os.path.exists(socket) and coordinator.is_alive():
+        time.sleep(0.01)
+    procs = [ctx.Process(target=run_worker, args=(filename, socket, outfile))
+             for ii in range(2)]
+    for proc in procs:
+        proc.start()
+    procs.append(coordinator)
+    for proc in procs:
+        proc.join(60)
+        assert(proc.exitcode == 0)
+
+    # workers search several chunks each
+    with open(manifest) as f:
+        assert(sum(line.startswith("chunk") for line in f) > 2)
+
+    # the shards merged in manifest order are the rows of a plain search, in
+    # tuple order
+    merged = str(tmp_path / "merged.csv")
+    pld.Search().merge_shards(manifest, merged)
+    res = np.genfromtxt(merged, delimiter=',', skip_header=1)
+    np.testing.assert_allclose(res, new_search(filename).start(), rtol=1e-5)
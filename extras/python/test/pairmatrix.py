@@ -0,0 +1,43 @@
+import libmist as pld
+import numpy as np
+import pytest
+
+# The Search uses ndarray data without copying, so the arrays are kept alive
+# for as long as the Search.
+
+def random_data(nrow, nvar, seed):
+    rng = np.random.default_rng(seed)
+    return np.asfortranarray(rng.integers(0, 3, size=(nrow, nvar)).astype('int8'))
+
+def plain_planes(res, nvar):
+    # rows of pairs i < j placed as numpy.tril_indices(nvar, -1)
+    i, j = res[:,0].astype(int), res[:,1].astype(int)
+    index = j * (j - 1) // 2 + i
+    planes = np.full((res.shape[1] - 2, nvar * (nvar - 1) // 2), np.nan)
+    planes[:, index] = res[:,2:].T
+    return planes
+
+@pytest.mark.parametrize("intermediate", [False, True])
+def test_pair_matrix(intermediate):
+    nvar = 30
+    data = random_data(200, nvar, 1)
+    mist = pld.Search()
+    mist.load_ndarray(data)
+    mist.tuple_size = 2
+    mist.output_intermediate = intermediate
+    full = mist.start()
+
+    mist.pair_matrix = True
+    assert(len(mist.start()) == 0)
+    planes = mist.get_pair_matrix()
+    assert(len(mist.get_pair_matrix_names()) == len(planes))
+    np.testing.assert_allclose(planes, plain_planes(full, nvar), rtol=1e-5)
+
+    # pairs below the cutoff are NaN
+    mist.cutoff = np.median(full[:,-1])
+    mist.pair_matrix = False
+    kept = mist.start()
+    mist.pair_matrix = True
+    mist.start()
+    np.testing.assert_allclose(mist.get_pair_matrix(), plain_planes(kept, nvar),
+                               rtol=1e-5)
@@ -0,0 +1,29 @@
+import libmist as pld
+import numpy as np
+import pytest
+
+def sort_results(res):
+    return res[np.lexsort(res[:,:3].T[::-1])]
+
+def test_reduce_expand():
+    # variable 5 duplicates variable 3, variable 7 duplicates variable 1
+    rng = np.random.default_rng(1)
+    data = rng.integers(0, 3, size=(200, 9)).astype('int8')
+    data[:,5] = data[:,3]
+    data[:,7] = data[:,1]
+    data = np.asfortranarray(data)
+
+    mist = pld.Search()
+    mist.load_ndarray(data)
+    mist.tuple_size = 3
+    full = mist.start()
+    # tuples with two variables of the same class are left out
+    same_class = lambda t: {3, 5} <= set(t) or {1, 7} <= set(t)
+    full = np.array([row for row in full if not same_class(row[:3])])
+
+    mist.set_reduce_variables(True, True)
+    reduced = mist.start()
+    assert(reduced.shape == full.shape)
+    # copies list their variables in increasing order, as the full search
+    assert(np.all(np.diff(reduced[:,:3], axis=1) > 0))
+    np.testing.assert_allclose(sort_results(reduced), sort_results(full))
@@ -0,0 +1,45 @@
+import libmist as pld
+import numpy as np
+import pytest
+
+# The Search uses ndarray data without copying, so the arrays are kept alive
+# for as long as the Search.
+
+def random_data(nrow, nvar, seed):
+    rng = np.random.default_rng(seed)
+    return np.asfortranarray(rng.integers(0, 3, size=(nrow, nvar)).astype('int8'))
+
+def sort_results(res):
+    return res[np.lexsort(res[:,:3].T[::-1])]
+
+def fresh_results(data):
+    rows = np.asfortranarray(data)
+    mist = pld.Search()
+    mist.load_ndarray(rows)
+    mist.tuple_size = 3
+    return sort_results(mist.start())
+
+@pytest.mark.parametrize("incremental", [False, True])
+def test_update_samples(incremental):
+    data = random_data(300, 8, 1)
+    parts = [np.asfortranarray(data[ii:ii + 50]) for ii in range(0, 300, 50)]
+    window = np.asfortranarray(data[:100])
+
+    mist = pld.Search()
+    mist.incremental = incremental
+    mist.load_ndarray(window)
+    mist.tuple_size = 3
+    mist.start()
+
+    mist.add_samples(pld.DataMatrix(parts[2]))
+    np.testing.assert_allclose(sort_results(mist.start()), fresh_results(data[:150]))
+
+    mist.remove_samples(30)
+    np.testing.assert_allclose(sort_results(mist.start()), fresh_results(data[30:150]))
+
+    # slide repeatedly, so rows are appended in place after the first copy
+    for ii in range(3, 6):
+        mist.slide_samples(pld.DataMatrix(parts[ii]))
+        begin = ii * 50
+        np.testing.assert_allclose(sort_results(mist.start()),
+                                   fresh_results(data[begin - 70:begin + 50]))
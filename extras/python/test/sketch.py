@@ -0,0 +1,50 @@
+import libmist as pld
+import numpy as np
+import pytest
+
+# The Search uses ndarray data without copying, so the arrays are kept alive
+# for as long as the Search.
+
+def random_data(nrow, nvar, seed):
+    rng = np.random.default_rng(seed)
+    return np.asfortranarray(rng.integers(0, 3, size=(nrow, nvar)).astype('int8'))
+
+def test_estimate_cutoff():
+    data = random_data(200, 40, 1)
+    mist = pld.Search()
+    mist.load_ndarray(data)
+    mist.tuple_size = 3
+    full = mist.start()
+
+    # a sample of all tuples sketches the values of a plain search
+    cutoff = mist.estimate_cutoff(0.1, len(full), 0)
+    assert(mist.cutoff == cutoff)
+    expected = np.quantile(full[:,-1], 0.9)
+    assert(abs(cutoff - expected) <= 0.02 * abs(expected))
+    kept = mist.start()
+    assert(abs(len(kept) / len(full) - 0.1) < 0.02)
+    np.testing.assert_allclose(kept, full[full[:,-1] >= cutoff])
+
+    # other settings of the Search do not change the sampled search
+    mist.cutoff = -np.inf
+    mist.set_bootstrap(20, 0.9, 1)
+    assert(mist.estimate_cutoff(0.1, len(full), 0) == cutoff)
+
+    # a sample of the tuples keeps about the fraction
+    sampled = mist.estimate_cutoff(0.1, 2000, 1)
+    kept = full[full[:,-1] >= sampled]
+    assert(abs(len(kept) / len(full) - 0.1) < 0.03)
+
+def test_estimate_cutoff_pair_matrix():
+    data = random_data(200, 40, 2)
+    mist = pld.Search()
+    mist.load_ndarray(data)
+    mist.tuple_size = 2
+    full = mist.start()
+
+    mist.pair_matrix = True
+    cutoff = mist.estimate_cutoff(0.1, len(full), 0)
+    mist.start()
+    values = mist.get_pair_matrix()[0]
+    kept = full[full[:,-1] >= cutoff]
+    assert(np.count_nonzero(~np.isnan(values)) == len(kept))
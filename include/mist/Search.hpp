@@ -1,7 +1,11 @@
 #pragma once
 
+#include "io/BatchOutputStream.hpp"
+#include "io/ColumnOutputStream.hpp"
 #include "io/DataMatrix.hpp"
 #include "io/MapOutputStream.hpp"
+#include "io/PairMatrixOutputStream.hpp"
+#include "io/SketchOutputStream.hpp"
 #include "it/Entropy.hpp"
 #include <memory>
 #include <stdexcept>
@@ -42,8 +46,42 @@ private:
   // std::experimental::propagate_const<std::unique_ptr<impl>> pimpl;
   std::unique_ptr<impl> pimpl;
 
+  struct chunk_type;
+
+  void _start(chunk_type* chunk);
   void init_caches();
+  void init_count_caches();
+  void publish_top_k();
+  void _update_samples(io::DataMatrix* samples, std::size_t remove);
   void _load_file(std::string const& filename, bool is_row_major);
+  std::size_t count_search_tuples();
+  std::shared_ptr<it::Measure> search_measure();
+  std::shared_ptr<algorithm::VariableReduction> variable_reduction();
+  void finish_batches();
+  std::vector<std::shared_ptr<io::OutputStream>> configure_result_outputs(
+    std::shared_ptr<it::Measure> const& measure,
+    int tuple_size,
+    bool permuting,
+    bool expanding,
+    bool in_memory_output,
+    bool delta,
+    int ranks,
+    std::size_t begin,
+    std::size_t end);
+  void join_result_outputs(bool delta);
+  std::vector<std::shared_ptr<io::OutputStream>> configure_column_output(
+    std::shared_ptr<it::Measure> const& measure,
+    int tuple_size,
+    bool permuting,
+    bool expanding,
+    int ranks,
+    std::size_t begin,
+    std::size_t end);
+  std::shared_ptr<io::PairMatrixOutputStream> configure_pair_matrix(
+    std::shared_ptr<it::Measure> const& measure,
+    int tuple_size,
+    bool permuting,
+    std::shared_ptr<io::PairMatrixOutputStream> const& prior);
 
 public:
   Search();
@@ -65,14 +103,46 @@ public:
   void set_measure(std::string const& measure);
   std::string get_measure();
 
+  /** Set several IT Measures to be computed in the same search.
+   *
+   * All measures are computed from the same entropies, so each probability
+   * distribution is counted once. The output has the final value of each
+   * measure in list order, preceded by the sub calculations of each measure
+   * with output_intermediate. The last measure is the one compared against
+   * the cutoff and used for top-K results. set_measure also accepts a
+   * comma-separated list.
+   */
+  void set_measures(std::vector<std::string> const& measures);
+
   /** Set the minimum IT Measure value to keep in results.
    *
    * This option is most useful for dealing with very large TupleSpaces, the
    * results for which cannot be stored in memory or on disk.
+   *
+   * For data without missing values, tuples whose measure is bounded below
+   * the cutoff by their sub-tuple entropies are skipped before the full joint
+   * entropy is computed (see it::Measure::upper_bound).
    */
   void set_cutoff(it::entropy_type cutoff);
   it::entropy_type get_cutoff();
 
+  /** Set a screen to prune tuples of size 3 and 4 by their leading pair.
+   *
+   * Before the tuples starting with a variable pair are computed, the pair
+   * entropies (from the 2D cache when available) are checked against the
+   * screen. If the pair fails, all tuples starting with it are skipped. The
+   * leading pair are the first two positions of the tuple, i.e. of the
+   * variable group tuple for custom search spaces. Only applies to measures
+   * that use intermediate entropies, e.g. SymmetricDelta.
+   *
+   * - None (default) : No screening
+   * - MutualInformation : Pass pairs with I(0;1) >= threshold
+   * - JointEntropy : Pass pairs with H(0,1) >= threshold
+   */
+  void set_screen(std::string const& screen, it::entropy_type threshold);
+  std::string get_screen();
+  it::entropy_type get_screen_threshold();
+
   /** Set the algorithm for generating probability distributions.
    *
    * - Vector (default) : Process each Variable as a vector. Gives best
@@ -95,6 +165,58 @@ public:
   void set_outfile(std::string const& filename);
   std::string get_outfile();
 
+  /** Set the format of the output file.
+   *
+   * - csv (default) : text, one row per tuple with a header of column names.
+   * - binary : fixed-width records of uint32 variable indexes and float64
+   *   values after a header describing them, see io::BinaryOutputStream.
+   * - binary32 : as binary with float32 values.
+   *
+   * Binary records are copied into the write buffer without formatting, for
+   * searches where writing text costs more than computing the results.
+   */
+  void set_output_format(std::string const& format);
+  std::string get_output_format();
+
+  /** Write the output of each thread to a shard file of its own, so
+   * threads never wait on each other to write.
+   *
+   * Thread i writes the file outfile.shard<i>, with the header, for its
+   * range of tuples. A manifest, outfile.manifest, lists the tuple range
+   * and byte range of each shard in the format of start_coordinator. With
+   * merge, the shards are concatenated in tuple order into the outfile by
+   * all threads after the search, then removed. Cannot be used with
+   * checkpoints, top-K results or start_worker.
+   *
+   * @param enabled whether to write shards
+   * @param merge whether to merge the shards into the outfile
+   */
+  void set_output_shards(bool enabled, bool merge = false);
+  bool get_output_shards();
+
+  /** Write the output file in tuple order, the same for any number of
+   * threads.
+   *
+   * The threads take blocks of tuples in order and a writer thread writes
+   * the results of each block in order, holding at most a few blocks per
+   * thread that finish early. Threads that get too far ahead wait for the
+   * writer. Cannot be used with checkpoints, top-K results, output shards
+   * or start_worker.
+   */
+  void set_ordered_output(bool enabled);
+  bool get_ordered_output();
+
+  /** Merge the shards listed in a manifest, from output shards or
+   * start_coordinator, into one file in tuple order.
+   */
+  void merge_shards(std::string const& manifest, std::string const& outfile);
+
+  /** Set the significant digits of values in CSV output, 6 by default. 0
+   * writes the fewest digits that read back as the same value.
+   */
+  void set_output_precision(int digits);
+  int get_output_precision();
+
   /** Set number of concurrent ranks to use in this Search.
    *
    * A rank on a computation node is one execution thread. The default ranks
@@ -146,6 +268,182 @@ public:
   void set_tuple_limit(long limit);
   long get_tuple_limit();
 
+  /** Periodically save the progress of the search to a checkpoint file.
+   *
+   * Every interval_seconds, all ranks pause, flush their output to the
+   * outfile, and the position of each rank and the size of the outfile are
+   * saved. An interrupted search is continued with resume. The checkpoint
+   * file is removed when the search completes. Requires an outfile.
+   */
+  void set_checkpoint(std::string const& filename, int interval_seconds);
+  std::string get_checkpoint();
+
+  /** Continue an interrupted search from a checkpoint file.
+   *
+   * The Search must be configured with the same data, TupleSpace, and
+   * measure as the interrupted search; the ranks, start_rank, total_ranks,
+   * and outfile are taken from the checkpoint. Output written after the
+   * checkpoint is discarded, so the outfile holds the same results as an
+   * uninterrupted run.
+   */
+  void resume(std::string const& checkpoint);
+
+  /** Keep only the K results with the largest measure value. The default is
+   * 0, meaning keep all results.
+   *
+   * Each rank keeps its own fixed-size heap and raises its cutoff to the
+   * K-th best value seen so far. Heaps are merged at the end of the search
+   * and the results, sorted best first, are written to the outfile. Top-K
+   * results are always kept in memory, even when writing to an outfile.
+   */
+  void set_top_k(long k);
+  long get_top_k();
+
+  /** Keep a histogram of the results of each search, to pick a cutoff
+   * without keeping all the results.
+   *
+   * Each rank sketches the final result column of the tuples it outputs,
+   * in memory that does not depend on the number of tuples, and the
+   * sketches are merged at the end of the search. With a cutoff or top-K
+   * results only the tuples that pass are sketched. Read the merged sketch
+   * with get_result_sketch.
+   *
+   * @param accuracy relative error of the quantiles of the sketch
+   */
+  void set_result_sketch(bool enabled,
+                         double accuracy = io::SketchOutputStream::ACCURACY_DEFAULT);
+  bool get_result_sketch_enabled();
+
+  /** Set the cutoff that keeps about top_fraction of the tuples, estimated
+   * by searching a random sample of the tuples first.
+   *
+   * The sample is drawn from the TupleSpace set with set_tuple_space, or
+   * all tuples of the data, and searched by a new Search of the same data,
+   * measure, tuple size and ranks, without any output. The configuration
+   * of this Search is not changed other than the cutoff.
+   *
+   * @param top_fraction fraction of the tuples to keep, between 0 and 1
+   * @param sample_tuples number of tuples to sample, all tuples when there
+   *        are not more
+   * @param seed random number generator seed
+   * @return the cutoff
+   */
+  it::entropy_type estimate_cutoff(double top_fraction,
+                                   std::size_t sample_tuples,
+                                   unsigned seed = 0);
+
+  /** Test each tuple against a null distribution made by permuting the
+   * samples of some variables, e.g. a phenotype.
+   *
+   * The same n random permutations are applied to all listed variables
+   * together. For each output tuple, the number of permutations whose
+   * measure value is at least the observed value is appended to its output
+   * as the column "exceedances"; (exceedances + 1) / (n + 1) is the
+   * permutation p-value. Only the entropies of sub-tuples with a permuted
+   * variable are recounted for each permutation. Unless a TupleSpace is set,
+   * only tuples with a permuted variable are searched, each with its
+   * permuted variables last, e.g. (1,2,0) when variable 0 is permuted; sort
+   * the tuple columns to match the rows of a full search. Tuples below the
+   * cutoff are not tested. Cannot be used with top-K results. Set n to 0 to
+   * turn permutation tests off.
+   *
+   * @param n number of permutations
+   * @param variables indexes of the variables to permute
+   * @param seed random number generator seed
+   */
+  void set_permutations(std::size_t n,
+                        Variable::indexes const& variables,
+                        unsigned seed = 0);
+  std::size_t get_permutations();
+
+  /** Evaluate the measure separately on the samples of each stratum, e.g.
+   * cases and controls, as if each were searched on its own.
+   *
+   * A data column holds the stratum label of each sample and is taken out of
+   * the variables, so variables after it move down one index. The joint
+   * counts of all strata are made in one pass over the samples. Output has
+   * the measure of each stratum, in label order, and optionally the
+   * difference of each from stratum 0. The last output value is compared
+   * against the cutoff and ranked for top-K results. Set again after loading
+   * new data. Cannot be used with permutation tests or sample updates.
+   *
+   * @param column data column with the stratum labels
+   * @param differences whether to output differences from stratum 0
+   */
+  void set_strata(int column, bool differences = false);
+  /** Strata column of the loaded data, -1 if none
+   */
+  int get_strata();
+
+  /** Collapse identical samples into one counted by its multiplicity, when
+   * data is loaded or now if data is already loaded.
+   *
+   * Entropies are unchanged while every count scans only the unique
+   * samples, which pays off for data with few bins where whole samples
+   * repeat. Uses the vector probability algorithm. Cannot be used with
+   * permutation tests, bootstrap replicates, incremental mode, or sample and
+   * variable updates. Turning it off applies to data loaded later.
+   */
+  void set_deduplicate(bool enabled);
+  bool get_deduplicate();
+
+  /** Remap the values of each variable to contiguous bins from 0 when data
+   * is loaded, or now if data is already loaded.
+   *
+   * Distributions are sized by the largest value of each variable, so
+   * sparsely coded values, e.g. {0,7}, leave most cells empty. Compacting
+   * keeps the order of the values and sizes each variable by the values
+   * that occur. Entropies are unchanged. Cannot be used with sample and
+   * variable updates. Turning it off applies to data loaded later.
+   */
+  void set_compact_bins(bool enabled);
+  bool get_compact_bins();
+  /** Value in the loaded data of each bin of a variable
+   */
+  std::vector<int> get_bin_values(int variable);
+
+  /** Leave constant and duplicate variables out of the search.
+   *
+   * Before the search the variable columns are hashed in parallel. A
+   * variable with the same value in every sample, and none missing, is
+   * constant and tuples with it are not searched. Variables with equal
+   * columns are duplicates of the first of them, their representative, and
+   * only tuples of representatives are searched. The results of tuples with
+   * duplicates are copies of the representative's tuple, output with the
+   * variables in increasing order as the full search would, unless
+   * expansion is off. With intermediate output the duplicates keep the
+   * representative's positions, which the intermediate values follow.
+   * Tuples with more than one variable of the same class are not output.
+   * Only applies to the complete TupleSpace, not to a set TupleSpace,
+   * appended variables, or permutation tests.
+   *
+   * @param enabled whether to reduce the variables
+   * @param expand_duplicates whether to output the tuples with duplicates
+   */
+  void set_reduce_variables(bool enabled, bool expand_duplicates = true);
+  bool get_reduce_variables();
+
+  /** Estimate confidence intervals of the measure of each tuple by Poisson
+   * bootstrap.
+   *
+   * Each replicate weights every sample by a Poisson(1) count, made from the
+   * seed so replicates are the same in every run. All replicates of a tuple
+   * are counted in one pass over its variables, without copies of the data.
+   * Output has the mean and the percentile interval bounds of the measure
+   * over the replicates, columns suffixed "_mean", "_lo" and "_hi", then the
+   * measure on the data, which is compared against the cutoff. Cannot be
+   * used with strata or permutation tests. Set replicates to 0 to turn the
+   * bootstrap off.
+   *
+   * @param replicates number of bootstrap replicates
+   * @param confidence confidence level of the interval
+   * @param seed random number generator seed
+   */
+  void set_bootstrap(std::size_t replicates,
+                     double confidence = 0.95,
+                     unsigned seed = 0);
+  std::size_t get_bootstrap();
+
   /** Toggle whether to write program progress to stderr.
    *
    * When true, an extra thread will be made to watch progress through the
@@ -184,7 +482,58 @@ public:
   void load_file_row_major(std::string const& filename);
   void load_file_column_major(std::string const& filename);
 
+  /** Append variables (columns) to the loaded data.
+   *
+   * If the last search covered the default TupleSpace of the loaded data,
+   * the next start() only searches the tuples that contain at least one of
+   * the appended variables, and reuses the cached entropies of the other
+   * variables. Results of the previous search remain valid for the old
+   * tuples; top-K results are merged with the previous ones.
+   *
+   * @param columns the same number of samples as the loaded data
+   */
+  void append_variables(io::DataMatrix& columns);
+
+  /** Keep integer count tables between searches so the data can be updated.
+   *
+   * In incremental mode the intermediate entropy caches are made from count
+   * tables for each sub-tuple. When samples are added or removed, only the
+   * changed rows are counted, and the next start() re-derives the entropies
+   * from the updated tables. Requires a measure that uses intermediate
+   * entropies, such as SymmetricDelta.
+   */
+  void set_incremental(bool enabled);
+  bool get_incremental();
+
+  /** Also keep count tables for every tuple in the search space.
+   *
+   * Then a search after an update costs time proportional to the number of
+   * changed rows, at the cost of a count table per tuple in memory. Only
+   * practical for small search spaces.
+   */
+  void set_incremental_results(bool enabled);
+  bool get_incremental_results();
+
+  /** Append samples to the loaded data.
+   *
+   * @param samples the same variables as the loaded data, with values within
+   *        the bins of the loaded data
+   */
+  void add_samples(io::DataMatrix& samples);
+  /** Remove the n oldest samples from the loaded data.
+   */
+  void remove_samples(std::size_t n);
+  /** Slide the sample window, appending samples and removing the same
+   * number of the oldest samples.
+   */
+  void slide_samples(io::DataMatrix& samples);
+
 #if BOOST_PYTHON_EXTENSIONS
+  void python_set_permutations(std::size_t n,
+                               p::list const& variables,
+                               unsigned seed);
+  p::list python_get_bin_values(int variable);
+
   /** Load Data from Python Numpy::ndarray.
    *
    * Data is loaded into the library following a zero-copy guarantee.
@@ -198,6 +547,19 @@ public:
    */
   np::ndarray python_get_results();
 
+  /** Return a dict of the compact result columns by name, each a Numpy
+   * array of the column's dtype.
+   */
+  p::dict python_get_compact_results();
+  std::shared_ptr<io::BatchQueue> python_start_batches(std::size_t batch_rows);
+  std::shared_ptr<io::SketchOutputStream> python_get_result_sketch();
+  /** Return the planes of the pair matrix as a planes x pairs Numpy array,
+   * without a copy.
+   */
+  np::ndarray python_get_pair_matrix();
+  p::list python_get_pair_matrix_names();
+  p::list python_decode_tuple(std::size_t tuple_no);
+
   /** Start search.
    *
    * Compute the configured IT measure for all Variable tuples in the
@@ -213,10 +575,146 @@ public:
    */
   void start();
 
+  /** Hand out the configured search to worker processes.
+   *
+   * Listens on a Unix domain socket and gives chunks of the TupleSpace to
+   * workers started with start_worker, until every tuple has been searched.
+   * Chunks are sized from the measured throughput of each worker, and the
+   * chunk of a worker that dies is given to another. This Search does not
+   * compute anything itself, it only needs the same data and configuration
+   * as the workers.
+   *
+   * @param socket_path path of the socket file
+   * @param manifest if not empty, file to write the shard and byte range of
+   *        each chunk to. The concatenation of the byte ranges in manifest
+   *        order is the output of a single-process search, without header.
+   */
+  void start_coordinator(std::string const& socket_path,
+                         std::string const& manifest = "");
+
+  /** Search chunks handed out by a coordinator until it is done.
+   *
+   * Results are written to a shard file, the outfile name suffixed with the
+   * process id. Requires an outfile; cannot be used with top-K results or
+   * checkpoints.
+   */
+  void start_worker(std::string const& socket_path);
+
   /** Return a copy of all results
    */
   std::vector<it::entropy_type> const& get_results();
 
+  /** Start the search in a background thread and hand over its results in
+   * batches while it runs.
+   *
+   * Each thread of the search collects rows, the tuple then the values as
+   * in get_results, and hands them over batch_rows at a time. Take the
+   * batches with BatchQueue::pop until it returns false; it throws the
+   * exception of a failed search. At most max_batches wait in the queue, 2
+   * per thread for 0, and the search waits while the queue is full. Batches
+   * of different threads arrive in no particular order. The results are not
+   * kept in memory. Do not use this Search until the queue is done;
+   * starting another search, or moving or destroying the Search, drops the
+   * remaining batches and waits for the search to finish.
+   * Cannot be used with top-K results.
+   */
+  std::shared_ptr<io::BatchQueue> start_batches(std::size_t batch_rows,
+                                                std::size_t max_batches = 0);
+
+  /** Map the in-memory results from a file instead of allocating them.
+   *
+   * The results of a search without a cutoff are written in place to the
+   * file, created or truncated to the size of all results, and paged out by
+   * the kernel, so they can be larger than memory. The file holds the rows
+   * of doubles with no header, as the array of get_results, and can be opened
+   * with numpy.memmap. The mapped results are read from Python as usual; from
+   * C++ read the file, get_results throws. An empty filename allocates the
+   * results in memory again. Cannot be used with a cutoff, screen, duplicate
+   * expansion or compact results.
+   */
+  void set_results_map_file(std::string const& filename);
+  std::string get_results_map_file();
+
+  /** Keep in-memory results as typed columns instead of rows of doubles.
+   *
+   * The tuple is stored as uint32 variable index columns, or with
+   * tuple_numbers as a single uint64 column of the tuple number, which
+   * decode_tuple turns back into variable indexes. Value columns are float32
+   * or float64 as given by value_types, a comma-separated list with one type
+   * for every value column or a single type for all of them. With compact
+   * results, get_results is empty; read them with get_compact_results.
+   * Top-K results are always kept as rows.
+   *
+   * @param enabled whether to keep compact results
+   * @param value_types "float32" or "float64" for each value column
+   * @param tuple_numbers store the tuple number instead of the variables
+   * @exception SearchException unknown value type
+   */
+  void set_compact_results(bool enabled,
+                           std::string const& value_types = "float64",
+                           bool tuple_numbers = false);
+  bool get_compact_results_enabled();
+
+  /** Compact results of the last search
+   * @exception SearchException no compact results in memory
+   */
+  io::ColumnOutputStream const& get_compact_results();
+  /** Names of the compact result columns, "tuple_no" for tuple numbers
+   */
+  std::vector<std::string> const& get_compact_result_names();
+  /** Variable indexes of a tuple number of the last search
+   */
+  Variable::indexes decode_tuple(std::size_t tuple_no);
+
+  /** Keep the in-memory results of a search of pairs as packed triangular
+   * matrices instead of rows.
+   *
+   * Each value column is a plane of nvar * (nvar - 1) / 2 doubles in the
+   * order of cache::Flat2D, with NaN for pairs without a result. Output
+   * intermediate values to also get the sub-entropy planes. With a results
+   * map file the planes are mapped from that file. With a pair matrix,
+   * get_results is empty; read the planes with get_pair_matrix. Requires a
+   * tuple size of 2, and cannot be used with compact results, top-K results
+   * or result batches.
+   */
+  void set_pair_matrix(bool enabled);
+  bool get_pair_matrix_enabled();
+
+  /** Pair matrix of the last search
+   * @exception SearchException no pair matrix in memory
+   */
+  io::PairMatrixOutputStream const& get_pair_matrix();
+  /** Names of the planes of the pair matrix
+   */
+  std::vector<std::string> const& get_pair_matrix_names();
+
+  /** Save the top-K results of the last search to a binary file.
+   *
+   * Used to combine the results of a parallel search over multiple nodes:
+   * each node saves its results and one node merges them with merge_top_k.
+   */
+  void save_top_k(std::string const& filename);
+
+  /** Merge top-K results saved by another Search into the results of this
+   * Search. The in-memory results are updated.
+   */
+  void merge_top_k(std::string const& filename);
+
+  /** Result sketch of the last search
+   * @exception SearchException no sketch, use set_result_sketch and start
+   */
+  io::SketchOutputStream const& get_result_sketch();
+
+  /** Save the result sketch of the last search to a binary file, to be
+   * merged into the sketch of another node with merge_result_sketch.
+   */
+  void save_result_sketch(std::string const& filename);
+
+  /** Merge a result sketch saved by another Search into the sketch of
+   * this Search.
+   */
+  void merge_result_sketch(std::string const& filename);
+
   /** Print cache statistics for each cache in each thread to stdout.
    */
   void printCacheStats();
@@ -0,0 +1,4 @@
+#ifndef VERSION_HPP
+#define VERSION_HPP
+#define MIST_VERSION "1.3.0"
+#endif
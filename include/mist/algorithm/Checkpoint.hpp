@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "io/OutputStream.hpp"
+
+namespace mist {
+namespace algorithm {
+
+/** Coordinates Workers so a consistent snapshot of their progress can be
+ * taken while a Search is running.
+ *
+ * The coordinator requests a pause, and each Worker stops at its next tuple,
+ * flushes its output streams, and records the number of the next tuple it
+ * will process. Once all Workers are paused or finished, every tuple before
+ * the recorded positions has been written out, and the coordinator can save
+ * the positions before releasing the Workers.
+ */
+class Checkpoint
+{
+public:
+  using count_t = std::uint64_t;
+  using output_stream_ptr = std::shared_ptr<io::OutputStream>;
+
+  /** Saved state of a Search, see write_file and read_file.
+   */
+  struct state
+  {
+    count_t tuple_count = 0;
+    int total_ranks = 0;
+    int start_rank = 0;
+    std::string outfile;
+    // durable size of the output file
+    count_t offset = 0;
+    // per Worker [next tuple, stop tuple)
+    std::vector<count_t> next;
+    std::vector<count_t> stop;
+  };
+
+  Checkpoint(std::size_t nworkers);
+
+  //
+  // Worker side
+  //
+
+  /** Whether the coordinator has requested a pause
+   */
+  bool requested() const { return flag.load(std::memory_order_relaxed); };
+  /** Flush streams, record position, and block until released.
+   */
+  void pause(std::size_t worker,
+             count_t next,
+             std::vector<output_stream_ptr> const& streams);
+  /** Flush streams and record that the Worker has processed all of its
+   * tuples.
+   */
+  void finish(std::size_t worker,
+              count_t next,
+              std::vector<output_stream_ptr> const& streams);
+
+  //
+  // Coordinator side
+  //
+
+  /** Wait until the interval has passed or all Workers have finished.
+   * @return true if all Workers have finished
+   */
+  bool wait_done(std::chrono::seconds interval);
+  /** Request all Workers to pause and block until they have.
+   * @return position of the next tuple for each Worker
+   */
+  std::vector<count_t> pause_all();
+  /** Release paused Workers
+   */
+  void release();
+
+  /** Write state to file, replacing the file atomically.
+   */
+  static void write_file(std::string const& filename, state const& s);
+  static state read_file(std::string const& filename);
+
+private:
+  std::atomic<bool> flag;
+  std::mutex m;
+  std::condition_variable cv;
+  std::size_t nworkers;
+  std::size_t npaused = 0;
+  std::size_t nfinished = 0;
+  std::uint64_t generation = 0;
+  std::vector<count_t> positions;
+};
+
+class CheckpointException : public std::exception
+{
+private:
+  std::string msg;
+
+public:
+  CheckpointException(std::string const& method, std::string const& msg)
+    : msg("Checkpoint::" + method + " : " + msg)
+  {}
+  virtual const char* what() const throw() { return msg.c_str(); };
+};
+
+} // namespace algorithm
+} // namespace mist
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace mist {
+namespace algorithm {
+
+/** Hands out chunks of a TupleSpace to worker processes over a Unix domain
+ * socket.
+ *
+ * Workers connect with a CoordinatorClient, say hello with the size of their
+ * TupleSpace and the name of their output shard, then repeatedly ask for the
+ * next chunk of tuples and report it back when the results are written. The
+ * size of each chunk follows the measured throughput of the worker so every
+ * chunk takes about the same time, and shrinks towards the end of the search
+ * so workers finish together. Chunks held by a worker that disconnects, or
+ * that exceed the lease time, are handed out again.
+ *
+ * Protocol, one line per message:
+ *   worker: HELLO tuple_count shard
+ *   worker: NEXT                     coordinator: CHUNK start stop | DONE
+ *   worker: REPORT start stop seconds begin end
+ * where [begin,end) is the byte range of the chunk results in the shard.
+ */
+class Coordinator
+{
+public:
+  using count_t = std::uint64_t;
+
+  /** Completed chunk, results are bytes [begin,end) of the shard file
+   */
+  struct chunk
+  {
+    count_t start;
+    count_t stop;
+    count_t begin;
+    count_t end;
+    std::string shard;
+  };
+
+  /** Listen on socket_path, replacing any stale socket file.
+   * @exception CoordinatorException socket error
+   */
+  Coordinator(std::string const& socket_path, count_t tuple_count);
+  ~Coordinator();
+
+  /** Target duration of a chunk in seconds.
+   */
+  void set_chunk_seconds(double seconds);
+  /** Smallest chunk handed out, in tuples.
+   */
+  void set_min_chunk(count_t tuples);
+  /** Reassign a chunk that is not reported within this many seconds, zero to
+   * wait indefinitely for live workers.
+   */
+  void set_lease_seconds(double seconds);
+
+  /** Serve workers until every tuple has been reported.
+   */
+  void run();
+
+  std::vector<chunk> const& completed() const;
+
+  /** Write the output shards and the byte ranges of each completed chunk.
+   */
+  void write_manifest(std::string const& filename) const;
+  /** Write a manifest of chunks written by other means, e.g. the shards of
+   * the threads of one Search.
+   */
+  static void write_manifest(std::string const& filename,
+                             count_t tuple_count,
+                             std::vector<chunk> chunks);
+  static std::vector<chunk> read_manifest(std::string const& filename);
+
+  /** Concatenate the chunks of a manifest in tuple order into one file,
+   * preceded by the header of the first shard, i.e. its bytes before its
+   * first chunk. Each thread copies whole chunks to their final offsets.
+   * @return size of the merged file
+   * @exception CoordinatorException file error
+   */
+  static count_t merge_manifest(std::string const& manifest,
+                                std::string const& outfile,
+                                std::size_t threads = 1);
+
+private:
+  using clock = std::chrono::steady_clock;
+  struct peer
+  {
+    int fd;
+    std::string buffer;
+    std::string shard;
+    bool hello = false;
+    bool waiting = false;
+    bool busy = false;
+    count_t start = 0;
+    count_t stop = 0;
+    clock::time_point assigned;
+    double throughput = 0;
+  };
+
+  std::string socket_path;
+  int listen_fd = -1;
+  count_t tuple_count;
+  double chunk_seconds = 10;
+  count_t min_chunk = 1;
+  double lease_seconds = 0;
+  std::deque<std::pair<count_t, count_t>> pending;
+  count_t pending_tuples = 0;
+  std::vector<peer> peers;
+  std::vector<chunk> done;
+  count_t done_tuples = 0;
+
+  count_t chunk_size(peer const& p) const;
+  bool assign(peer& p);
+  void requeue(peer& p);
+  bool handle(peer& p, std::string const& line);
+  void drop(std::size_t index);
+};
+
+/** Worker side of the Coordinator protocol.
+ */
+class CoordinatorClient
+{
+public:
+  using count_t = Coordinator::count_t;
+
+  /** Connect, retrying until the coordinator is listening.
+   * @exception CoordinatorException could not connect within timeout
+   */
+  CoordinatorClient(std::string const& socket_path, double timeout_seconds = 60);
+  ~CoordinatorClient();
+
+  void hello(count_t tuple_count, std::string const& shard);
+  /** Ask for the next chunk.
+   * @return false when there are no more chunks
+   */
+  bool next(count_t& start, count_t& stop);
+  void report(count_t start,
+              count_t stop,
+              double seconds,
+              count_t begin,
+              count_t end);
+
+private:
+  int fd = -1;
+  std::string buffer;
+
+  void send(std::string const& line);
+  std::string receive();
+};
+
+class CoordinatorException : public std::exception
+{
+private:
+  std::string msg;
+
+public:
+  CoordinatorException(std::string const& method, std::string const& msg)
+    : msg("Coordinator::" + method + " : " + msg)
+  {}
+  virtual const char* what() const throw() { return msg.c_str(); };
+};
+
+} // namespace algorithm
+} // namespace mist
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "Variable.hpp"
+#include "it/Entropy.hpp"
+#include "it/EntropyCalculator.hpp"
+#include "it/Measure.hpp"
+
+namespace mist {
+namespace algorithm {
+
+/** Null distribution of a measure by permuting designated variables.
+ *
+ * Makes n random permutations of the samples and applies each to all
+ * permuted variables together, e.g. a phenotype. The permuted copies are
+ * appended after the original variables, so an EntropyCalculator over
+ * variables() counts them like any other variable. For each tuple only the
+ * entropies of sub-tuples with a permuted variable are recounted; the
+ * others, and the entropy of each single variable, do not change under
+ * permutation.
+ */
+class PermutationTest
+{
+public:
+  using tuple_t = Variable::indexes;
+  using variables_ptr = std::shared_ptr<Variable::tuple>;
+  using count_t = std::size_t;
+
+  /** Buffers for exceedances, one per thread
+   */
+  struct workspace
+  {
+    tuple_t mapped;
+    tuple_t sub;
+    it::Entropy entropy;
+    it::Measure::result_type result;
+  };
+
+  /**
+   * @param vars variables of the search
+   * @param permuted indexes of the variables to permute
+   * @param n number of permutations
+   * @param seed random number generator seed
+   * @exception PermutationTestException permuted variable out of range
+   */
+  PermutationTest(variables_ptr const& vars,
+                  tuple_t const& permuted,
+                  count_t n,
+                  unsigned seed);
+
+  count_t size() const { return n; };
+
+  /** Original variables followed by the permuted copies
+   */
+  variables_ptr const& variables() const { return vars; };
+
+  /** Whether the tuple has a permuted variable
+   */
+  bool involved(tuple_t const& tuple) const;
+
+  /** Count the permutations whose measure value is at least the observed
+   * value. Tuples without a permuted variable tie on every permutation.
+   *
+   * @param calc calculator over variables()
+   * @param e entropies of the tuple in the it::d layout, or null to count
+   *        all entropies
+   */
+  count_t exceedances(it::Measure const& measure,
+                      it::EntropyCalculator& calc,
+                      tuple_t const& tuple,
+                      it::Entropy const* e,
+                      it::entropy_type observed,
+                      workspace& ws) const;
+
+private:
+  variables_ptr vars;
+  count_t n;
+  std::size_t nvar;
+  std::size_t npermuted;
+  // position among the permuted variables, or -1
+  std::vector<int> slot;
+  // sub-tuple positions in the it::d layout for each tuple size
+  std::vector<std::vector<tuple_t>> subs;
+
+  void map(tuple_t const& tuple, count_t k, tuple_t& out) const;
+};
+
+class PermutationTestException : public std::exception
+{
+private:
+  std::string msg;
+
+public:
+  PermutationTestException(std::string const& method, std::string const& msg)
+    : msg("PermutationTest::" + method + " : " + msg)
+  {}
+  virtual const char* what() const throw() { return msg.c_str(); };
+};
+
+} // namespace algorithm
+} // namespace mist
@@ -13,6 +13,7 @@ namespace p = boost::python;
 
 #include "../Variable.hpp"
 #include "it/EntropyCalculator.hpp"
+#include "py.hpp"
 
 namespace mist {
 
@@ -30,6 +31,39 @@ public:
   virtual void process_tuple(count_t tuple_no, tuple_t const& tuple) = 0;
   virtual void process_tuple_entropy(
       count_t tuple_no, tuple_t const& tuple, it::Entropy const& e) = 0;
+  /** Screen the leading variable pair of the tuples about to be generated.
+   *
+   * Called by the entropy traversals for tuples of size 3 and 4. Returning
+   * false prunes every tuple that starts with the pair.
+   *
+   * @return true if tuples starting with prefix should be processed
+   */
+  virtual bool process_prefix(tuple_t const& prefix,
+                              it::entropy_type e0,
+                              it::entropy_type e1,
+                              it::entropy_type e01)
+  {
+    return true;
+  };
+  /** Notification that n tuples starting at tuple_no were pruned and will
+   * not be processed.
+   */
+  virtual void skip_tuples(count_t tuple_no, count_t n){};
+  /** Inspect a tuple before its full joint entropy is computed.
+   *
+   * Called by the entropy traversals for tuples of size 3 and 4 with every
+   * sub-tuple entropy filled in except the last, the full joint entropy.
+   * Returning false skips the tuple, it is not passed to
+   * process_tuple_entropy.
+   *
+   * @return true if the tuple should be processed
+   */
+  virtual bool process_partial(count_t tuple_no,
+                               tuple_t const& tuple,
+                               it::Entropy const& e)
+  {
+    return true;
+  };
 };
 
 /** Tuple Space defines the set of tuples over which to run a computation
@@ -43,6 +77,13 @@ public:
   using count_t = std::uint64_t;
   TupleSpace();
   TupleSpace(int N, int d);
+  /** Delta space for N_new variables appended after N_old variables.
+   *
+   * Holds the tuples of TupleSpace(N_old + N_new, d) that contain at least
+   * one of the appended variables, i.e. the tuples that were not in
+   * TupleSpace(N_old, d).
+   */
+  TupleSpace(int N_old, int N_new, int d);
   ~TupleSpace();
   /** Define a named logical group of variables
    * @param name group name
@@ -72,6 +113,50 @@ public:
    * @throws TupleSpaceException group index out of range
    */
   void addVariableGroupTuple(tuple_t const& groups);
+  /** Add an explicit variable tuple
+   *
+   * A TupleSpace is either defined by variable groups or by an explicit list
+   * of tuples, the two cannot be mixed. Variables within the tuple are sorted
+   * so that sub-tuples match the entropy cache keys.
+   *
+   * @param tuple Variable indexes, all tuples must be the same size
+   * @throws TupleSpaceException tuple size mismatch, repeated variable, or
+   * TupleSpace already defined by variable groups
+   */
+  void addTuple(tuple_t const& tuple);
+  /** Add many explicit variable tuples
+   *
+   * @param tuples Packed array of variable indexes, d consecutive indexes per
+   * tuple
+   * @param d tuple size
+   */
+  void addTuples(tuple_t const& tuples, int d);
+  /** Load explicit variable tuples from a CSV or tab-separated file, one
+   * tuple per line. The first line is skipped as a header if it contains a
+   * letter; blank lines are skipped.
+   *
+   * @throws TupleSpaceException line other than indexes and separators, or
+   * number of indexes not the same on every line
+   */
+  void loadTupleFile(std::string const& filename);
+  /** Load explicit variable tuples from a binary file of packed unsigned
+   * 32bit integers, d per tuple.
+   */
+  void loadTupleFileBinary(std::string const& filename, int d);
+  /** Sort the tuple list in lexicographic order and remove duplicates.
+   *
+   * Tuples sharing a prefix are then processed consecutively so the prefix
+   * sub-tuple entropies are computed once. The bulk loaders call this
+   * automatically.
+   */
+  void sortTuples();
+  /** Whether this TupleSpace is defined by an explicit list of tuples
+   */
+  bool isTupleList() const;
+  /** Number of variables the tuples are drawn from, one more than the
+   * largest variable index of any tuple
+   */
+  std::size_t num_variables() const;
   /** Get variable names
    */
   std::vector<std::string> names() const;
@@ -83,6 +168,10 @@ public:
 #if BOOST_PYTHON_EXTENSIONS
   int pyAddVariableGroup(std::string const& name, p::list const& list);
   void pyAddVariableGroupTuple(p::list const& list);
+  void pyAddTuple(p::list const& list);
+  /** Add tuples from an NxD integer ndarray, each row a tuple.
+   */
+  void pyAddTuples(np::ndarray const& array);
 #endif
 
   /** Calculate the size of the tuple space, i.e. count the generated number of
@@ -91,6 +180,9 @@ public:
   count_t count_tuples() const;
   count_t count_tuples_group_tuple(tuple_t const&) const;
   tuple_t find_tuple(count_t target) const;
+  /** Get the variable indexes of the tuple at position target.
+   */
+  tuple_t get_tuple(count_t target) const;
   tuple_t const& getVariableGroup(int index) const;
   tuple_t const& getVariableGroup(std::string const& name) const;
   std::vector<std::size_t> const& getVariableGroupSizes() const;
@@ -140,7 +232,11 @@ private:
   std::vector<tuple_t> variableGroupTuples;
   // keep track of seen variables to detect duplicates
   std::set<int> seen_vars;
+  // explicit tuples, packed tuple_size indexes per tuple
+  std::vector<index_t> tupleList;
   int tuple_size = 0;
+
+  void checkTupleSize(std::size_t d, std::string const& method);
 };
 
 class TupleSpaceException : public std::exception
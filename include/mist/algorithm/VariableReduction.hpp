@@ -0,0 +1,112 @@
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "Variable.hpp"
+#include "algorithm/TupleSpace.hpp"
+
+namespace mist {
+namespace algorithm {
+
+/** Constant and duplicate variables found before a search.
+ *
+ * A constant variable has the same value in every sample and none missing,
+ * so it adds no information to any tuple. Duplicate variables have the same
+ * value in every sample, missing values included, so every tuple with a
+ * duplicate has the same results as the tuple with its representative, the
+ * first variable of its class. The search space only needs the
+ * representatives that are not constant; results for the duplicates are
+ * copies of their representative's.
+ */
+class VariableReduction
+{
+public:
+  using tuple_t = Variable::indexes;
+  using tuple_space_ptr = std::shared_ptr<TupleSpace>;
+
+  /** Hash the variable columns, divided among threads.
+   *
+   * @param vars variables of the search
+   * @param threads number of threads hashing columns
+   */
+  VariableReduction(Variable::tuple const& vars, std::size_t threads = 1);
+
+  bool constant(std::size_t var) const { return is_constant[var]; };
+  /** Representative of the class of the variable, itself if unique
+   */
+  Variable::index_t representative(std::size_t var) const { return rep[var]; };
+  /** Variables of the class of a representative, the representative first
+   */
+  tuple_t const& members(std::size_t var) const { return classes[var]; };
+
+  /** Non-constant representatives, in index order
+   */
+  tuple_t const& kept() const { return _kept; };
+  std::size_t num_constant() const { return nconstant; };
+  std::size_t num_duplicates() const { return nduplicates; };
+
+  /** All tuples of the kept variables, as the complete TupleSpace of size d
+   * over all variables would order them.
+   */
+  tuple_space_ptr tuple_space(int d) const;
+
+  /** Call visit(copy) for each tuple made by substituting members of the
+   * classes of a kept tuple's variables, in their positions, except the
+   * kept tuple itself.
+   */
+  template<class Visit>
+  void for_each_copy(tuple_t const& tuple, tuple_t& copy, Visit visit) const;
+
+private:
+  std::vector<bool> is_constant;
+  tuple_t rep;
+  std::vector<tuple_t> classes;
+  tuple_t _kept;
+  std::size_t nconstant = 0;
+  std::size_t nduplicates = 0;
+};
+
+template<class Visit>
+void
+VariableReduction::for_each_copy(tuple_t const& tuple,
+                                 tuple_t& copy,
+                                 Visit visit) const
+{
+  auto d = tuple.size();
+  std::size_t pos[4] = { 0, 0, 0, 0 };
+  copy = tuple;
+  // odometer over the members of each position's class
+  while (true) {
+    std::size_t ii = 0;
+    for (; ii < d; ii++) {
+      auto const& members = classes[tuple[ii]];
+      if (++pos[ii] < members.size()) {
+        copy[ii] = members[pos[ii]];
+        break;
+      }
+      pos[ii] = 0;
+      copy[ii] = members[0];
+    }
+    if (ii == d) {
+      return;
+    }
+    visit(copy);
+  }
+}
+
+class VariableReductionException : public std::exception
+{
+private:
+  std::string msg;
+
+public:
+  VariableReductionException(std::string const& method, std::string const& msg)
+    : msg("VariableReduction::" + method + " : " + msg)
+  {}
+  virtual const char* what() const throw() { return msg.c_str(); };
+};
+
+} // algorithm
+} // mist
@@ -2,12 +2,17 @@
 
 #include <memory>
 
+#include "algorithm/Checkpoint.hpp"
+#include "algorithm/PermutationTest.hpp"
 #include "algorithm/TupleSpace.hpp"
+#include "algorithm/VariableReduction.hpp"
+#include "io/OrderedWriter.hpp"
 #include "io/OutputStream.hpp"
 #include "it/Distribution.hpp"
 #include "it/Entropy.hpp"
 #include "it/EntropyCalculator.hpp"
 #include "it/Measure.hpp"
+#include "it/Screen.hpp"
 #include "Variable.hpp"
 
 namespace mist {
@@ -26,6 +31,11 @@ public:
   using entropy_calc_ptr = std::unique_ptr<it::EntropyCalculator>;
   using output_stream_ptr = std::shared_ptr<io::OutputStream>;
   using measure_ptr = std::shared_ptr<it::Measure>;
+  using screen_ptr = std::shared_ptr<it::Screen>;
+  using checkpoint_ptr = std::shared_ptr<Checkpoint>;
+  using permutation_ptr = std::shared_ptr<PermutationTest>;
+  using reduction_ptr = std::shared_ptr<VariableReduction>;
+  using ordered_ptr = std::shared_ptr<io::OrderedWriter>;
   using tuple_t = Variable::indexes;
   using count_t = TupleSpace::count_t;
   using result_t = it::entropy_type;
@@ -73,9 +83,47 @@ public:
   void start();
 
   bool output_all = false;
+  /** Optional screen on the leading variable pair, tuples whose pair fails
+   * are not computed.
+   */
+  screen_ptr screen;
+  /** Skip tuples whose measure upper bound cannot reach the cutoff, see
+   * it::Measure::upper_bound. Only valid for data without missing values.
+   */
+  bool use_bounds = false;
+  /** Optional Checkpoint coordinating pauses, and this Worker's index in it
+   */
+  checkpoint_ptr checkpoint;
+  std::size_t checkpoint_index = 0;
+
+  /** Optional permutation test, the number of permutations reaching each
+   * output tuple's measure value is appended to its output. The calculator
+   * counts over the variables of the test.
+   */
+  permutation_ptr permutation;
+  entropy_calc_ptr permutation_calc;
+
+  /** Optional duplicate variables of a reduced search, each output tuple is
+   * also output for every copy with duplicates of its variables. Copies are
+   * sorted as the full search would visit them, unless all values are
+   * output: the intermediate values follow the positions of the variables.
+   */
+  reduction_ptr reduction;
+
+  /** Optional ordered output. The Worker searches the blocks handed out by
+   * the writer instead of its start and stop, and ends each block on its
+   * output streams.
+   */
+  ordered_ptr ordered;
 
   void process_tuple(count_t tuple_no, tuple_t const& tuple);
   void process_tuple_entropy(count_t tuple_no, tuple_t const& tuple, it::Entropy const& e);
+  bool process_prefix(tuple_t const& prefix,
+                      it::entropy_type e0,
+                      it::entropy_type e1,
+                      it::entropy_type e01);
+  void skip_tuples(count_t tuple_no, count_t n);
+  bool process_partial(count_t tuple_no, tuple_t const& tuple, it::Entropy const& e);
 
   count_t tuple_count() const;
 
@@ -89,8 +137,18 @@ private:
   result_t cutoff;
   // keep a result buffered to aviod malloc/free thrashing
   it::Measure::result_type result;
+  // final values of measures with several, see it::Measure::num_values
+  std::size_t nvalues = 1;
+  it::Measure::result_type values;
   // running count of seen tuples
   std::unique_ptr<atomic_count_t> tuples;
+  PermutationTest::workspace permutation_workspace;
+  tuple_t copy;
+  tuple_t sorted_copy;
+
+  void search(count_t begin, count_t end);
+  void output(count_t tuple_no, tuple_t const& tuple, it::Entropy const* e);
+  void push(count_t tuple_no, tuple_t const& tuple, bool use_values);
 };
 
 class WorkerException : public std::exception
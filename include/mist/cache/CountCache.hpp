@@ -0,0 +1,78 @@
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "../it/CountTable.hpp"
+#include "Cache.hpp"
+
+namespace mist {
+namespace cache {
+
+class CountCacheOutOfRange : public std::out_of_range
+{
+public:
+  CountCacheOutOfRange(std::string const& method, std::string const& key)
+    : out_of_range("CountCache::" + method + " : key " + key + " out of range")
+  {}
+};
+
+/** Entropy cache backed by integer count tables.
+ *
+ * Keeps an it::CountTable for a fixed set of tuples so the cached entropies
+ * can be brought up to date when rows are added to or removed from the data,
+ * without recounting the rows that did not change.
+ */
+class CountCache : public Cache
+{
+public:
+  using key_type = K;
+  using val_type = V;
+
+  /** Create empty count tables for each key, use update to count rows.
+   *
+   * Entropy does not depend on the order of variables in a tuple, so keys
+   * are stored and looked up with their variables sorted.
+   *
+   * @param vars variables, for the bins of each table
+   * @param keys tuples of equal size, packed one after the other
+   * @param d tuple size
+   */
+  CountCache(Variable::tuple const& vars, std::vector<Variable::index_t> const& keys, int d);
+
+  bool has(key_type const& key);
+  /** No-op, entropies come from the count tables.
+   */
+  void put(key_type const& key, val_type const& val);
+  val_type get(key_type const& key);
+  std::size_t size();
+  std::size_t bytes();
+
+  /** Number of count tables
+   */
+  std::size_t tables() const;
+  /** Update the count tables in [begin,end) and their cached entropies.
+   *
+   * Separate ranges may be updated concurrently.
+   *
+   * @param added rows entering the data, may be empty
+   * @param removed rows leaving the data, may be empty
+   */
+  void update(Variable::tuple const& added,
+              Variable::tuple const& removed,
+              std::size_t begin,
+              std::size_t end);
+  void update(Variable::tuple const& added, Variable::tuple const& removed);
+
+private:
+  std::vector<Variable::index_t> keys;
+  std::vector<it::CountTable> counts;
+  std::vector<val_type> entropies;
+  int d;
+
+  std::size_t find(key_type const& key) const;
+};
+
+} // cache
+} // mist
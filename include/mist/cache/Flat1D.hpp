@@ -47,6 +47,9 @@ public:
   bool has(key_type const& key);
   void put(key_type const& key, val_type const& val);
   val_type get(key_type const& key);
+  /** Make room for more variables, keeping existing entries
+   */
+  void grow(std::size_t nvar);
   std::size_t size();
   std::size_t bytes();
 
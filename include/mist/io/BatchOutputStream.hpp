@@ -0,0 +1,119 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "OutputStream.hpp"
+#include "it/Entropy.hpp"
+#include "py.hpp"
+
+namespace mist {
+namespace io {
+
+/** Batches of result rows handed from a running search to a consumer.
+ *
+ * Each batch is rows of the tuple then the result values, as doubles, in
+ * the layout of FlatOutputStream. The queue holds at most max_batches
+ * batches; a search that gets ahead of its consumer waits. Batches of
+ * different threads arrive in no particular order.
+ */
+class BatchQueue
+{
+public:
+  using data_t = it::Measure::data_t;
+  using batch_type = std::vector<data_t>;
+  using batch_ptr = std::shared_ptr<batch_type>;
+
+  /** @param max_batches most batches held, at least 1
+   */
+  BatchQueue(std::size_t max_batches);
+
+  /** Add a batch, waiting for room. Dropped once the queue is cancelled.
+   */
+  void push(batch_ptr const& batch);
+  /** Take the next batch, waiting for one.
+   *
+   * @return false once the queue is closed and empty
+   * @exception the exception the search failed with, see fail
+   */
+  bool pop(batch_ptr& batch);
+  /** No more batches will be pushed
+   */
+  void close();
+  /** The search failed, pop throws the exception once the queue is empty
+   */
+  void fail(std::exception_ptr error);
+  /** The consumer is gone, drop all batches so the search is never held
+   * up.
+   */
+  void cancel();
+
+  void set_rowsize(std::size_t n) { rowsize = n; };
+  std::size_t get_rowsize() const { return rowsize; };
+
+#if BOOST_PYTHON_EXTENSIONS
+  /** Python iterator protocol, the next batch as a rows x columns array.
+   * The GIL is released while waiting. The array owns its batch, without a
+   * copy.
+   */
+  np::ndarray py_next();
+#endif
+
+private:
+  std::size_t max_batches;
+  std::size_t rowsize = 0;
+  std::mutex m;
+  std::condition_variable pushed;
+  std::condition_variable popped;
+  std::deque<batch_ptr> batches;
+  bool closed = false;
+  bool cancelled = false;
+  std::exception_ptr error;
+};
+
+/** Output stream of one thread, handing rows to a BatchQueue in batches of
+ * batch_rows rows.
+ */
+class BatchOutputStream : public OutputStream
+{
+public:
+  BatchOutputStream(std::shared_ptr<BatchQueue> const& queue,
+                    std::size_t rowsize,
+                    std::size_t batch_rows);
+  ~BatchOutputStream(){};
+
+  void push(std::size_t tuple_no, tuple_type const& tuple, result_type const& result);
+  void push(std::size_t tuple_no, tuple_type const& tuple, it::entropy_type result);
+  /** Hand the partial batch to the queue
+   */
+  void flush();
+
+private:
+  std::shared_ptr<BatchQueue> queue;
+  std::size_t rowsize;
+  std::size_t batch_rows;
+  BatchQueue::batch_ptr batch;
+
+  void write_row(tuple_type const& tuple, data_t const* values, std::size_t n);
+};
+
+class BatchOutputStreamException : public std::exception
+{
+private:
+  std::string msg;
+
+public:
+  BatchOutputStreamException(std::string const& method, std::string const& msg)
+    : msg("BatchOutputStream::" + method + ": " + msg)
+  {}
+  virtual const char* what() const throw() { return msg.c_str(); };
+};
+
+} // io
+} // mist
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "FileOutputStream.hpp"
+
+namespace mist {
+namespace io {
+
+/** Results written as fixed-width binary records.
+ *
+ * The file starts with a header describing the records:
+ *
+ * - magic "MISTBIN1", 8 bytes
+ * - header size in bytes, the offset of the first record
+ * - tuple size d
+ * - number of values n per record
+ * - size of each value in bytes, 4 for float32 or 8 for float64
+ * - length of the column names, then the names separated by commas as in
+ *   the CSV header
+ *
+ * The numbers are uint32 and the header is zero-padded to a multiple of 8
+ * bytes. Each record is d uint32 variable indexes followed by n values, with
+ * no padding, in the byte order of the machine that wrote the file. Records
+ * are copied straight into the write buffer, so writing a result allocates
+ * nothing and formats nothing.
+ */
+class BinaryOutputStream : public FileOutputStream
+{
+public:
+  using index_type = std::uint32_t;
+
+  static const char magic[8];
+
+  /** Contents of a binary results file
+   */
+  struct contents
+  {
+    std::vector<std::string> names;
+    std::size_t tuple_size = 0;
+    std::size_t nvalues = 0;
+    std::size_t value_size = 0;
+    /** Variable indexes of each record, d per record
+     */
+    std::vector<index_type> tuples;
+    /** Values of each record, n per record
+     */
+    std::vector<double> values;
+    std::size_t size() const { return (nvalues) ? values.size() / nvalues : 0; };
+  };
+
+  /**
+   * @param filename output file
+   * @param header comma-separated column names, the tuple columns first
+   * @param tuple_size number of variables in each tuple
+   * @param value_size 4 to write float32 values, 8 for float64
+   * @param mode file open mode, the header is not written when appending
+   * @exception BinaryOutputStreamException value size not 4 or 8, or no
+   *            value columns in the header
+   */
+  BinaryOutputStream(std::string const& filename,
+                     std::string const& header,
+                     std::size_t tuple_size,
+                     std::size_t value_size = 8,
+                     std::ios_base::openmode mode = std::ios_base::out);
+  BinaryOutputStream(BinaryOutputStream const& other);
+  ~BinaryOutputStream(){};
+
+  std::shared_ptr<FileOutputStream> clone() const;
+
+  /** @exception BinaryOutputStreamException tuple or result size differs
+   *             from the header
+   */
+  void push(std::size_t tuple_no, tuple_type const& tuple, result_type const& result);
+  void push(std::size_t tuple_no, tuple_type const& tuple, it::entropy_type result);
+
+  /** Read all records of a binary results file
+   * @exception BinaryOutputStreamException not a binary results file
+   */
+  static contents read_file(std::string const& filename);
+
+private:
+  std::size_t tuple_size;
+  std::size_t nvalues;
+  std::size_t value_size;
+  std::size_t record_size;
+
+  template<class Value>
+  void write_record(tuple_type const& tuple, data_t const* values);
+};
+
+class BinaryOutputStreamException : public std::exception
+{
+private:
+  std::string msg;
+
+public:
+  BinaryOutputStreamException(std::string const& method, std::string const& msg)
+    : msg("BinaryOutputStream::" + method + ": " + msg)
+  {}
+  virtual const char* what() const throw() { return msg.c_str(); };
+};
+
+} // io
+} // mist
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "OutputStream.hpp"
+#include "it/Entropy.hpp"
+#include "py.hpp"
+
+namespace mist {
+namespace io {
+
+/** Results kept in memory as typed columns.
+ *
+ * The tuple is either d uint32 variable index columns, or one uint64 column
+ * of the tuple number, which TupleSpace::get_tuple decodes. Each value
+ * column is float32 or float64. FlatOutputStream stores every column as a
+ * double, so the same results take a half to a quarter of the memory, less
+ * with tuple numbers for large d.
+ *
+ * With a size, each row is written at its tuple number, less the offset,
+ * into columns allocated up front. Without a size the rows are appended.
+ */
+class ColumnOutputStream : public OutputStream
+{
+public:
+  using index_type = std::uint32_t;
+  using tuple_no_type = std::uint64_t;
+
+  /**
+   * @param tuple_size number of variables in each tuple
+   * @param value_sizes bytes of each value column, 4 for float32 or 8 for
+   *        float64
+   * @param tuple_numbers store the tuple number instead of the variable
+   *        indexes
+   * @param size rows allocated up front, 0 to append rows
+   * @param offset tuple number of the first row when sized
+   * @exception ColumnOutputStreamException value size not 4 or 8, or not
+   *            enough memory
+   */
+  ColumnOutputStream(std::size_t tuple_size,
+                     std::vector<std::size_t> const& value_sizes,
+                     bool tuple_numbers = false,
+                     std::size_t size = 0,
+                     std::size_t offset = 0);
+  ~ColumnOutputStream(){};
+
+  /** @exception ColumnOutputStreamException tuple or result size differs,
+   *             or tuple number out of range
+   */
+  void push(std::size_t tuple_no, tuple_type const& tuple, result_type const& result);
+  void push(std::size_t tuple_no, tuple_type const& tuple, it::entropy_type result);
+
+  /** Move the rows of other to the end of this stream, other is empty after.
+   * Each column of other is freed as soon as it is copied.
+   */
+  void relocate(ColumnOutputStream& other);
+
+  /** Number of rows
+   */
+  std::size_t size() const;
+  /** Number of columns, the tuple columns then the value columns
+   */
+  std::size_t num_columns() const { return columns.size(); };
+  /** Bytes of each element of the column
+   */
+  std::size_t column_width(std::size_t column) const { return columns[column].width; };
+  /** Elements of the column, index_type for variable indexes, tuple_no_type
+   * for tuple numbers, float or double for values
+   */
+  void const* column_data(std::size_t column) const { return columns[column].data->data(); };
+  bool has_tuple_numbers() const { return tuple_numbers; };
+
+  /** Variable index at position of the tuple in the row
+   */
+  index_type index(std::size_t row, std::size_t position) const;
+  tuple_no_type tuple_no(std::size_t row) const;
+  /** Value of the value column in the row, as a double
+   */
+  double value(std::size_t row, std::size_t value_column) const;
+
+#if BOOST_PYTHON_EXTENSIONS
+  /** Numpy array of the column, of the column's dtype. The array shares
+   * the column, which stays alive as long as the array.
+   */
+  np::ndarray py_get_column(std::size_t column);
+#endif
+
+private:
+  struct column
+  {
+    std::size_t width;
+    // shared with the Numpy arrays of the column
+    std::shared_ptr<std::vector<char>> data;
+  };
+
+  std::vector<column> columns;
+  std::size_t tuple_size;
+  std::size_t ntuple_columns;
+  std::size_t nvalues;
+  bool tuple_numbers;
+  std::size_t rows;
+  std::size_t fixed_size;
+  std::size_t offset;
+
+  std::size_t next_row(std::size_t tuple_no, std::size_t tuple_size, std::size_t nvalues);
+  void put_value(column& c, std::size_t row, double value);
+  void write_row(std::size_t tuple_no, tuple_type const& tuple, data_t const* values, std::size_t n);
+};
+
+class ColumnOutputStreamException : public std::exception
+{
+private:
+  std::string msg;
+
+public:
+  ColumnOutputStreamException(std::string const& method, std::string const& msg)
+    : msg("ColumnOutputStream::" + method + ": " + msg)
+  {}
+  virtual const char* what() const throw() { return msg.c_str(); };
+};
+
+} // io
+} // mist
@@ -42,6 +42,8 @@ public:
   using data_t = Variable::data_t;
   using index_t = Variable::index_t;
   using variables_ptr = std::shared_ptr<Variable::tuple>;
+  using multiplicity_t = std::uint32_t;
+  using multiplicities_ptr = std::shared_ptr<std::vector<multiplicity_t>>;
 
   // allocate empty matrix
   DataMatrix(std::size_t ncol, std::size_t nrow, data_t b);
@@ -60,6 +62,65 @@ public:
   std::size_t get_ncol() const;
   std::size_t get_nrow() const;
 
+  /** Use a column as the stratum label of each sample rather than as a
+   * variable. The column is taken out of the variables, so variables after it
+   * move down one index. Labels are binned like any variable and missing
+   * labels leave a sample out of every stratum.
+   * @exception DataMatrixException column out of range or the only variable
+   */
+  void set_strata(index_t column);
+  bool has_strata() const;
+  /** Stratum label column, one bin per stratum
+   * @exception DataMatrixException no strata column set
+   */
+  Variable get_strata() const;
+
+  /** Collapse identical samples into one, keeping the number of samples
+   * each stands for. Unique samples keep the order of their first
+   * occurrence. Counting each unique sample by its multiplicity gives the
+   * same counts as the full data, while scanning fewer rows. Includes the
+   * strata column if set.
+   * @return number of unique samples
+   */
+  std::size_t deduplicate();
+  bool is_deduplicated() const;
+  /** Multiplicity of each sample, null unless deduplicated
+   */
+  multiplicities_ptr multiplicities() const;
+  /** Number of samples in the data, the sum of the multiplicities if
+   * deduplicated.
+   */
+  std::size_t get_nsamples() const;
+
+  /** Remap the values of each variable to the bins [0,k), in value order,
+   * where k is the number of distinct values that occur. Distributions and
+   * bitset tables are then sized by the values in the data rather than the
+   * largest value. Columns that are already dense are kept, the others are
+   * copied so data shared with another matrix is not modified.
+   * @return number of variables remapped
+   */
+  std::size_t compact_bins();
+  bool is_compacted() const;
+  /** Value in the loaded data of each bin of a variable
+   * @exception DataMatrixException column out of range
+   */
+  std::vector<data_t> get_bin_values(index_t column) const;
+
+  /** Drop the first n samples. The columns start n rows later in the same
+   * memory, nothing is copied.
+   * @exception DataMatrixException n not less than the number of samples,
+   *            strata or deduplicated
+   */
+  void drop_samples(std::size_t n);
+  /** Append the samples of other, with the same variables, after the last
+   * sample. The columns keep spare rows that grow geometrically, so the cost
+   * is in the appended rows. Rows another matrix sharing the memory may
+   * read are never written, it is copied instead.
+   * @exception DataMatrixException number of variables differs, strata,
+   *            deduplicated or compacted
+   */
+  void append_samples(DataMatrix const& other);
+
   void write_file(std::string const& filename, char sep);
   void write_file(std::string const& filename);
 #ifdef BOOST_PYTHON_EXTENSIONS
@@ -71,6 +132,16 @@ public:
 
 private:
   variables_ptr _variables;
+  Variable::data_ptr strata_vector;
+  data_t strata_bins = 0;
+  multiplicities_ptr _multiplicities;
+  // loaded value of each bin of each variable, empty unless compacted
+  std::vector<std::vector<data_t>> bin_values;
+  // rows of the column memory before the first sample and in total, and the
+  // rows written by any matrix sharing the memory, null if not known
+  std::size_t row_offset = 0;
+  std::size_t row_capacity = 0;
+  std::shared_ptr<std::size_t> rows_written;
   std::size_t ncol;
   std::size_t nrow;
   std::size_t nvar;
@@ -10,7 +10,7 @@
 #include "OutputStream.hpp"
 #include "it/Entropy.hpp"
 
-#define BUFFER_MAX_SIZE_DEFAULT 1024
+#define BUFFER_MAX_SIZE_DEFAULT (64 * 1024)
 
 // the maximum string length of a double to string conversion
 #define DOUBLE_BUFFER_MAX_SIZE 64
@@ -18,6 +18,8 @@
 namespace mist {
 namespace io {
 
+class OrderedWriter;
+
 class FileOutputStream : public OutputStream
 {
 public:
@@ -27,19 +29,29 @@ public:
   using file_ptr = std::shared_ptr<file_type>;
   using size_type = std::size_t;
 
-private:
+protected:
   file_ptr file;
   buffer_ptr buffer;
-  buffer_type double_strbuf;
   size_type buffer_max_size;
   size_type buffer_cur_size;
   std::string filename;
   std::string header;
+  // significant digits of values, 0 for the shortest that round-trips
+  int precision = 6;
+  // blocks of results go to the writer instead of the file
+  std::shared_ptr<OrderedWriter> ordered;
 
   void direct_write(std::string const& ss);
-  void buffered_write(std::string const& ss);
+  void reserve(size_type len);
+  void write_row(tuple_type const& tuple, data_t const* values, size_type n);
   void init();
 
+  /** Open the file without writing a header, for other formats.
+   */
+  FileOutputStream(std::string const& filename,
+                   std::ios_base::openmode mode,
+                   size_type buffer_max_size);
+
 public:
   FileOutputStream(std::string const& filename);
   FileOutputStream(std::string const& filename, size_type buffer_max_size);
@@ -49,10 +61,51 @@ public:
                    std::string const& header,
                    size_type buffer_max_size);
   FileOutputStream(FileOutputStream const& other, std::string const& header);
+  /** Open file with the given mode. The header is not written when
+   * appending to an existing file.
+   */
+  FileOutputStream(std::string const& filename,
+                   std::string const& header,
+                   std::ios_base::openmode mode);
   ~FileOutputStream();
 
+  /** Copy sharing the file of this stream with a buffer of its own, one for
+   * each Worker.
+   */
+  virtual std::shared_ptr<FileOutputStream> clone() const;
+
   void push(std::size_t tuple_no, tuple_type const& tuple, result_type const& result);
   void push(std::size_t tuple_no, tuple_type const& tuple, it::entropy_type result);
+  /** Significant digits of the values written, 6 by default as printf %g.
+   * 0 writes the fewest digits that read back as the same double.
+   * Rows are formatted straight into the buffer of the stream, without
+   * allocation.
+   * @exception FileOutputStreamException digits outside [0,17]
+   */
+  void set_precision(int digits);
+  int get_precision() const;
+  /** Hand the results of each block to an OrderedWriter instead of writing
+   * them to the file. The buffer grows to hold a whole block.
+   */
+  void set_ordered(std::shared_ptr<OrderedWriter> const& writer);
+  /** Submit the buffer to the OrderedWriter as the results of the block
+   */
+  void end_block(std::size_t block);
+  /** Write bytes to the shared file, bypassing the buffer of this stream
+   * @exception FileOutputStreamException write error
+   */
+  void write_block(char const* data, size_type size);
+  /** Write the buffer of this stream and flush the shared file
+   */
+  void flush();
+  /** Flush and wait until the file is on disk, so what was written survives
+   * a crash.
+   * @exception FileOutputStreamException write error
+   */
+  void sync();
+  /** Current size of the written file
+   */
+  size_type tell();
   std::string get_filename();
 };
 
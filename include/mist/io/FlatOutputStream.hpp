@@ -1,6 +1,9 @@
 #pragma once
 
 #include <map>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "OutputStream.hpp"
 #include "it/Entropy.hpp"
@@ -9,12 +12,37 @@
 namespace mist {
 namespace io {
 
+/** Results kept in memory as rows of the tuple then the result values.
+ *
+ * With a size, each row is written at its tuple number, less the offset,
+ * into an array allocated up front. Without a size the rows are appended to
+ * a list of segments. Segments are allocated with a fixed capacity, doubling
+ * from SEGMENT_ROWS_MIN rows up to SEGMENT_ROWS_MAX, and never reallocated.
+ * The segments of several streams are linked with relocate, and copied into
+ * one array only when the results are read.
+ *
+ * A sized array can instead be mapped from a file, so results larger than
+ * memory are paged out to disk by the kernel. The file holds the rows as
+ * native-endian doubles with no header, ready for numpy.memmap.
+ */
 class FlatOutputStream : public OutputStream
 {
 public:
   using results_t = std::vector<result_type>;
   using tuples_t = std::vector<tuple_type>;
+  using segment_type = std::vector<data_t>;
+
+  static const std::size_t SEGMENT_ROWS_MIN = 1 << 10;
+  static const std::size_t SEGMENT_ROWS_MAX = 1 << 16;
+
   FlatOutputStream(std::size_t size, std::size_t rowsize, std::size_t offset);
+  /** Sized array mapped from the file, created or truncated to size rows.
+   * @exception FlatOutputStreamException file error
+   */
+  FlatOutputStream(std::string const& filename,
+                   std::size_t size,
+                   std::size_t rowsize,
+                   std::size_t offset);
   FlatOutputStream(std::size_t rowsize, std::size_t offset);
   FlatOutputStream(std::size_t offset);
   FlatOutputStream();
@@ -23,20 +51,46 @@ public:
   void push(std::size_t tuple_no, tuple_type const& tuple, result_type const& result);
   void push(std::size_t tuple_no, tuple_type const& tuple, it::entropy_type result);
   //void combine(FlatOutputStream const& other);
-  std::vector<data_t> const& get_results();
+  /** All rows in one array. Segments are copied in parallel by threads into
+   * the array, a few at a time, and freed once copied.
+   */
+  std::vector<data_t> const& get_results(std::size_t threads = 1);
+  /** Rows of a mapped array, nullptr if not mapped
+   */
+  data_t const* get_mapped_results() const { return mapped; };
+  std::size_t get_rowsize() const { return rowsize; };
+  std::size_t get_size() const { return size; };
+  /** Start writing the mapped rows back to the file, without waiting
+   */
+  void flush();
   //tuples_t const& get_tuples();
-  /** Move all data in other to this object
+  /** Move all data in other to the end of this object. The segments are
+   * linked, not copied.
    */
   void relocate(FlatOutputStream &other);
 #if BOOST_PYTHON_EXTENSIONS
-  np::ndarray py_get_results();
+  /** Numpy array of all rows, without a copy. The array shares the rows,
+   * which stay alive as long as the array.
+   */
+  np::ndarray py_get_results(std::size_t threads = 1);
 #endif
 
 private:
-  std::vector<data_t> *data;
+  // shared with the Numpy arrays of the results
+  std::shared_ptr<std::vector<data_t>> data;
+  std::vector<std::shared_ptr<segment_type>> segments;
+  std::size_t segment_rows = SEGMENT_ROWS_MIN;
   std::size_t size;
   std::size_t rowsize;
   std::size_t offset; // for parallel algorithims when we're only caputing a subset of the TupleSpace, the offset moves our index back to zero
+  data_t* mapped = nullptr;
+  std::shared_ptr<data_t> mapping;
+  std::string mapped_file;
+
+  data_t* rows() { return (mapped) ? mapped : data->data(); };
+
+  segment_type& next_row();
+  void gather(std::size_t threads);
 };
 
 class FlatOutputStreamException : public std::exception
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mist {
+namespace io {
+
+class FileOutputStream;
+
+/** Writes the results of parallel Workers in tuple order.
+ *
+ * The tuples [start,stop) are divided into fixed-size blocks that Workers
+ * take in order with next_block. Each Worker formats the results of a block
+ * into its own buffer and submits it, tagged with the block number. A writer
+ * thread writes the blocks to the file in block order, holding the blocks
+ * that finish early in a reorder buffer. The buffer holds at most capacity
+ * blocks: a Worker that finishes a block too far ahead of the next block to
+ * write waits until the writer catches up.
+ *
+ * Blocks are handed out in order, so the block the writer waits for is
+ * always held by a Worker that can submit it and the search cannot stall.
+ */
+class OrderedWriter
+{
+public:
+  using count_t = std::uint64_t;
+  using buffer_type = std::vector<char>;
+  using size_type = std::size_t;
+  using file_stream_ptr = std::shared_ptr<FileOutputStream>;
+
+  static const count_t BLOCK_SIZE_DEFAULT = 1 << 14;
+
+  /** Start the writer thread.
+   *
+   * @param file stream whose file the blocks are written to, after its header
+   * @param start first tuple number
+   * @param stop one past the last tuple number
+   * @param capacity most blocks held in the reorder buffer, at least 1
+   * @param block_size tuples in each block, at least 1
+   */
+  OrderedWriter(file_stream_ptr const& file,
+                count_t start,
+                count_t stop,
+                size_type capacity,
+                count_t block_size = BLOCK_SIZE_DEFAULT);
+  OrderedWriter(OrderedWriter const&) = delete;
+  OrderedWriter& operator=(OrderedWriter const&) = delete;
+  ~OrderedWriter();
+
+  /** Take the next block of tuples to search, [begin,end).
+   *
+   * @return false when all blocks have been taken
+   */
+  bool next_block(count_t& block, count_t& begin, count_t& end);
+
+  /** Hand the results of a block to the writer, the first size bytes of the
+   * buffer. The buffer is exchanged for an empty one of the same size.
+   * Blocks until the block fits in the reorder buffer.
+   * @exception OrderedWriterException writer closed after an error
+   */
+  void submit(count_t block, buffer_type& buffer, size_type size);
+
+  /** Wait for all blocks to be written and stop the writer thread.
+   * @exception OrderedWriterException a block was not submitted
+   */
+  void close();
+
+  count_t num_blocks() const { return nblocks; };
+
+private:
+  struct pending_block
+  {
+    buffer_type buffer;
+    size_type size;
+  };
+
+  file_stream_ptr file;
+  count_t start;
+  count_t stop;
+  size_type capacity;
+  count_t block_size;
+  count_t nblocks;
+  std::atomic<count_t> taken;
+
+  std::mutex m;
+  std::condition_variable submitted;
+  std::condition_variable written;
+  std::map<count_t, pending_block> pending;
+  // written buffers, reused by submit
+  std::vector<buffer_type> free_buffers;
+  count_t next = 0;
+  bool closing = false;
+  std::exception_ptr error;
+  std::thread writer;
+
+  void write_blocks();
+};
+
+class OrderedWriterException : public std::exception
+{
+private:
+  std::string msg;
+
+public:
+  OrderedWriterException(std::string const& method, std::string const& msg)
+    : msg("OrderedWriter::" + method + ": " + msg)
+  {}
+  virtual const char* what() const throw() { return msg.c_str(); };
+};
+
+} // io
+} // mist
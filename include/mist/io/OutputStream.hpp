@@ -1,6 +1,7 @@
 #pragma once
 
 #include <fstream>
+#include <limits>
 #include <memory>
 #include <mutex>
 
@@ -28,6 +29,20 @@ public:
   virtual ~OutputStream(){};
   virtual void push(std::size_t tuple_no, tuple_type const& tuple, result_type const& result) = 0;
   virtual void push(std::size_t tuple_no, tuple_type const& tuple, it::entropy_type result) = 0;
+  /** Smallest result value the stream will still keep. Streams of bounded
+   * size use this to raise the Worker cutoff as they fill.
+   */
+  virtual it::entropy_type min_value() const
+  {
+    return -std::numeric_limits<it::entropy_type>::infinity();
+  };
+  /** Write out any buffered results
+   */
+  virtual void flush(){};
+  /** Notification that the results of a block of tuples are complete, see
+   * OrderedWriter
+   */
+  virtual void end_block(std::size_t block){};
   // virtual void push(tuple_type const& tuple, measure_type) = 0;
 };
 
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "OutputStream.hpp"
+#include "it/Entropy.hpp"
+#include "py.hpp"
+
+namespace mist {
+namespace io {
+
+/** Results of a search of pairs kept as packed triangular matrices.
+ *
+ * Each value column is a plane holding the pair i < j at (j * (j - 1)) / 2 +
+ * i, the indexing of cache::Flat2D. This is the strictly lower triangle in
+ * row-major order, as numpy.tril_indices(nvar, -1), so the entries of the
+ * first n variables do not depend on the total number of variables. The
+ * planes are stored one after the other. Pairs without a result, e.g. below
+ * the cutoff, are NaN.
+ *
+ * Each pair is written to its own element, so the threads of a search share
+ * one stream. The planes can be mapped from a file, holding them as
+ * native-endian doubles with no header, ready for numpy.memmap.
+ */
+class PairMatrixOutputStream : public OutputStream
+{
+public:
+  /**
+   * @param nvar number of variables, the matrices are nvar x nvar
+   * @param nplanes number of value columns
+   * @exception PairMatrixOutputStreamException not enough memory
+   */
+  PairMatrixOutputStream(std::size_t nvar, std::size_t nplanes);
+  /** Planes mapped from the file, created or truncated to their size.
+   * @exception PairMatrixOutputStreamException file error
+   */
+  PairMatrixOutputStream(std::string const& filename,
+                         std::size_t nvar,
+                         std::size_t nplanes);
+  ~PairMatrixOutputStream(){};
+
+  /** @exception PairMatrixOutputStreamException not a pair of the matrix, or
+   *             result size differs
+   */
+  void push(std::size_t tuple_no, tuple_type const& tuple, result_type const& result);
+  void push(std::size_t tuple_no, tuple_type const& tuple, it::entropy_type result);
+
+  /** Element of the pair i, j in each plane, i != j
+   */
+  static std::size_t index(std::size_t i, std::size_t j)
+  {
+    if (i > j) {
+      std::swap(i, j);
+    }
+    return (j * (j - 1)) / 2 + i;
+  };
+  /** Copy the pairs of other, of as many planes and the same or fewer
+   * variables, e.g. the results of the variables searched before appending
+   * more.
+   */
+  void copy_pairs(PairMatrixOutputStream const& other);
+
+  std::size_t get_nvar() const { return nvar; };
+  std::size_t get_nplanes() const { return nplanes; };
+  /** Number of pairs in each plane
+   */
+  std::size_t get_plane_size() const { return plane_size; };
+  data_t const* plane(std::size_t k) const { return planes.get() + k * plane_size; };
+  /** Value of the pair i, j in the plane, NaN if it has none
+   */
+  data_t value(std::size_t k, std::size_t i, std::size_t j) const;
+  bool is_mapped() const { return !mapped_file.empty(); };
+  /** Start writing the mapped planes back to the file, without waiting
+   */
+  void flush();
+
+#if BOOST_PYTHON_EXTENSIONS
+  /** Numpy array of planes x pairs, without a copy. The array shares the
+   * planes, which stay alive as long as the array.
+   */
+  np::ndarray py_get_planes();
+#endif
+
+private:
+  std::size_t nvar;
+  std::size_t nplanes;
+  std::size_t plane_size;
+  // shared with the Numpy arrays of the planes
+  std::shared_ptr<data_t> planes;
+  std::string mapped_file;
+
+  void write_pair(tuple_type const& tuple, data_t const* values, std::size_t n);
+};
+
+class PairMatrixOutputStreamException : public std::exception
+{
+private:
+  std::string msg;
+
+public:
+  PairMatrixOutputStreamException(std::string const& method, std::string const& msg)
+    : msg("PairMatrixOutputStream::" + method + ": " + msg)
+  {}
+  virtual const char* what() const throw() { return msg.c_str(); };
+};
+
+} // io
+} // mist
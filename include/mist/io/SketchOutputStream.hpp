@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "OutputStream.hpp"
+#include "it/Entropy.hpp"
+#include "py.hpp"
+
+namespace mist {
+namespace io {
+
+/** Streaming histogram of the measure values, to pick a cutoff without
+ * keeping the results.
+ *
+ * Values are counted in buckets of logarithmic width, so any quantile is
+ * returned with a relative error of at most the accuracy, and memory does
+ * not depend on the number of results. Buckets are merged by adding counts,
+ * so the merged sketch of several streams does not depend on how the
+ * TupleSpace was divided among them. The sketched value is the final result
+ * column, same as the cutoff.
+ */
+class SketchOutputStream : public OutputStream
+{
+public:
+  using count_t = std::uint64_t;
+  struct bucket
+  {
+    // value representing the bucket, within the accuracy of its values
+    double value;
+    count_t count;
+  };
+  using buckets_t = std::vector<bucket>;
+
+  static constexpr double ACCURACY_DEFAULT = 0.01;
+
+  /**
+   * @param accuracy relative error of the quantiles, between 0 and 1
+   * @exception SketchOutputStreamException accuracy out of range
+   */
+  SketchOutputStream(double accuracy = ACCURACY_DEFAULT);
+  ~SketchOutputStream(){};
+
+  void push(std::size_t tuple_no, tuple_type const& tuple, result_type const& result);
+  void push(std::size_t tuple_no, tuple_type const& tuple, it::entropy_type result);
+  /** Count a value, NaN is ignored
+   */
+  void add(double value, count_t n = 1);
+  /** Add the counts of other to this sketch.
+   * @exception SketchOutputStreamException accuracy differs
+   */
+  void merge(SketchOutputStream const& other);
+  /** Write the sketch to a binary file, e.g. to merge the sketches of
+   * searches on other nodes with merge_file.
+   */
+  void write_file(std::string const& filename) const;
+  /** Add the counts from a file made by write_file to this sketch.
+   */
+  void merge_file(std::string const& filename);
+
+  /** Value below which a fraction q of the values fall.
+   * @param q between 0 and 1
+   * @exception SketchOutputStreamException empty sketch or q out of range
+   */
+  double quantile(double q) const;
+  /** Cutoff that keeps about the given fraction of the values, the largest
+   * ones.
+   */
+  double top_fraction_cutoff(double fraction) const;
+  /** Non-empty buckets in increasing order of value
+   */
+  buckets_t buckets() const;
+  count_t count() const { return total; };
+  double min() const { return min_value; };
+  double max() const { return max_value; };
+  double get_accuracy() const { return accuracy; };
+
+#if BOOST_PYTHON_EXTENSIONS
+  /** Numpy array of the buckets, a row of value and count for each
+   */
+  np::ndarray py_buckets() const;
+#endif
+
+private:
+  double accuracy;
+  double gamma;
+  double log_gamma;
+  // bucket i holds the magnitudes in (gamma^(i-1), gamma^i]
+  std::map<int, count_t> positive;
+  std::map<int, count_t> negative;
+  count_t zero = 0;
+  count_t total = 0;
+  double min_value;
+  double max_value;
+
+  int index(double magnitude) const;
+  double bucket_value(int index) const;
+};
+
+class SketchOutputStreamException : public std::exception
+{
+private:
+  std::string msg;
+
+public:
+  SketchOutputStreamException(std::string const& method, std::string const& msg)
+    : msg("SketchOutputStream::" + method + ": " + msg)
+  {}
+  virtual const char* what() const throw() { return msg.c_str(); };
+};
+
+} // io
+} // mist
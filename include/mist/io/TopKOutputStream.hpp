@@ -0,0 +1,81 @@
+#pragma once
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "OutputStream.hpp"
+#include "it/Entropy.hpp"
+
+namespace mist {
+namespace io {
+
+/** Keep only the K tuples with the largest measure value.
+ *
+ * Results are held in a fixed-size min-heap so memory is constant regardless
+ * of the size of the TupleSpace. Ties are broken by tuple number, lower
+ * first, so the merged result of several streams does not depend on how the
+ * TupleSpace was divided among them. The ranking value is the final result
+ * column, same as the cutoff.
+ */
+class TopKOutputStream : public OutputStream
+{
+public:
+  using count_t = std::uint64_t;
+  struct entry
+  {
+    it::entropy_type value;
+    count_t tuple_no;
+    tuple_type tuple;
+    result_type result;
+  };
+  using entries_t = std::vector<entry>;
+
+  TopKOutputStream(std::size_t k);
+  ~TopKOutputStream();
+
+  void push(std::size_t tuple_no, tuple_type const& tuple, result_type const& result);
+  void push(std::size_t tuple_no, tuple_type const& tuple, it::entropy_type result);
+  /** Smallest value that can still enter the heap, -inf until K tuples have
+   * been seen.
+   */
+  it::entropy_type min_value() const;
+  /** Add all entries of other to this heap.
+   */
+  void merge(TopKOutputStream const& other);
+  /** Write the heap to a binary file, e.g. to merge the results of searches
+   * on other nodes with merge_file.
+   */
+  void write_file(std::string const& filename) const;
+  /** Add all entries from a file made by write_file to this heap.
+   */
+  void merge_file(std::string const& filename);
+  /** Entries ordered best first
+   */
+  entries_t sorted() const;
+  std::size_t size() const;
+  std::size_t get_k() const;
+
+private:
+  std::size_t k;
+  entries_t heap;
+
+  void push_entry(it::entropy_type value,
+                  count_t tuple_no,
+                  tuple_type const& tuple,
+                  result_type const* result);
+};
+
+class TopKOutputStreamException : public std::exception
+{
+private:
+  std::string msg;
+public:
+  TopKOutputStreamException(std::string const& method, std::string const& msg)
+    : msg("TopKOutputStream::" + method + ": " + msg)
+  {}
+  virtual const char* what() const throw() { return msg.c_str(); };
+};
+
+} // io
+} // mist
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "../Variable.hpp"
+
+#include "Entropy.hpp"
+#include "EntropyCalculator.hpp"
+#include "MarginalCountTable.hpp"
+#include "Measure.hpp"
+
+namespace mist {
+namespace it {
+
+/** Bootstrap confidence intervals of a measure from one pass over the data.
+ *
+ * Each replicate resamples the rows with Poisson(1) weights, generated from
+ * a seed so the replicates are the same in every run and process. Rather
+ * than copying the data for each replicate, every row adds its weight in
+ * each replicate to a layer of a MarginalCountTable, so all replicates of a
+ * tuple are counted in a single pass over its columns.
+ *
+ * The result holds the sub calculations of the measure on the data,
+ * followed by the mean and the lower and upper percentile bounds over the
+ * replicates of each final value, then the final values on the data. The
+ * last value is compared against the cutoff.
+ */
+class BootstrapMeasure : public Measure
+{
+public:
+  using measure_ptr = std::shared_ptr<Measure>;
+  using variables_ptr = std::shared_ptr<Variable::tuple>;
+  using weight_t = std::uint8_t;
+
+  /**
+   * @param measure measure to bootstrap
+   * @param vars variables the tuples index
+   * @param replicates number of bootstrap replicates
+   * @param confidence confidence level of the percentile interval
+   * @param seed random number generator seed
+   * @exception BootstrapMeasureException no replicates, or confidence not
+   *            in (0,1)
+   */
+  BootstrapMeasure(measure_ptr const& measure,
+                   variables_ptr const& vars,
+                   std::size_t replicates,
+                   double confidence,
+                   unsigned seed);
+  ~BootstrapMeasure(){};
+
+  result_type compute(EntropyCalculator& ecalc,
+                      Variable::indexes const& tuple) const;
+  void compute(EntropyCalculator& ecalc,
+               Variable::indexes const& tuple,
+               result_type& result) const;
+  /** The entropies are of the unweighted data and not used.
+   */
+  result_type compute(EntropyCalculator& ecalc,
+                      Variable::indexes const& tuple,
+                      Entropy const& e) const;
+  void compute(EntropyCalculator& ecalc,
+                      Variable::indexes const& tuple,
+                      Entropy const& e,
+                      result_type& result) const;
+  std::string header(int d, bool full_output) const;
+  std::vector<std::string> const& names(int d, bool full_output) const;
+
+  /** Replicate entropies are counted here, not by the traversal
+   */
+  bool full_entropy() const { return false; };
+  std::size_t num_values() const { return 4 * measure->num_values(); };
+
+  std::size_t num_replicates() const { return replicates; };
+
+  /** Final values of the measure in each replicate.
+   * @param values one vector of replicate values per final value
+   */
+  void replicate_values(EntropyCalculator& ecalc,
+                        Variable::indexes const& tuple,
+                        std::vector<result_type>& values) const;
+
+  /** Poisson(1) weight of each row in each replicate, row-major. Made by
+   * inversion from std::mt19937 so the weights do not depend on the
+   * standard library.
+   */
+  static std::vector<weight_t> poisson_weights(std::size_t nrow,
+                                               std::size_t replicates,
+                                               unsigned seed);
+
+private:
+  measure_ptr measure;
+  variables_ptr vars;
+  std::size_t replicates;
+  double confidence;
+  std::vector<weight_t> weights;
+  // column names for tuple sizes [1,4], empty where the measure does not
+  // support the size
+  std::vector<std::string> names_d[4];
+  std::vector<std::string> names_d_full[4];
+
+  void count(Variable::indexes const& tuple) const;
+};
+
+class BootstrapMeasureException : public std::exception
+{
+private:
+  std::string msg;
+
+public:
+  BootstrapMeasureException(std::string const& method, std::string const& msg)
+    : msg("BootstrapMeasure::" + method + " : " + msg)
+  {}
+  virtual const char* what() const throw() { return msg.c_str(); };
+};
+
+} // it
+} // mist
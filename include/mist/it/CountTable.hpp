@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "../Variable.hpp"
+#include "Entropy.hpp"
+
+namespace mist {
+namespace it {
+
+/** Integer joint counts of a variable tuple that can be updated in place.
+ *
+ * Unlike Distribution, which is recounted from scratch for every tuple, a
+ * CountTable is kept between computations: rows entering the data are added
+ * and rows leaving it are removed, so the cost of an update is proportional
+ * to the number of changed rows rather than the number of rows. Rows with a
+ * missing value in any variable of the tuple are not counted.
+ */
+class CountTable
+{
+public:
+  using count_t = std::uint32_t;
+  using tuple_t = Variable::indexes;
+
+  CountTable();
+  /** Empty table for variables with the given bins.
+   */
+  CountTable(std::vector<std::size_t> const& bins);
+  /** Count all rows of the tuple variables.
+   *
+   * The bins of each variable are fixed at construction, later rows must have
+   * values within the same bins.
+   */
+  CountTable(Variable::tuple const& vars, tuple_t const& tuple);
+
+  /** Add all rows of the tuple variables to the counts.
+   * @exception CountTableException value outside of the table bins
+   */
+  void add(Variable::tuple const& vars, tuple_t const& tuple);
+  /** Remove all rows of the tuple variables from the counts.
+   * @pre the rows were previously added
+   * @exception CountTableException value outside of the table bins
+   */
+  void remove(Variable::tuple const& vars, tuple_t const& tuple);
+
+  /** Shannon entropy of the counts, identical to counting a Distribution of
+   * the same rows.
+   */
+  entropy_type entropy() const;
+
+  /** Number of counted rows
+   */
+  std::size_t total() const;
+  std::size_t size() const;
+  count_t operator[](std::size_t index) const;
+
+private:
+  std::vector<count_t> counts;
+  std::vector<std::size_t> strides;
+  std::vector<std::size_t> bins;
+  std::size_t _total = 0;
+
+  template<int Sign>
+  void update(Variable::tuple const& vars, tuple_t const& tuple);
+};
+
+class CountTableException : public std::exception
+{
+private:
+  std::string msg;
+
+public:
+  CountTableException(std::string const& method, std::string const& msg)
+    : msg("CountTable::" + method + " : " + msg)
+  {}
+  virtual const char* what() const throw() { return msg.c_str(); };
+};
+
+} // it
+} // mist
@@ -29,6 +29,7 @@ private:
   cache_ptr_type cache1d = 0;
   cache_ptr_type cache2d = 0;
   cache_ptr_type cache3d = 0;
+  cache_ptr_type cache4d = 0;
 
   void init_caches(std::vector<cache_ptr_type> const& caches);
   static entropy_type entropy_it_distribution(Distribution const& pd);
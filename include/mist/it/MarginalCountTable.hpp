@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "../Variable.hpp"
+#include "Entropy.hpp"
+
+namespace mist {
+namespace it {
+
+/** Joint counts of a variable tuple from which the counts of every sub-tuple
+ * are marginals.
+ *
+ * Each variable has an extra bin for missing values, so summing out a
+ * variable keeps the rows where it is missing while a sub-tuple still drops
+ * the rows missing one of its own variables. The entropies of all sub-tuples
+ * are then the same as counting each sub-tuple directly, from a single pass
+ * over the rows.
+ *
+ * The table has several layers of counts for the same cells, e.g. one per
+ * stratum or bootstrap replicate. Counts are stored cell-major, the layers of
+ * a cell are adjacent, so a row adds to all layers at one place in memory.
+ */
+class MarginalCountTable
+{
+public:
+  using count_t = std::uint32_t;
+  using tuple_t = Variable::indexes;
+
+  /** Size the table for a tuple and zero all counts. Buffers are kept
+   * between tuples.
+   * @exception MarginalCountTableException tuple size outside [1,4]
+   */
+  void reset(Variable::tuple const& vars, tuple_t const& tuple, std::size_t layers);
+
+  /** Call visit(row, counts) for each row, where counts points to the layers
+   * of the row's cell.
+   */
+  template<class Visit>
+  void count(Visit visit);
+
+  /** Entropies of every sub-tuple of one layer in the it::d layout.
+   */
+  void entropies(std::size_t layer, Entropy& e);
+
+  std::size_t layers() const { return nlayers; };
+
+private:
+  Variable const* vars[4];
+  std::size_t d = 0;
+  std::size_t bins[4];
+  std::size_t strides[4];
+  std::size_t cells = 0;
+  std::size_t nlayers = 0;
+  std::vector<count_t> counts;
+  std::vector<count_t> marginal;
+  // sub-tuple cell of each table cell, -1 if a sub-tuple variable is
+  // missing, for the bins it was made for
+  std::vector<int> cell_map;
+  std::vector<std::size_t> sub_size;
+  std::vector<std::size_t> map_bins;
+
+  template<int D, class Visit>
+  void count_rows(Visit& visit);
+  void make_cell_map();
+};
+
+template<int D, class Visit>
+void
+MarginalCountTable::count_rows(Visit& visit)
+{
+  Variable::const_iterator cols[D];
+  std::size_t missing[D];
+  std::size_t stride[D];
+  for (int ii = 0; ii < D; ii++) {
+    cols[ii] = vars[ii]->begin();
+    missing[ii] = bins[ii];
+    stride[ii] = strides[ii];
+  }
+  auto nrow = vars[0]->size();
+  auto table = counts.data();
+  for (std::size_t row = 0; row < nrow; row++) {
+    std::size_t cell = 0;
+    for (int ii = 0; ii < D; ii++) {
+      auto v = cols[ii][row];
+      cell += stride[ii] * ((VARIABLE_MISSING_VAL(v)) ? missing[ii] : v);
+    }
+    visit(row, table + cell * nlayers);
+  }
+}
+
+template<class Visit>
+void
+MarginalCountTable::count(Visit visit)
+{
+  switch (d) {
+    case 1:
+      count_rows<1>(visit);
+      break;
+    case 2:
+      count_rows<2>(visit);
+      break;
+    case 3:
+      count_rows<3>(visit);
+      break;
+    case 4:
+      count_rows<4>(visit);
+      break;
+  }
+}
+
+class MarginalCountTableException : public std::exception
+{
+private:
+  std::string msg;
+
+public:
+  MarginalCountTableException(std::string const& method, std::string const& msg)
+    : msg("MarginalCountTable::" + method + " : " + msg)
+  {}
+  virtual const char* what() const throw() { return msg.c_str(); };
+};
+
+} // it
+} // mist
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <limits>
 #include <string>
 
 #include "../Variable.hpp"
@@ -61,6 +62,29 @@ public:
   /** Whether this measure uses intermediate entropy calculations
    */
   virtual bool full_entropy() const = 0;
+
+  /** Number of final values at the end of the result, output when
+   * intermediate results are not. The last of them is compared against the
+   * cutoff.
+   */
+  virtual std::size_t num_values() const { return 1; };
+
+  /**
+   * Upper bound on the final result from the entropies of all proper
+   * sub-tuples, i.e. every entropy except the full joint entropy (the last
+   * element of the it::d3 or it::d4 layout, which is ignored). Lets the
+   * traversal skip the most expensive count when the result cannot reach
+   * the cutoff. Bounds rely on the entropy inequalities, which only hold
+   * when there is no missing data.
+   *
+   * @param partial entropies in the it::d3 or it::d4 layout
+   * @param d tuple size
+   * @return upper bound, or infinity if no bound is known
+   */
+  virtual data_t upper_bound(Entropy const& partial, int d) const
+  {
+    return std::numeric_limits<data_t>::infinity();
+  };
 };
 
 } // it
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <memory>
+
+#include "../Variable.hpp"
+
+#include "Entropy.hpp"
+#include "EntropyCalculator.hpp"
+#include "Measure.hpp"
+
+namespace mist {
+namespace it {
+
+/** Evaluate several measures for each tuple in a single traversal.
+ *
+ * All measures are computed from the same entropies, so the distributions
+ * are counted once no matter how many measures are listed. The result holds
+ * the sub calculations of each measure in list order, followed by the final
+ * value of each measure in list order. The last measure in the list is the
+ * one compared against the cutoff and used for top-K results and bounds.
+ */
+class MeasureList : public Measure
+{
+public:
+  using measure_ptr = std::shared_ptr<Measure>;
+
+  MeasureList(std::vector<measure_ptr> const& measures);
+  ~MeasureList(){};
+
+  result_type compute(EntropyCalculator& ecalc,
+                      Variable::indexes const& tuple) const;
+  void compute(EntropyCalculator& ecalc,
+               Variable::indexes const& tuple,
+               result_type& result) const;
+  result_type compute(EntropyCalculator& ecalc,
+                      Variable::indexes const& tuple,
+                      Entropy const& e) const;
+  void compute(EntropyCalculator& ecalc,
+                      Variable::indexes const& tuple,
+                      Entropy const& e,
+                      result_type& result) const;
+  std::string header(int d, bool full_output) const;
+  std::vector<std::string> const& names(int d, bool full_output) const;
+
+  bool full_entropy() const { return full; };
+  std::size_t num_values() const { return nvalues; };
+  data_t upper_bound(Entropy const& partial, int d) const;
+
+  std::vector<measure_ptr> const& get_measures() const { return measures; };
+
+private:
+  std::vector<measure_ptr> measures;
+  bool full = false;
+  std::size_t nvalues = 0;
+  // column names for tuple sizes [1,4], empty where a measure does not
+  // support the size
+  std::vector<std::string> names_d[4];
+  std::vector<std::string> names_d_full[4];
+
+  void gather(std::vector<result_type> const& results,
+              result_type& result) const;
+};
+
+class MeasureListException : public std::exception
+{
+private:
+  std::string msg;
+
+public:
+  MeasureListException(std::string const& method, std::string const& msg)
+    : msg("MeasureList::" + method + " : " + msg)
+  {}
+  virtual const char* what() const throw() { return msg.c_str(); };
+};
+
+} // it
+} // mist
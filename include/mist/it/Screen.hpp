@@ -0,0 +1,60 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "Entropy.hpp"
+
+namespace mist {
+namespace it {
+
+/** Predicate on the entropies of a variable pair, used to prune the search
+ * space before higher order tuples containing the pair are computed.
+ */
+class Screen
+{
+public:
+  Screen(entropy_type threshold)
+    : threshold(threshold){};
+  virtual ~Screen(){};
+
+  /** Whether the pair passes the screen
+   * @param e0 entropy of the first variable
+   * @param e1 entropy of the second variable
+   * @param e01 joint entropy of the pair
+   */
+  virtual bool pass(entropy_type e0,
+                    entropy_type e1,
+                    entropy_type e01) const = 0;
+  virtual std::string name() const = 0;
+  entropy_type get_threshold() const { return threshold; };
+
+protected:
+  entropy_type threshold;
+};
+
+/** Pass pairs with mutual information I(0;1) = H(0) + H(1) - H(0,1) of at
+ * least threshold.
+ */
+class MutualInformationScreen : public Screen
+{
+public:
+  MutualInformationScreen(entropy_type threshold)
+    : Screen(threshold){};
+  bool pass(entropy_type e0, entropy_type e1, entropy_type e01) const;
+  std::string name() const { return "MutualInformation"; };
+};
+
+/** Pass pairs with joint entropy H(0,1) of at least threshold.
+ */
+class JointEntropyScreen : public Screen
+{
+public:
+  JointEntropyScreen(entropy_type threshold)
+    : Screen(threshold){};
+  bool pass(entropy_type e0, entropy_type e1, entropy_type e01) const;
+  std::string name() const { return "JointEntropy"; };
+};
+
+} // it
+} // mist
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "../Variable.hpp"
+
+#include "Entropy.hpp"
+#include "EntropyCalculator.hpp"
+#include "MarginalCountTable.hpp"
+#include "Measure.hpp"
+
+namespace mist {
+namespace it {
+
+/** Evaluate a measure separately on each stratum of the samples.
+ *
+ * Each sample has a stratum label, e.g. case and control, and the measure is
+ * computed as if the samples of every stratum were searched on their own. The
+ * joint counts of all strata are made in a single pass over the rows, with
+ * the label as one more axis of a MarginalCountTable, so all sub-tuple
+ * entropies of all strata come from that one table.
+ *
+ * The result holds the sub calculations of each stratum in label order,
+ * followed by the final values of each stratum, and optionally the
+ * difference of each stratum's final values from those of stratum 0. The
+ * last value is compared against the cutoff.
+ */
+class StratifiedMeasure : public Measure
+{
+public:
+  using measure_ptr = std::shared_ptr<Measure>;
+  using variables_ptr = std::shared_ptr<Variable::tuple>;
+  using weights_ptr = std::shared_ptr<std::vector<std::uint32_t>>;
+
+  /**
+   * @param measure measure evaluated on each stratum
+   * @param vars variables the tuples index
+   * @param strata stratum label of each sample, one bin per stratum
+   * @param differences whether to append differences from stratum 0
+   * @param weights optional count of each sample, e.g. its multiplicity
+   * @exception StratifiedMeasureException strata and variables differ in
+   *            size, or fewer than two strata with differences
+   */
+  StratifiedMeasure(measure_ptr const& measure,
+                    variables_ptr const& vars,
+                    Variable const& strata,
+                    bool differences,
+                    weights_ptr const& weights = nullptr);
+  ~StratifiedMeasure(){};
+
+  result_type compute(EntropyCalculator& ecalc,
+                      Variable::indexes const& tuple) const;
+  void compute(EntropyCalculator& ecalc,
+               Variable::indexes const& tuple,
+               result_type& result) const;
+  /** The entropies are of the pooled samples and not used.
+   */
+  result_type compute(EntropyCalculator& ecalc,
+                      Variable::indexes const& tuple,
+                      Entropy const& e) const;
+  void compute(EntropyCalculator& ecalc,
+                      Variable::indexes const& tuple,
+                      Entropy const& e,
+                      result_type& result) const;
+  std::string header(int d, bool full_output) const;
+  std::vector<std::string> const& names(int d, bool full_output) const;
+
+  /** Stratum entropies are counted here, not by the traversal
+   */
+  bool full_entropy() const { return false; };
+  std::size_t num_values() const { return nvalues; };
+
+  std::size_t num_strata() const { return nstrata; };
+
+  /** Entropies of every sub-tuple in each stratum, in the it::d layout.
+   * @param entropies one vector per stratum
+   */
+  void stratum_entropies(Variable::indexes const& tuple,
+                         std::vector<Entropy>& entropies) const;
+
+private:
+  measure_ptr measure;
+  variables_ptr vars;
+  Variable strata;
+  std::size_t nstrata;
+  bool differences;
+  weights_ptr weights;
+  std::size_t nvalues;
+  // column names for tuple sizes [1,4], empty where the measure does not
+  // support the size
+  std::vector<std::string> names_d[4];
+  std::vector<std::string> names_d_full[4];
+};
+
+class StratifiedMeasureException : public std::exception
+{
+private:
+  std::string msg;
+
+public:
+  StratifiedMeasureException(std::string const& method, std::string const& msg)
+    : msg("StratifiedMeasure::" + method + " : " + msg)
+  {}
+  virtual const char* what() const throw() { return msg.c_str(); };
+};
+
+} // it
+} // mist
@@ -88,6 +88,7 @@ public:
   };
 
   bool full_entropy() const { return true; };
+  data_t upper_bound(Entropy const& partial, int d) const;
 };
 
 class SymmetricDeltaException : public std::exception
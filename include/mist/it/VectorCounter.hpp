@@ -1,5 +1,9 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 #include "Counter.hpp"
 
 namespace mist {
@@ -8,16 +12,28 @@ namespace it {
 /**
  * Generates a ProbabilityDistribution from a Variable tuple.
  *
- * Counts using standard algorithm.
+ * Counts using standard algorithm. Optionally each row is counted by an
+ * integer weight, e.g. the multiplicity of a deduplicated sample.
  */
 class VectorCounter : public Counter
 {
 public:
+  using weight_t = std::uint32_t;
+  using weights_ptr = std::shared_ptr<std::vector<weight_t>>;
+
   VectorCounter(){};
+  /** Count each row by its weight
+   * @param weights one weight per row, or null to count each row once
+   */
+  VectorCounter(weights_ptr const& weights)
+    : weights(weights){};
   ~VectorCounter(){};
   void count(Variable const&, Distribution&);
   void count(Variable::tuple const&, Distribution&);
   void count(Variable::tuple const&, Variable::indexes const&, Distribution&);
+
+private:
+  weights_ptr weights;
 };
 
 class VectorCounterException : public std::exception
@@ -16,3 +16,28 @@ namespace np = boost::numpy;
 namespace np = boost::python::numpy;
 #endif
 #endif
+
+#ifdef BOOST_PYTHON_EXTENSIONS
+#include <memory>
+
+namespace mist {
+
+/** Python capsule holding a reference to a buffer, the owner of Numpy arrays
+ * made with np::from_data over the buffer. The buffer lives until the last
+ * array over it is collected, however long the C++ side keeps it.
+ */
+inline p::object
+py_owner(std::shared_ptr<void> const& buffer)
+{
+  PyObject* capsule =
+    PyCapsule_New(new std::shared_ptr<void>(buffer), nullptr, [](PyObject* c) {
+      delete static_cast<std::shared_ptr<void>*>(PyCapsule_GetPointer(c, nullptr));
+    });
+  if (!capsule) {
+    p::throw_error_already_set();
+  }
+  return p::object(p::handle<>(capsule));
+}
+
+} // mist
+#endif
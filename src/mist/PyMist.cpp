@@ -18,6 +18,12 @@ namespace np = boost::python::numpy;
 
 using namespace mist;
 
+static p::object
+iterator_self(p::object const& self)
+{
+  return self;
+}
+
 BOOST_PYTHON_MODULE(libmist)
 {
   Py_Initialize();
@@ -33,10 +39,31 @@ BOOST_PYTHON_MODULE(libmist)
 
   p::class_<algorithm::TupleSpace>("TupleSpace")
     .def(p::init<int,int>())
+    .def(p::init<int,int,int>())
     .def("count_tuples", &algorithm::TupleSpace::count_tuples)
     .def("addVariableGroup", &algorithm::TupleSpace::pyAddVariableGroup)
     .def("addVariableGroupTuple",
-         &algorithm::TupleSpace::pyAddVariableGroupTuple);
+         &algorithm::TupleSpace::pyAddVariableGroupTuple)
+    .def("addTuple", &algorithm::TupleSpace::pyAddTuple)
+    .def("addTuples", &algorithm::TupleSpace::pyAddTuples)
+    .def("loadTupleFile", &algorithm::TupleSpace::loadTupleFile)
+    .def("loadTupleFileBinary", &algorithm::TupleSpace::loadTupleFileBinary)
+    .def("sortTuples", &algorithm::TupleSpace::sortTuples);
+
+  p::class_<io::BatchQueue, std::shared_ptr<io::BatchQueue>, boost::noncopyable>(
+    "ResultBatches", p::no_init)
+    .def("__iter__", &iterator_self)
+    .def("__next__", &io::BatchQueue::py_next);
+
+  p::class_<io::SketchOutputStream, std::shared_ptr<io::SketchOutputStream>, boost::noncopyable>(
+    "ResultSketch", p::no_init)
+    .add_property("count", &io::SketchOutputStream::count)
+    .add_property("min", &io::SketchOutputStream::min)
+    .add_property("max", &io::SketchOutputStream::max)
+    .add_property("accuracy", &io::SketchOutputStream::get_accuracy)
+    .def("quantile", &io::SketchOutputStream::quantile)
+    .def("top_fraction_cutoff", &io::SketchOutputStream::top_fraction_cutoff)
+    .def("buckets", &io::SketchOutputStream::py_buckets);
 
   p::class_<Search>("Search")
     .add_property("cutoff", &Search::get_cutoff, &Search::set_cutoff)
@@ -45,6 +72,29 @@ BOOST_PYTHON_MODULE(libmist)
                   &Search::get_probability_algorithm,
                   &Search::set_probability_algorithm)
     .add_property("outfile", &Search::get_outfile, &Search::set_outfile)
+    .add_property("output_format",
+                  &Search::get_output_format,
+                  &Search::set_output_format)
+    .add_property("output_precision",
+                  &Search::get_output_precision,
+                  &Search::set_output_precision)
+    .def("start_batches", &Search::python_start_batches)
+    .add_property("results_map_file",
+                  &Search::get_results_map_file,
+                  &Search::set_results_map_file)
+    .add_property("compact_results", &Search::get_compact_results_enabled)
+    .def("set_compact_results", &Search::set_compact_results)
+    .def("get_compact_results", &Search::python_get_compact_results)
+    .def("decode_tuple", &Search::python_decode_tuple)
+    .add_property("pair_matrix", &Search::get_pair_matrix_enabled, &Search::set_pair_matrix)
+    .def("get_pair_matrix", &Search::python_get_pair_matrix)
+    .def("get_pair_matrix_names", &Search::python_get_pair_matrix_names)
+    .add_property("ordered_output",
+                  &Search::get_ordered_output,
+                  &Search::set_ordered_output)
+    .add_property("output_shards", &Search::get_output_shards)
+    .def("set_output_shards", &Search::set_output_shards)
+    .def("merge_shards", &Search::merge_shards)
     .add_property("output_intermediate",
                   &Search::get_output_intermediate,
                   &Search::set_output_intermediate)
@@ -58,6 +108,7 @@ BOOST_PYTHON_MODULE(libmist)
       "tuple_limit", &Search::get_tuple_limit, &Search::set_tuple_limit)
     .add_property(
       "tuple_size", &Search::get_tuple_size, &Search::set_tuple_size)
+    .add_property("top_k", &Search::get_top_k, &Search::set_top_k)
     .add_property(
       "tuple_space", &Search::get_tuple_space, &Search::set_tuple_space)
     .add_property(
@@ -68,6 +119,44 @@ BOOST_PYTHON_MODULE(libmist)
       "cache_size_bytes",
       &Search::get_cache_size_bytes,
       &Search::set_cache_size_bytes)
+    .add_property("checkpoint", &Search::get_checkpoint)
+    .add_property(
+      "incremental", &Search::get_incremental, &Search::set_incremental)
+    .add_property("incremental_results",
+                  &Search::get_incremental_results,
+                  &Search::set_incremental_results)
+    .add_property("screen", &Search::get_screen)
+    .add_property("screen_threshold", &Search::get_screen_threshold)
+    .def("set_screen", &Search::set_screen)
+    .def("save_top_k", &Search::save_top_k)
+    .def("merge_top_k", &Search::merge_top_k)
+    .add_property("result_sketch", &Search::get_result_sketch_enabled)
+    .def("set_result_sketch", &Search::set_result_sketch)
+    .def("get_result_sketch", &Search::python_get_result_sketch)
+    .def("save_result_sketch", &Search::save_result_sketch)
+    .def("merge_result_sketch", &Search::merge_result_sketch)
+    .def("estimate_cutoff", &Search::estimate_cutoff)
+    .add_property("permutations", &Search::get_permutations)
+    .def("set_permutations", &Search::python_set_permutations)
+    .add_property("strata", &Search::get_strata)
+    .def("set_strata", &Search::set_strata)
+    .add_property(
+      "deduplicate", &Search::get_deduplicate, &Search::set_deduplicate)
+    .add_property(
+      "compact_bins", &Search::get_compact_bins, &Search::set_compact_bins)
+    .def("get_bin_values", &Search::python_get_bin_values)
+    .add_property("reduce_variables", &Search::get_reduce_variables)
+    .def("set_reduce_variables", &Search::set_reduce_variables)
+    .add_property("bootstrap", &Search::get_bootstrap)
+    .def("set_bootstrap", &Search::set_bootstrap)
+    .def("set_checkpoint", &Search::set_checkpoint)
+    .def("resume", &Search::resume)
+    .def("add_samples", &Search::add_samples)
+    .def("remove_samples", &Search::remove_samples)
+    .def("slide_samples", &Search::slide_samples)
+    .def("append_variables", &Search::append_variables)
+    .def("start_coordinator", &Search::start_coordinator)
+    .def("start_worker", &Search::start_worker)
     .def("start", &Search::start)
     .def("load_ndarray", &Search::load_ndarray)
     .def("load_file", &Search::load_file)
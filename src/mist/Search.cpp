@@ -1,23 +1,48 @@
 #include <algorithm>
+#include <cerrno>
 #include <chrono>
 #include <cstdlib>
+#include <cstring>
 #include <exception>
 #include <iostream>
 #include <limits>
 #include <queue>
+#include <random>
+#include <set>
 #include <memory>
 #include <stdexcept>
 #include <thread>
 #include <vector>
 
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "Search.hpp"
+#include "algorithm/Checkpoint.hpp"
+#include "algorithm/Coordinator.hpp"
+#include "algorithm/PermutationTest.hpp"
 #include "algorithm/TupleSpace.hpp"
+#include "algorithm/VariableReduction.hpp"
 #include "algorithm/Worker.hpp"
+#include "cache/CountCache.hpp"
+#include "cache/Flat1D.hpp"
+#include "cache/Flat2D.hpp"
+#include "io/BatchOutputStream.hpp"
+#include "io/BinaryOutputStream.hpp"
+#include "io/ColumnOutputStream.hpp"
 #include "io/DataMatrix.hpp"
 #include "io/MapOutputStream.hpp"
+#include "io/OrderedWriter.hpp"
+#include "io/PairMatrixOutputStream.hpp"
+#include "io/SketchOutputStream.hpp"
+#include "io/TopKOutputStream.hpp"
 #include "it/BitsetCounter.hpp"
+#include "it/BootstrapMeasure.hpp"
 #include "it/Entropy.hpp"
 #include "it/EntropyCalculator.hpp"
+#include "it/MeasureList.hpp"
+#include "it/Screen.hpp"
+#include "it/StratifiedMeasure.hpp"
 #include "it/SymmetricDelta.hpp"
 #include "it/VectorCounter.hpp"
 
@@ -28,12 +53,23 @@ using output_stream_ptr = std::shared_ptr<io::OutputStream>;
 using file_stream_ptr = std::shared_ptr<io::FileOutputStream>;
 using map_stream_ptr = std::shared_ptr<io::MapOutputStream>;
 using flat_stream_ptr = std::shared_ptr<io::FlatOutputStream>;
+using column_stream_ptr = std::shared_ptr<io::ColumnOutputStream>;
+using pair_matrix_stream_ptr = std::shared_ptr<io::PairMatrixOutputStream>;
+using top_k_stream_ptr = std::shared_ptr<io::TopKOutputStream>;
+using sketch_stream_ptr = std::shared_ptr<io::SketchOutputStream>;
 using measure_ptr = std::shared_ptr<it::Measure>;
+using screen_ptr = std::shared_ptr<it::Screen>;
 using cache_ptr = it::EntropyCalculator::cache_ptr_type;
+using count_cache_ptr = std::shared_ptr<cache::CountCache>;
 using entropy_calc_ptr = std::unique_ptr<it::EntropyCalculator>;
 using counter_ptr = std::shared_ptr<it::Counter>;
 using tuple_space_ptr = std::shared_ptr<algorithm::TupleSpace>;
 using variables_ptr = std::shared_ptr<Variable::tuple>;
+using count_t = algorithm::TupleSpace::count_t;
+
+#define CHECKPOINT_INTERVAL_DEFAULT 600
+// reorder buffer of ordered output, in blocks per thread
+#define ORDERED_BLOCKS_PER_RANK 4
 
 std::string
 Search::version()
@@ -54,22 +90,31 @@ struct thread_config
   std::vector<cache_ptr> caches;
 };
 
-struct Search::impl
+// configuration and state of a Search, copied with it
+struct search_state
 {
   // structures
   data_ptr data;
   file_stream_ptr file_output;
   measure_ptr measure;
+  screen_ptr screen;
   counter_ptr counter;
   std::string measure_str;
   std::vector<cache_ptr> shared_caches;
-  std::vector<flat_stream_ptr> mem_outputs;
+  // in-memory output of each rank, joined into the first after the search
+  std::vector<output_stream_ptr> result_outputs;
+  top_k_stream_ptr top_k_output;
+  sketch_stream_ptr sketch_output;
   std::vector<thread_config> threads;
 
   // config
   it::entropy_type cutoff = -std::numeric_limits<it::entropy_type>::infinity();
   unsigned long cache_size_bytes = 0;
   algorithm::TupleSpace::index_t tuple_limit = 0;
+  std::size_t top_k = 0;
+  // histogram of the results, merged over the ranks
+  bool result_sketch = false;
+  double sketch_accuracy = io::SketchOutputStream::ACCURACY_DEFAULT;
   bool use_cache = true;
   bool full_output = false;
   bool in_memory_output = true;
@@ -84,9 +129,94 @@ struct Search::impl
   probability_algorithms probability_algorithm;
   std::string probability_algorithm_str;
   std::string outfile;
+  std::string output_format = "csv";
+  int output_precision = 6;
+  // each thread writes a shard of the outfile, optionally merged after
+  bool output_shards = false;
+  bool merge_shards = false;
+  // file output written in tuple order
+  bool ordered_output = false;
+  // in-memory results as typed columns
+  bool compact_results = false;
+  std::vector<std::size_t> compact_value_sizes;
+  bool compact_tuple_numbers = false;
+  std::vector<std::string> compact_names;
+  // in-memory results of pairs as packed triangular matrices
+  bool pair_matrix = false;
+  std::vector<std::string> pair_matrix_names;
+  // rows of each batch of start_batches
+  std::size_t batch_rows = 0;
+  // file the in-memory results are mapped from
+  std::string map_file;
+  // tuple space the compact tuple numbers refer to
+  tuple_space_ptr results_tuple_space;
   tuple_space_ptr tuple_space;
+  // checkpoint
+  std::string checkpoint_file;
+  int checkpoint_interval = 0;
+  bool resuming = false;
+  algorithm::Checkpoint::state resume_state;
+  // incremental samples, count tables are kept for the tuple space they
+  // were made for
+  bool incremental = false;
+  bool incremental_results = false;
+  std::vector<count_cache_ptr> count_caches;
+  tuple_space_ptr count_tuple_space;
+  // appended variables, the last search covered searched_nvar variables and
+  // a delta search covers only tuples with a variable from delta_nvar on
+  bool custom_tuple_space = false;
+  std::size_t searched_nvar = 0;
+  int searched_tuple_size = 0;
+  std::size_t delta_nvar = 0;
+  std::size_t cache_nvar = 0;
+  // permutation test
+  std::size_t permutations = 0;
+  Variable::indexes permuted;
+  unsigned permutation_seed = 0;
+  // stratum label column taken out of the data
+  int strata_column = -1;
+  bool strata_differences = false;
+  // collapse identical samples at load time
+  bool deduplicate = false;
+  // remap values to contiguous bins at load time
+  bool compact_bins = false;
+  // bootstrap replicates
+  std::size_t bootstrap_replicates = 0;
+  double bootstrap_confidence = 0.95;
+  unsigned bootstrap_seed = 0;
+  // leave constant and duplicate variables out of the tuple space
+  bool reduce_variables = false;
+  bool expand_duplicates = true;
+};
+
+// search of start_batches and the queue of batches it fills, running on the
+// Search until finish_batches. Copies of the Search do not share it.
+struct batch_search
+{
+  std::thread thread;
+  std::shared_ptr<io::BatchQueue> queue;
+
+  batch_search() = default;
+  batch_search(batch_search const&) = delete;
+  batch_search& operator=(batch_search const&) = delete;
+  batch_search(batch_search&&) = default;
+  batch_search& operator=(batch_search&&) = default;
+};
+
+struct Search::impl : search_state
+{
+  batch_search batches;
 };
 
+// In-memory results of the last search as a Stream, null when they are of
+// another kind
+template<typename Stream>
+static std::shared_ptr<Stream>
+joined_results(std::vector<output_stream_ptr> const& outputs)
+{
+  return (outputs.empty()) ? nullptr : std::dynamic_pointer_cast<Stream>(outputs.front());
+}
+
 Search::Search()
   : pimpl(std::make_unique<impl>())
 {
@@ -107,31 +237,87 @@ Search::Search()
 Search::Search(const Search& other)
   : pimpl(std::make_unique<impl>())
 {
-  *this->pimpl = *other.pimpl;
+  static_cast<search_state&>(*this->pimpl) = *other.pimpl;
 };
 
-Search::Search(Search&&) = default;
+// The search of start_batches runs on the Search it was started on, so it
+// is finished before the state moves
+Search::Search(Search&& other)
+{
+  other.finish_batches();
+  pimpl = std::move(other.pimpl);
+}
+
 Search&
-Search::operator=(Search&&) = default;
-Search::~Search() {}
+Search::operator=(Search&& other)
+{
+  if (this != &other) {
+    finish_batches();
+    other.finish_batches();
+    pimpl = std::move(other.pimpl);
+  }
+  return *this;
+}
 
-void
-Search::set_measure(std::string const& measure)
+Search::~Search()
+{
+  finish_batches();
+}
+
+static measure_ptr
+make_measure(std::string const& measure, std::string& name)
 {
   std::string test(measure);
   transform(test.begin(), test.end(), test.begin(), ::tolower);
 
   if (test == "symmetricdelta") {
-    pimpl->measure = measure_ptr(new it::SymmetricDelta());
-    pimpl->measure_str = "SymmetricDelta";
+    name = "SymmetricDelta";
+    return measure_ptr(new it::SymmetricDelta());
   } else if (test == "entropy") {
-    pimpl->measure = measure_ptr(new it::EntropyMeasure());
-    pimpl->measure_str = "JointEntropy";
-  } else {
-    throw SearchException("set_measure",
-                          "Invalid measure: " + measure +
-                            ", allowed: [SymmetricDelta,Entropy]");
+    name = "JointEntropy";
+    return measure_ptr(new it::EntropyMeasure());
+  }
+  throw SearchException("set_measure",
+                        "Invalid measure: " + measure +
+                          ", allowed: [SymmetricDelta,Entropy]");
+}
+
+void
+Search::set_measure(std::string const& measure)
+{
+  // comma-separated list of measures
+  if (measure.find(',') != std::string::npos) {
+    std::vector<std::string> measures;
+    std::size_t pos = 0;
+    while (pos <= measure.size()) {
+      auto end = std::min(measure.find(',', pos), measure.size());
+      measures.push_back(measure.substr(pos, end - pos));
+      pos = end + 1;
+    }
+    set_measures(measures);
+    return;
+  }
+  pimpl->searched_nvar = 0;
+  pimpl->measure = make_measure(measure, pimpl->measure_str);
+}
+
+void
+Search::set_measures(std::vector<std::string> const& measures)
+{
+  if (measures.size() == 1) {
+    set_measure(measures.front());
+    return;
   }
+  std::vector<measure_ptr> list;
+  std::string names;
+  for (auto const& measure : measures) {
+    std::string name;
+    list.push_back(make_measure(measure, name));
+    names += (names.empty()) ? name : "," + name;
+  }
+  pimpl->searched_nvar = 0;
+  pimpl->measure = measure_ptr(new it::MeasureList(list));
+  pimpl->measure_str = names;
 }
 
 std::string
@@ -152,6 +338,37 @@ Search::get_cutoff()
   return pimpl->cutoff;
 }
 
+void
+Search::set_screen(std::string const& screen, it::entropy_type threshold)
+{
+  std::string test(screen);
+  transform(test.begin(), test.end(), test.begin(), ::tolower);
+
+  if (test == "none") {
+    pimpl->screen = nullptr;
+  } else if (test == "mutualinformation") {
+    pimpl->screen = screen_ptr(new it::MutualInformationScreen(threshold));
+  } else if (test == "jointentropy") {
+    pimpl->screen = screen_ptr(new it::JointEntropyScreen(threshold));
+  } else {
+    throw SearchException("set_screen",
+                          "Invalid screen: " + screen +
+                            ", allowed: [None,MutualInformation,JointEntropy]");
+  }
+}
+
+std::string
+Search::get_screen()
+{
+  return (pimpl->screen) ? pimpl->screen->name() : "None";
+}
+
+it::entropy_type
+Search::get_screen_threshold()
+{
+  return (pimpl->screen) ? pimpl->screen->get_threshold() : 0;
+}
+
 
 void
 Search::set_probability_algorithm(std::string const& algorithm)
@@ -198,12 +415,52 @@ Search::get_outfile()
 np::ndarray
 Search::python_get_results()
 {
-  if (pimpl->mem_outputs.empty()) {
+  auto results = joined_results<io::FlatOutputStream>(pimpl->result_outputs);
+  if (!results) {
     // don't throw, just give the goose
     return np::zeros(p::make_tuple(0, 0), np::dtype::get_builtin<double>());
   } else {
-    return pimpl->mem_outputs.front()->py_get_results();
+    return results->py_get_results(pimpl->ranks);
+  }
+}
+
+p::dict
+Search::python_get_compact_results()
+{
+  p::dict columns;
+  if (auto out = joined_results<io::ColumnOutputStream>(pimpl->result_outputs)) {
+    for (std::size_t ii = 0; ii < out->num_columns(); ii++) {
+      columns[pimpl->compact_names[ii]] = out->py_get_column(ii);
+    }
+  }
+  return columns;
+}
+
+np::ndarray
+Search::python_get_pair_matrix()
+{
+  get_pair_matrix();
+  return joined_results<io::PairMatrixOutputStream>(pimpl->result_outputs)->py_get_planes();
+}
+
+p::list
+Search::python_get_pair_matrix_names()
+{
+  p::list names;
+  for (auto const& name : pimpl->pair_matrix_names) {
+    names.append(name);
+  }
+  return names;
+}
+
+p::list
+Search::python_decode_tuple(std::size_t tuple_no)
+{
+  p::list tuple;
+  for (auto v : decode_tuple(tuple_no)) {
+    tuple.append(v);
   }
+  return tuple;
 }
 #endif
 
@@ -212,11 +469,149 @@ Search::python_get_results()
 std::vector<it::entropy_type> const&
 Search::get_results()
 {
-  if (pimpl->mem_outputs.empty()) {
+  auto results = joined_results<io::FlatOutputStream>(pimpl->result_outputs);
+  if (!results) {
     throw SearchException("get_results", "No results in memory");
+  } else if (results->get_mapped_results()) {
+    throw SearchException("get_results", "Results are mapped from file '" + pimpl->map_file + "', read the file instead.");
   } else {
-    return pimpl->mem_outputs.front()->get_results();
+    return results->get_results(pimpl->ranks);
+  }
+}
+
+std::shared_ptr<io::BatchQueue>
+Search::start_batches(std::size_t batch_rows, std::size_t max_batches)
+{
+  finish_batches();
+  auto queue = std::make_shared<io::BatchQueue>(
+    (max_batches) ? max_batches : 2 * pimpl->ranks);
+  pimpl->batch_rows = batch_rows;
+  pimpl->batches.queue = queue;
+  pimpl->batches.thread = std::thread([this, queue] {
+    try {
+      _start(nullptr);
+    } catch (...) {
+      queue->fail(std::current_exception());
+    }
+    queue->close();
+  });
+  return queue;
+}
+
+// Abandon the batches of a running search and wait for it to finish. The
+// queue is only reset once the thread no longer reads it.
+void
+Search::finish_batches()
+{
+  if (pimpl && pimpl->batches.thread.joinable()) {
+    pimpl->batches.queue->cancel();
+    pimpl->batches.thread.join();
+    pimpl->batches.queue = nullptr;
+  }
+}
+
+#if BOOST_PYTHON_EXTENSIONS
+std::shared_ptr<io::BatchQueue>
+Search::python_start_batches(std::size_t batch_rows)
+{
+  return start_batches(batch_rows, 0);
+}
+#endif
+
+void
+Search::set_results_map_file(std::string const& filename)
+{
+  pimpl->map_file = filename;
+}
+std::string
+Search::get_results_map_file()
+{
+  return pimpl->map_file;
+}
+
+void
+Search::set_compact_results(bool enabled,
+                            std::string const& value_types,
+                            bool tuple_numbers)
+{
+  std::vector<std::size_t> sizes;
+  std::size_t begin = 0;
+  while (begin <= value_types.size()) {
+    auto end = std::min(value_types.find(',', begin), value_types.size());
+    auto type = value_types.substr(begin, end - begin);
+    if (type == "float32") {
+      sizes.push_back(sizeof(float));
+    } else if (type == "float64") {
+      sizes.push_back(sizeof(double));
+    } else {
+      throw SearchException("set_compact_results",
+                            "Unknown value type '" + type + "', use float32 or float64.");
+    }
+    begin = end + 1;
+  }
+  pimpl->compact_results = enabled;
+  pimpl->compact_value_sizes = sizes;
+  pimpl->compact_tuple_numbers = tuple_numbers;
+}
+bool
+Search::get_compact_results_enabled()
+{
+  return pimpl->compact_results;
+}
+
+io::ColumnOutputStream const&
+Search::get_compact_results()
+{
+  auto results = joined_results<io::ColumnOutputStream>(pimpl->result_outputs);
+  if (!results) {
+    throw SearchException("get_compact_results", "No compact results in memory");
+  }
+  return *results;
+}
+
+std::vector<std::string> const&
+Search::get_compact_result_names()
+{
+  return pimpl->compact_names;
+}
+
+void
+Search::set_pair_matrix(bool enabled)
+{
+  pimpl->pair_matrix = enabled;
+}
+bool
+Search::get_pair_matrix_enabled()
+{
+  return pimpl->pair_matrix;
+}
+
+io::PairMatrixOutputStream const&
+Search::get_pair_matrix()
+{
+  auto results = joined_results<io::PairMatrixOutputStream>(pimpl->result_outputs);
+  if (!results) {
+    throw SearchException("get_pair_matrix", "No pair matrix in memory");
+  }
+  return *results;
+}
+
+std::vector<std::string> const&
+Search::get_pair_matrix_names()
+{
+  return pimpl->pair_matrix_names;
+}
+
+Variable::indexes
+Search::decode_tuple(std::size_t tuple_no)
+{
+  if (!pimpl->results_tuple_space) {
+    throw SearchException("decode_tuple", "No compact results with tuple numbers in memory");
   }
+  if (tuple_no >= pimpl->results_tuple_space->count_tuples()) {
+    throw SearchException("decode_tuple", "Tuple number " + std::to_string(tuple_no) + " out of range");
+  }
+  return pimpl->results_tuple_space->get_tuple(tuple_no);
 }
 
 void
@@ -239,7 +634,9 @@ void
 Search::set_tuple_space(algorithm::TupleSpace const& ts)
 {
   pimpl->tuple_space = tuple_space_ptr(new algorithm::TupleSpace(ts));
+  pimpl->tuple_space->sortTuples();
   pimpl->tuple_size = ts.tupleSize();
+  pimpl->custom_tuple_space = true;
 }
 algorithm::TupleSpace
 Search::get_tuple_space()
@@ -259,264 +656,1190 @@ Search::get_tuple_limit()
 }
 
 void
-Search::set_show_progress(bool show_progress)
+Search::set_checkpoint(std::string const& filename, int interval_seconds)
 {
-  pimpl->show_progress = show_progress;
+  if (interval_seconds <= 0) {
+    throw SearchException("set_checkpoint", "Checkpoint interval must be positive.");
+  }
+  pimpl->checkpoint_file = filename;
+  pimpl->checkpoint_interval = interval_seconds;
 }
-bool
-Search::get_show_progress()
+std::string
+Search::get_checkpoint()
 {
-  return pimpl->show_progress;
+  return pimpl->checkpoint_file;
 }
 
 void
-Search::set_ranks(int ranks)
+Search::resume(std::string const& checkpoint)
 {
-  pimpl->ranks = (!ranks) ? std::thread::hardware_concurrency() : ranks;
+  auto state = algorithm::Checkpoint::read_file(checkpoint);
+  pimpl->resume_state = state;
+  pimpl->resuming = true;
+  pimpl->outfile = state.outfile;
+  pimpl->in_memory_output = false;
+  pimpl->ranks = state.next.size();
+  pimpl->start_rank = state.start_rank;
+  pimpl->total_ranks = state.total_ranks;
+  pimpl->parallel_search = (state.total_ranks != pimpl->ranks);
+  // keep checkpointing to the same file
+  pimpl->checkpoint_file = checkpoint;
+  if (!pimpl->checkpoint_interval) {
+    pimpl->checkpoint_interval = CHECKPOINT_INTERVAL_DEFAULT;
+  }
+  start();
 }
-int
-Search::get_ranks()
+
+// Cut off output written after the checkpoint was taken
+static void
+truncate_outfile(std::string const& filename, count_t offset)
 {
-  return pimpl->ranks;
+  struct stat st;
+  if (stat(filename.c_str(), &st)) {
+    throw SearchException("resume", "Could not open output file '" + filename + "': " + std::strerror(errno));
+  }
+  if ((count_t) st.st_size < offset) {
+    throw SearchException("resume", "Output file '" + filename + "' is shorter than the checkpoint offset.");
+  }
+  if (truncate(filename.c_str(), offset)) {
+    throw SearchException("resume", "Could not truncate output file '" + filename + "': " + std::strerror(errno));
+  }
+}
+
+// Periodically pause the workers and save their positions until all are done
+static void
+wait_checkpoint(algorithm::Checkpoint& checkpoint,
+                algorithm::Checkpoint::state& state,
+                std::string const& filename,
+                int interval,
+                io::FileOutputStream& file_output)
+{
+  std::chrono::seconds sleep_duration(interval);
+  while (!checkpoint.wait_done(sleep_duration)) {
+    state.next = checkpoint.pause_all();
+    try {
+      // the offset is only good if the rows before it survive a crash
+      file_output.sync();
+      state.offset = file_output.tell();
+      algorithm::Checkpoint::write_file(filename, state);
+    } catch (std::exception const& e) {
+      std::cerr << "Search::start: Warning: could not write checkpoint: " << e.what() << "\n";
+    }
+    checkpoint.release();
+  }
 }
 
 void
-Search::set_start_rank(int start_rank)
+Search::set_permutations(std::size_t n,
+                         Variable::indexes const& variables,
+                         unsigned seed)
 {
-  pimpl->start_rank = start_rank;
+  if (n && variables.empty()) {
+    throw SearchException("set_permutations", "No variables to permute.");
+  }
+  pimpl->permutations = n;
+  pimpl->permuted = variables;
+  pimpl->permutation_seed = seed;
 }
-int
-Search::get_start_rank()
+std::size_t
+Search::get_permutations()
 {
-  return pimpl->ranks;
+  return pimpl->permutations;
 }
 
+#if BOOST_PYTHON_EXTENSIONS
 void
-Search::set_total_ranks(int total_ranks)
+Search::python_set_permutations(std::size_t n,
+                                p::list const& variables,
+                                unsigned seed)
 {
-  pimpl->total_ranks = total_ranks;
-  pimpl->parallel_search = true;
+  Variable::indexes vars;
+  for (int ii = 0; ii < p::len(variables); ii++) {
+    p::extract<int> var(variables[ii]);
+    if (!var.check()) {
+      throw SearchException("set_permutations",
+                            "Expected list with elements type int");
+    }
+    vars.push_back(var);
+  }
+  set_permutations(n, vars, seed);
 }
-int
-Search::get_total_ranks()
+
+p::list
+Search::python_get_bin_values(int variable)
 {
-  return pimpl->total_ranks;
+  p::list values;
+  for (auto v : get_bin_values(variable)) {
+    values.append(v);
+  }
+  return values;
+}
+#endif
+
+// Tuples with at least one permuted variable, others first
+static tuple_space_ptr
+permutation_tuple_space(std::size_t nvar,
+                        Variable::indexes const& permuted,
+                        int d)
+{
+  std::vector<bool> is_permuted(nvar, false);
+  for (auto v : permuted) {
+    if (v < nvar) {
+      is_permuted[v] = true;
+    }
+  }
+  algorithm::TupleSpace::tuple_t others, perms;
+  for (std::size_t ii = 0; ii < nvar; ii++) {
+    (is_permuted[ii] ? perms : others).push_back(ii);
+  }
+  auto ts = tuple_space_ptr(new algorithm::TupleSpace());
+  int others_group = (others.empty()) ? -1 : ts->addVariableGroup("others", others);
+  int perms_group = ts->addVariableGroup("permuted", perms);
+  for (int nn = 1; nn <= d; nn++) {
+    if (nn > (int)perms.size() || d - nn > (int)others.size()) {
+      continue;
+    }
+    algorithm::TupleSpace::tuple_t group_tuple(d - nn, others_group);
+    group_tuple.resize(d, perms_group);
+    ts->addVariableGroupTuple(group_tuple);
+  }
+  return ts;
 }
 
 void
-Search::set_output_intermediate(bool full)
+Search::set_strata(int column, bool differences)
 {
-  pimpl->full_output = full;
+  if (!pimpl->data) {
+    throw SearchException("set_strata",
+                          "No data loaded, use load_file or load_ndarray.");
+  }
+  if (pimpl->strata_column >= 0) {
+    throw SearchException("set_strata", "Strata already set for this data.");
+  }
+  if (column < 0) {
+    throw SearchException("set_strata", "Invalid column " + std::to_string(column));
+  }
+  pimpl->data->set_strata(column);
+  pimpl->strata_column = column;
+  pimpl->strata_differences = differences;
+  pimpl->count_caches.clear();
+  pimpl->searched_nvar = 0;
 }
-bool
-Search::get_output_intermediate()
+
+int
+Search::get_strata()
 {
-  return pimpl->full_output;
+  return pimpl->strata_column;
 }
 
 void
-Search::set_cache_enabled(bool enabled)
+Search::set_deduplicate(bool enabled)
 {
-  pimpl->use_cache = enabled;
+  pimpl->deduplicate = enabled;
+  if (enabled && pimpl->data && !pimpl->data->is_deduplicated()) {
+    pimpl->data->deduplicate();
+    pimpl->count_caches.clear();
+  }
 }
+
 bool
-Search::get_cache_enabled()
+Search::get_deduplicate()
 {
-  return pimpl->use_cache;
+  return pimpl->deduplicate;
 }
 
 void
-Search::set_cache_size_bytes(unsigned long size)
+Search::set_compact_bins(bool enabled)
 {
-  pimpl->cache_size_bytes = size;
+  pimpl->compact_bins = enabled;
+  if (enabled && pimpl->data && !pimpl->data->is_compacted()) {
+    pimpl->data->compact_bins();
+    pimpl->count_caches.clear();
+  }
 }
-unsigned long
-Search::get_cache_size_bytes()
+
+bool
+Search::get_compact_bins()
 {
-  return pimpl->cache_size_bytes;
+  return pimpl->compact_bins;
 }
 
-void
-Search::_load_file(std::string const& filename, bool rowmajor)
+std::vector<int>
+Search::get_bin_values(int variable)
 {
-  // TODO invalidate previous results
-  pimpl->data = data_ptr(new io::DataMatrix(filename, rowmajor));
   if (!pimpl->data) {
-    throw SearchException(
-      "load_file", "Failed to create DataMatrix from file '" + filename + "'");
+    throw SearchException("get_bin_values",
+                          "No data loaded, use load_file or load_ndarray.");
   }
+  auto values = pimpl->data->get_bin_values(variable);
+  return std::vector<int>(values.begin(), values.end());
 }
 
 void
-Search::load_file(std::string const& filename)
+Search::set_reduce_variables(bool enabled, bool expand_duplicates)
 {
-  _load_file(filename, true);
+  pimpl->reduce_variables = enabled;
+  pimpl->expand_duplicates = expand_duplicates;
 }
 
-void
-Search::load_file_row_major(std::string const& filename)
+bool
+Search::get_reduce_variables()
 {
-  _load_file(filename, true);
+  return pimpl->reduce_variables;
 }
 
-void
-Search::load_file_column_major(std::string const& filename)
+// Constant and duplicate variables of the complete tuple space, null when
+// the search space is not the complete one
+std::shared_ptr<algorithm::VariableReduction>
+Search::variable_reduction()
 {
-  _load_file(filename, false);
+  if (!pimpl->reduce_variables || pimpl->custom_tuple_space ||
+      pimpl->delta_nvar || pimpl->permutations) {
+    return nullptr;
+  }
+  return std::make_shared<algorithm::VariableReduction>(
+    *pimpl->data->variables(), pimpl->ranks);
 }
 
-#if BOOST_PYTHON_EXTENSIONS
 void
-Search::load_ndarray(np::ndarray const& np)
+Search::set_bootstrap(std::size_t replicates, double confidence, unsigned seed)
 {
-  // TODO invalidate previous results
-  pimpl->data = data_ptr(new io::DataMatrix(np));
-  if (!pimpl->data) {
-    throw SearchException("load_ndarray",
-                          "Failed to create DataMatrix from ndarray");
+  if (replicates && !(confidence > 0 && confidence < 1)) {
+    throw SearchException("set_bootstrap",
+                          "Confidence " + std::to_string(confidence) +
+                            " out of range (0,1)");
   }
+  pimpl->bootstrap_replicates = replicates;
+  pimpl->bootstrap_confidence = confidence;
+  pimpl->bootstrap_seed = seed;
 }
-#endif
 
-void
-Search::printCacheStats()
+std::size_t
+Search::get_bootstrap()
 {
-  int thread_no = 0;
-  for (auto const& thread : pimpl->threads) {
-    int cache_no = 1;
-    if (!thread.caches.empty()) {
-      for (auto cache : thread.caches) {
-        if (cache) {
-          std::cerr << "Thread " << thread_no;
-          std::cerr << " cache " << cache_no;
-          std::cerr << " hits " << cache->hits();
-          std::cerr << " misses " << cache->misses();
-          std::cerr << " evictions " << cache->evictions();
-          std::cerr << std::endl;
-        }
-        cache_no++;
-      }
-    }
-    thread_no++;
-  }
+  return pimpl->bootstrap_replicates;
 }
 
-static counter_ptr
-make_counter(probability_algorithms const& type,
-             variables_ptr const& variables)
+// The configured measure, evaluated per stratum when the data has strata or
+// per bootstrap replicate
+measure_ptr
+Search::search_measure()
 {
-  switch (type) {
-    case probability_algorithms::vector:
-      return counter_ptr(new it::VectorCounter());
+  auto& data = *pimpl->data;
+  if (data.has_strata() && pimpl->bootstrap_replicates) {
+    throw SearchException("start", "Bootstrap replicates cannot be used with strata.");
+  }
+  if (data.has_strata()) {
+    return measure_ptr(new it::StratifiedMeasure(pimpl->measure,
+                                                 data.variables(),
+                                                 data.get_strata(),
+                                                 pimpl->strata_differences,
+                                                 data.multiplicities()));
+  }
+  if (pimpl->bootstrap_replicates && data.is_deduplicated()) {
+    throw SearchException("start", "Bootstrap replicates cannot be used with deduplicated samples.");
+  }
+  if (pimpl->bootstrap_replicates) {
+    return measure_ptr(new it::BootstrapMeasure(pimpl->measure,
+                                                data.variables(),
+                                                pimpl->bootstrap_replicates,
+                                                pimpl->bootstrap_confidence,
+                                                pimpl->bootstrap_seed));
+  }
+  return pimpl->measure;
+}
+
+static std::string
+output_header(measure_ptr const& measure, int d, bool full_output, bool permuting)
+{
+  auto header = measure->header(d, full_output);
+  return (permuting) ? header + ",exceedances" : header;
+}
+
+// Output file stream in the given format, see set_output_format
+static file_stream_ptr
+make_file_output(std::string const& format,
+                 int precision,
+                 std::string const& filename,
+                 std::string const& header,
+                 int d,
+                 std::ios_base::openmode mode)
+{
+  if (format == "csv") {
+    auto out = file_stream_ptr(new io::FileOutputStream(filename, header, mode));
+    out->set_precision(precision);
+    return out;
+  }
+  auto value_size = (format == "binary32") ? sizeof(float) : sizeof(double);
+  return file_stream_ptr(
+    new io::BinaryOutputStream(filename, header, d, value_size, mode));
+}
+
+void
+Search::set_output_format(std::string const& format)
+{
+  if (format != "csv" && format != "binary" && format != "binary32") {
+    throw SearchException("set_output_format",
+                          "Unknown output format '" + format +
+                            "', use csv, binary or binary32.");
+  }
+  pimpl->output_format = format;
+}
+std::string
+Search::get_output_format()
+{
+  return pimpl->output_format;
+}
+
+void
+Search::set_output_shards(bool enabled, bool merge)
+{
+  pimpl->output_shards = enabled;
+  pimpl->merge_shards = merge;
+}
+bool
+Search::get_output_shards()
+{
+  return pimpl->output_shards;
+}
+
+void
+Search::merge_shards(std::string const& manifest, std::string const& outfile)
+{
+  algorithm::Coordinator::merge_manifest(manifest, outfile, pimpl->ranks);
+}
+
+void
+Search::set_ordered_output(bool enabled)
+{
+  pimpl->ordered_output = enabled;
+}
+bool
+Search::get_ordered_output()
+{
+  return pimpl->ordered_output;
+}
+
+void
+Search::set_output_precision(int digits)
+{
+  if (digits < 0 || digits > 17) {
+    throw SearchException("set_output_precision",
+                          "Precision " + std::to_string(digits) +
+                            " out of range [0,17]");
+  }
+  pimpl->output_precision = digits;
+}
+int
+Search::get_output_precision()
+{
+  return pimpl->output_precision;
+}
+
+void
+Search::set_top_k(long k)
+{
+  if (k < 0) {
+    throw SearchException("set_top_k", "K cannot be negative.");
+  }
+  pimpl->top_k = k;
+}
+long
+Search::get_top_k()
+{
+  return pimpl->top_k;
+}
+
+void
+Search::set_result_sketch(bool enabled, double accuracy)
+{
+  if (!(accuracy > 0 && accuracy < 1)) {
+    throw SearchException("set_result_sketch", "Accuracy must be between 0 and 1.");
+  }
+  pimpl->result_sketch = enabled;
+  pimpl->sketch_accuracy = accuracy;
+}
+bool
+Search::get_result_sketch_enabled()
+{
+  return pimpl->result_sketch;
+}
+
+it::entropy_type
+Search::estimate_cutoff(double top_fraction, std::size_t sample_tuples, unsigned seed)
+{
+  if (!pimpl->data) {
+    throw SearchException("estimate_cutoff",
+                          "No data loaded, use load_file or load_ndarray.");
+  }
+  if (!(top_fraction >= 0 && top_fraction <= 1)) {
+    throw SearchException("estimate_cutoff", "Fraction must be between 0 and 1.");
+  }
+  if (!sample_tuples) {
+    throw SearchException("estimate_cutoff", "Sample at least one tuple.");
+  }
+  auto space = (pimpl->custom_tuple_space && pimpl->tuple_space)
+                 ? pimpl->tuple_space
+                 : tuple_space_ptr(new algorithm::TupleSpace(
+                     pimpl->data->get_nvar(), pimpl->tuple_size));
+  auto count = space->count_tuples();
+
+  // distinct tuple numbers, drawn with Floyd's algorithm
+  auto sample = space;
+  if (sample_tuples < count) {
+    std::mt19937_64 rng(seed);
+    std::set<count_t> tuple_nos;
+    for (auto jj = count - sample_tuples; jj < count; jj++) {
+      auto t = std::uniform_int_distribution<count_t>(0, jj)(rng);
+      tuple_nos.insert((tuple_nos.count(t)) ? jj : t);
+    }
+    sample = tuple_space_ptr(new algorithm::TupleSpace());
+    for (auto tuple_no : tuple_nos) {
+      sample->addTuple(space->get_tuple(tuple_no));
+    }
+    sample->sortTuples();
+  }
+
+  // search the sample with a new Search of the same data, measure, tuple
+  // size and ranks, keeping only the sketch. Strata set on the data apply,
+  // so the sketched value is the one compared against the cutoff.
+  Search scan;
+  auto& config = *scan.pimpl;
+  config.data = pimpl->data;
+  config.strata_column = pimpl->strata_column;
+  config.strata_differences = pimpl->strata_differences;
+  config.measure = pimpl->measure;
+  config.measure_str = pimpl->measure_str;
+  config.probability_algorithm = pimpl->probability_algorithm;
+  config.probability_algorithm_str = pimpl->probability_algorithm_str;
+  config.tuple_size = pimpl->tuple_size;
+  config.ranks = pimpl->ranks;
+  config.total_ranks = pimpl->ranks;
+  config.sketch_accuracy = pimpl->sketch_accuracy;
+  config.tuple_space = sample;
+  config.custom_tuple_space = true;
+  config.in_memory_output = false;
+  config.result_sketch = true;
+  scan.start();
+  if (!config.sketch_output->count()) {
+    throw SearchException("estimate_cutoff", "No results in the sample.");
+  }
+  auto cutoff = config.sketch_output->top_fraction_cutoff(top_fraction);
+  set_cutoff(cutoff);
+  return cutoff;
+}
+
+void
+Search::save_top_k(std::string const& filename)
+{
+  if (!pimpl->top_k_output) {
+    throw SearchException("save_top_k", "No top-K results, use set_top_k and start.");
+  }
+  pimpl->top_k_output->write_file(filename);
+}
+
+void
+Search::merge_top_k(std::string const& filename)
+{
+  if (!pimpl->top_k_output) {
+    if (!pimpl->top_k) {
+      throw SearchException("merge_top_k", "K not set, use set_top_k.");
+    }
+    pimpl->top_k_output = top_k_stream_ptr(new io::TopKOutputStream(pimpl->top_k));
+  }
+  pimpl->top_k_output->merge_file(filename);
+  publish_top_k();
+}
+
+io::SketchOutputStream const&
+Search::get_result_sketch()
+{
+  if (!pimpl->sketch_output) {
+    throw SearchException("get_result_sketch",
+                          "No result sketch, use set_result_sketch and start.");
+  }
+  return *pimpl->sketch_output;
+}
+
+void
+Search::save_result_sketch(std::string const& filename)
+{
+  get_result_sketch().write_file(filename);
+}
+
+void
+Search::merge_result_sketch(std::string const& filename)
+{
+  if (!pimpl->sketch_output) {
+    pimpl->sketch_output =
+      sketch_stream_ptr(new io::SketchOutputStream(pimpl->sketch_accuracy));
+  }
+  pimpl->sketch_output->merge_file(filename);
+}
+
+#if BOOST_PYTHON_EXTENSIONS
+std::shared_ptr<io::SketchOutputStream>
+Search::python_get_result_sketch()
+{
+  get_result_sketch();
+  return pimpl->sketch_output;
+}
+#endif
+
+// Copy the merged top-K results, best first, to the in-memory results and
+// the output file if one is configured.
+void
+Search::publish_top_k()
+{
+  auto entries = pimpl->top_k_output->sorted();
+  pimpl->result_outputs.clear();
+  if (entries.empty()) {
+    return;
+  }
+  auto const& first = entries.front();
+  auto rowsize = first.tuple.size() + first.result.size();
+  auto mem = flat_stream_ptr(new io::FlatOutputStream(rowsize, 0));
+  for (auto const& e : entries) {
+    mem->push(e.tuple_no, e.tuple, e.result);
+    if (pimpl->file_output) {
+      pimpl->file_output->push(e.tuple_no, e.tuple, e.result);
+    }
+  }
+  // bounded size, so always kept in memory
+  pimpl->result_outputs.push_back(mem);
+}
+
+void
+Search::set_show_progress(bool show_progress)
+{
+  pimpl->show_progress = show_progress;
+}
+bool
+Search::get_show_progress()
+{
+  return pimpl->show_progress;
+}
+
+void
+Search::set_ranks(int ranks)
+{
+  pimpl->ranks = (!ranks) ? std::thread::hardware_concurrency() : ranks;
+}
+int
+Search::get_ranks()
+{
+  return pimpl->ranks;
+}
+
+void
+Search::set_start_rank(int start_rank)
+{
+  pimpl->start_rank = start_rank;
+}
+int
+Search::get_start_rank()
+{
+  return pimpl->ranks;
+}
+
+void
+Search::set_total_ranks(int total_ranks)
+{
+  pimpl->total_ranks = total_ranks;
+  pimpl->parallel_search = true;
+}
+int
+Search::get_total_ranks()
+{
+  return pimpl->total_ranks;
+}
+
+void
+Search::set_output_intermediate(bool full)
+{
+  pimpl->full_output = full;
+}
+bool
+Search::get_output_intermediate()
+{
+  return pimpl->full_output;
+}
+
+void
+Search::set_cache_enabled(bool enabled)
+{
+  pimpl->use_cache = enabled;
+}
+bool
+Search::get_cache_enabled()
+{
+  return pimpl->use_cache;
+}
+
+void
+Search::set_cache_size_bytes(unsigned long size)
+{
+  pimpl->cache_size_bytes = size;
+}
+unsigned long
+Search::get_cache_size_bytes()
+{
+  return pimpl->cache_size_bytes;
+}
+
+void
+Search::_load_file(std::string const& filename, bool rowmajor)
+{
+  // TODO invalidate previous results
+  pimpl->data = data_ptr(new io::DataMatrix(filename, rowmajor));
+  pimpl->count_caches.clear();
+  pimpl->searched_nvar = 0;
+  pimpl->delta_nvar = 0;
+  pimpl->strata_column = -1;
+  if (!pimpl->data) {
+    throw SearchException(
+      "load_file", "Failed to create DataMatrix from file '" + filename + "'");
+  }
+  if (pimpl->compact_bins) {
+    pimpl->data->compact_bins();
+  }
+  if (pimpl->deduplicate) {
+    pimpl->data->deduplicate();
+  }
+}
+
+void
+Search::load_file(std::string const& filename)
+{
+  _load_file(filename, true);
+}
+
+void
+Search::load_file_row_major(std::string const& filename)
+{
+  _load_file(filename, true);
+}
+
+void
+Search::load_file_column_major(std::string const& filename)
+{
+  _load_file(filename, false);
+}
+
+#if BOOST_PYTHON_EXTENSIONS
+void
+Search::load_ndarray(np::ndarray const& np)
+{
+  // TODO invalidate previous results
+  pimpl->data = data_ptr(new io::DataMatrix(np));
+  pimpl->count_caches.clear();
+  pimpl->searched_nvar = 0;
+  pimpl->delta_nvar = 0;
+  pimpl->strata_column = -1;
+  if (!pimpl->data) {
+    throw SearchException("load_ndarray",
+                          "Failed to create DataMatrix from ndarray");
+  }
+  if (pimpl->compact_bins) {
+    pimpl->data->compact_bins();
+  }
+  if (pimpl->deduplicate) {
+    pimpl->data->deduplicate();
+  }
+}
+#endif
+
+void
+Search::printCacheStats()
+{
+  int thread_no = 0;
+  for (auto const& thread : pimpl->threads) {
+    int cache_no = 1;
+    if (!thread.caches.empty()) {
+      for (auto cache : thread.caches) {
+        if (cache) {
+          std::cerr << "Thread " << thread_no;
+          std::cerr << " cache " << cache_no;
+          std::cerr << " hits " << cache->hits();
+          std::cerr << " misses " << cache->misses();
+          std::cerr << " evictions " << cache->evictions();
+          std::cerr << std::endl;
+        }
+        cache_no++;
+      }
+    }
+    thread_no++;
+  }
+}
+
+static counter_ptr
+make_counter(probability_algorithms const& type,
+             variables_ptr const& variables,
+             io::DataMatrix::multiplicities_ptr const& multiplicities = nullptr)
+{
+  switch (type) {
+    case probability_algorithms::vector:
+      return counter_ptr(new it::VectorCounter(multiplicities));
     case probability_algorithms::bitset:
+      if (multiplicities) {
+        throw SearchException("start", "Bitset counting cannot be used with deduplicated samples, use vector.");
+      }
       return counter_ptr(new it::BitsetCounter(*variables));
     default:
       throw SearchException("make_counter", "Invalid probabilty algorithm");
   }
 }
 
-static entropy_calc_ptr
-make_calculator(counter_ptr const& counter,
-                std::vector<cache_ptr> const& caches,
-                variables_ptr const& variables)
+static entropy_calc_ptr
+make_calculator(counter_ptr const& counter,
+                std::vector<cache_ptr> const& caches,
+                variables_ptr const& variables)
+{
+  return entropy_calc_ptr(new it::EntropyCalculator(variables, counter, caches));
+}
+
+static std::vector<count_t[2]>
+divide_tuple_space(count_t total_ranks, count_t tuple_count)
+{
+  std::vector<count_t[2]> rank_bounds(total_ranks); // [start,stop)
+  auto step = tuple_count / total_ranks;
+  rank_bounds[0][0] = 0;
+  rank_bounds[0][1] = step;
+  for (auto rr = 1; rr < total_ranks; rr++) {
+    rank_bounds[rr][0] = rank_bounds[rr - 1][1];
+    rank_bounds[rr][1] = (rr + 1) * step;
+  }
+  rank_bounds[total_ranks-1][1] = tuple_count;
+  return rank_bounds;
+}
+
+// TupleSpace of the unique size d sub-tuples of an explicit tuple list, so
+// caches are only filled for entries the search will actually read.
+static tuple_space_ptr
+list_sub_tuple_space(algorithm::TupleSpace const& ts, int d)
+{
+  using tuple_t = algorithm::TupleSpace::tuple_t;
+  int tuple_size = ts.tupleSize();
+  std::set<tuple_t> subs;
+  tuple_t sub(d);
+  auto count = ts.count_tuples();
+  for (count_t ii = 0; ii < count; ii++) {
+    auto tuple = ts.get_tuple(ii);
+    if (d == 1) {
+      for (auto var : tuple) {
+        subs.insert(tuple_t(1, var));
+      }
+    } else {
+      for (int jj = 0; jj < tuple_size; jj++) {
+        for (int kk = jj + 1; kk < tuple_size; kk++) {
+          sub[0] = tuple[jj];
+          sub[1] = tuple[kk];
+          subs.insert(sub);
+        }
+      }
+    }
+  }
+  auto sub_ts = tuple_space_ptr(new algorithm::TupleSpace());
+  tuple_t packed;
+  packed.reserve(subs.size() * d);
+  for (auto const& s : subs) {
+    packed.insert(packed.end(), s.begin(), s.end());
+  }
+  sub_ts->addTuples(packed, d);
+  return sub_ts;
+}
+
+void
+Search::init_caches()
+{
+  if (pimpl->incremental) {
+    if (pimpl->data->is_deduplicated()) {
+      throw SearchException("start", "Incremental mode cannot be used with deduplicated samples.");
+    }
+    init_count_caches();
+    return;
+  }
+  auto entropy_measure = measure_ptr(new it::EntropyMeasure());
+  int nvar = pimpl->data->get_nvar();
+  int ranks = pimpl->ranks;
+  std::size_t ncache = (pimpl->tuple_size > 2) ? 2 : 1;
+  auto variables = pimpl->data->variables();
+
+  // Even very large data does not take a seriously long time to populate
+  // caches, especially compared to the the full runtime. Thus we can get away
+  // with not checking if caches can be reused (hard with the no-copy data
+  // model). So remake the caches every time, unless variables were only
+  // appended since the last search, in which case only entries for the new
+  // variables are computed.
+  std::size_t delta_from = pimpl->delta_nvar;
+  bool grow = delta_from && pimpl->cache_nvar == delta_from &&
+              pimpl->shared_caches.size() == ncache;
+  for (auto const& cache : pimpl->shared_caches) {
+    grow = grow && cache;
+  }
+  if (grow) {
+    try {
+      std::dynamic_pointer_cast<cache::Flat1D>(pimpl->shared_caches[0])->grow(nvar);
+      if (ncache >= 2) {
+        std::dynamic_pointer_cast<cache::Flat2D>(pimpl->shared_caches[1])->grow(nvar);
+      }
+    } catch (std::bad_alloc const& ba) {
+      grow = false;
+    }
+  }
+  if (!grow) {
+    delta_from = 0;
+    pimpl->shared_caches.resize(ncache);
+    pimpl->shared_caches.assign(ncache, nullptr);
+  }
+  pimpl->cache_nvar = nvar;
+
+  auto mem_budget = pimpl->cache_size_bytes;
+
+  // By taking each dimension on its own we prevent any two threads from
+  // seeing the same tuple. Cache must be a pre-allocated container, hence
+  // thread-safe writes to different elements.
+  if (grow) {
+    // caches already allocated
+  } else if (ncache >= 1) {
+    try {
+      pimpl->shared_caches[0] =
+        cache_ptr(new cache::Flat1D(nvar));
+    } catch (std::bad_alloc const& ba) {
+      // cannot allocate this cache, stop the cache init
+      return;
+    }
+  }
+  if (ncache >= 2 && !grow) {
+    try {
+      //TODO take from memory budget
+      pimpl->shared_caches[1] =
+        cache_ptr(new cache::Flat2D(nvar));
+    } catch (std::bad_alloc const& ba) {
+      // TODO try a smaller size?
+    }
+  }
+
+  // TODO higher dimensions
+
+  for (std::size_t cc = 0; cc < ncache; cc++) {
+    if (!pimpl->shared_caches[cc]) {
+      continue;
+    }
+    int d = cc + 1;
+    std::vector<algorithm::Worker> workers(ranks);
+    std::vector<std::thread> threads(ranks - 1);
+    std::vector<cache_ptr> caches = { pimpl->shared_caches[cc] };
+    auto ts = (pimpl->tuple_space->isTupleList())
+                ? list_sub_tuple_space(*pimpl->tuple_space, d)
+              : (delta_from)
+                ? tuple_space_ptr(new algorithm::TupleSpace(delta_from, nvar - delta_from, d))
+                : tuple_space_ptr(new algorithm::TupleSpace(nvar, d)); //TODO: make it closer to the real TupleSpace ...
+    auto tuple_count = ts->count_tuples();
+    auto rank_bounds = divide_tuple_space(ranks, tuple_count);
+    for (int ii = 0; ii < ranks; ii++) {
+      auto calc = make_calculator(pimpl->counter, caches, variables);
+      workers[ii] = algorithm::Worker(
+        ts, rank_bounds[ii][0], rank_bounds[ii][1], calc, {}, entropy_measure);
+    }
+    for (int ii = 0; ii < ranks - 1; ii++) {
+      threads[ii] = std::thread(&algorithm::Worker::start, &workers[ii]);
+    }
+    workers.back().start();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+}
+
+// Collects the packed tuples of a TupleSpace
+class TupleCollector : public algorithm::TupleSpaceTraverser
+{
+public:
+  std::vector<Variable::index_t> packed;
+  void process_tuple(count_t, algorithm::TupleSpace::tuple_t const& tuple)
+  {
+    packed.insert(packed.end(), tuple.begin(), tuple.end());
+  }
+  void process_tuple_entropy(count_t,
+                             algorithm::TupleSpace::tuple_t const&,
+                             it::Entropy const&)
+  {}
+};
+
+static std::vector<Variable::index_t>
+collect_tuples(algorithm::TupleSpace const& ts)
+{
+  TupleCollector collector;
+  ts.traverse(collector);
+  return collector.packed;
+}
+
+// Variables viewing rows [begin, begin+n) of the data, without copying
+static Variable::tuple
+row_view(io::DataMatrix& data, std::size_t begin, std::size_t n)
+{
+  Variable::tuple vars;
+  if (!n) {
+    return vars;
+  }
+  auto nvar = data.get_nvar();
+  for (std::size_t ii = 0; ii < nvar; ii++) {
+    Variable::data_ptr rows(data.vectors[ii], data.vectors[ii].get() + begin);
+    vars.push_back(Variable(rows, n, ii, data.bins[ii]));
+  }
+  return vars;
+}
+
+static void
+update_count_caches(std::vector<count_cache_ptr> const& caches,
+                    Variable::tuple const& added,
+                    Variable::tuple const& removed,
+                    int ranks)
+{
+  for (auto const& cache : caches) {
+    if (!cache || !cache->tables()) {
+      continue;
+    }
+    auto bounds = divide_tuple_space(ranks, cache->tables());
+    std::vector<std::thread> threads;
+    for (int ii = 0; ii < ranks; ii++) {
+      count_t begin = bounds[ii][0];
+      count_t end = bounds[ii][1];
+      threads.push_back(std::thread([&cache, &added, &removed, begin, end] {
+        cache->update(added, removed, begin, end);
+      }));
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+}
+
+// Count tables replace the entropy caches in incremental mode. They are made
+// once for the data and TupleSpace, then kept up to date as samples are added
+// and removed.
+void
+Search::init_count_caches()
+{
+  auto& ts = pimpl->tuple_space;
+  if (!pimpl->count_caches.empty() && pimpl->count_tuple_space == ts) {
+    pimpl->shared_caches.assign(pimpl->count_caches.begin(),
+                                pimpl->count_caches.end());
+    return;
+  }
+
+  int nvar = pimpl->data->get_nvar();
+  int d = ts->tupleSize();
+  auto variables = pimpl->data->variables();
+  std::vector<count_cache_ptr> caches(d);
+  auto sub_tuples = [&](int dd) {
+    return (ts->isTupleList()) ? collect_tuples(*list_sub_tuple_space(*ts, dd))
+                               : collect_tuples(algorithm::TupleSpace(nvar, dd));
+  };
+  try {
+    caches[0] = count_cache_ptr(new cache::CountCache(*variables, sub_tuples(1), 1));
+    if (d > 2) {
+      caches[1] = count_cache_ptr(new cache::CountCache(*variables, sub_tuples(2), 2));
+    }
+    if (pimpl->incremental_results) {
+      caches[d - 1] = count_cache_ptr(new cache::CountCache(*variables, collect_tuples(*ts), d));
+    }
+  } catch (std::bad_alloc const& ba) {
+    throw SearchException("start", "Not enough memory for incremental count tables.");
+  }
+  update_count_caches(caches, *variables, {}, pimpl->ranks);
+
+  pimpl->count_caches = caches;
+  pimpl->count_tuple_space = ts;
+  pimpl->shared_caches.assign(caches.begin(), caches.end());
+}
+
+void
+Search::set_incremental(bool enabled)
+{
+  pimpl->incremental = enabled;
+  pimpl->count_caches.clear();
+}
+
+bool
+Search::get_incremental()
+{
+  return pimpl->incremental;
+}
+
+void
+Search::set_incremental_results(bool enabled)
+{
+  pimpl->incremental_results = enabled;
+  pimpl->count_caches.clear();
+}
+
+bool
+Search::get_incremental_results()
 {
-  return entropy_calc_ptr(new it::EntropyCalculator(variables, counter, caches));
+  return pimpl->incremental_results;
 }
 
-using count_t = algorithm::TupleSpace::count_t;
-static std::vector<count_t[2]>
-divide_tuple_space(count_t total_ranks, count_t tuple_count)
+void
+Search::_update_samples(io::DataMatrix* samples, std::size_t remove)
 {
-  std::vector<count_t[2]> rank_bounds(total_ranks); // [start,stop)
-  auto step = tuple_count / total_ranks;
-  rank_bounds[0][0] = 0;
-  rank_bounds[0][1] = step;
-  for (auto rr = 1; rr < total_ranks; rr++) {
-    rank_bounds[rr][0] = rank_bounds[rr - 1][1];
-    rank_bounds[rr][1] = (rr + 1) * step;
+  if (!pimpl->data) {
+    throw SearchException("update_samples",
+                          "No data loaded, use load_file or load_ndarray.");
   }
-  rank_bounds[total_ranks-1][1] = tuple_count;
-  return rank_bounds;
+  auto& data = *pimpl->data;
+  if (data.has_strata()) {
+    throw SearchException("update_samples", "Samples cannot be updated with strata.");
+  }
+  if (data.is_deduplicated()) {
+    throw SearchException("update_samples", "Samples cannot be updated when deduplicated.");
+  }
+  if (data.is_compacted()) {
+    throw SearchException("update_samples", "Samples cannot be updated when bins are compacted.");
+  }
+  auto nvar = data.get_nvar();
+  auto nadd = (samples) ? samples->get_svar() : 0;
+  if (remove >= data.get_svar() + nadd) {
+    throw SearchException("update_samples", "Cannot remove all samples.");
+  }
+  if (samples) {
+    if (samples->get_nvar() != nvar) {
+      throw SearchException("update_samples",
+                            "Samples have " + std::to_string(samples->get_nvar()) +
+                              " variables, expected " + std::to_string(nvar));
+    }
+    // values must fit the bins of the loaded data
+    for (std::size_t ii = 0; ii < nvar; ii++) {
+      auto col = samples->vectors[ii].get();
+      for (std::size_t jj = 0; jj < nadd; jj++) {
+        if (col[jj] >= data.bins[ii]) {
+          throw SearchException(
+            "update_samples",
+            "Value " + std::to_string(col[jj]) + " of variable " +
+              std::to_string(ii) + " is outside of the bins [0," +
+              std::to_string(data.bins[ii]) + ") of the loaded data");
+        }
+      }
+    }
+  }
+  // The window is a copy of the matrix, not of its rows, so the data of a
+  // copy of this Search stays as it was. Removed rows are the oldest in the
+  // window, which includes some of the added rows if more are removed than
+  // were loaded. The bins of the loaded data are kept so the count tables
+  // stay valid.
+  auto window = data_ptr(new io::DataMatrix(data));
+  if (nadd) {
+    window->append_samples(*samples);
+  }
+  auto added = (nadd) ? row_view(*samples, 0, nadd) : Variable::tuple();
+  update_count_caches(pimpl->count_caches, added, row_view(*window, 0, remove), pimpl->ranks);
+  if (remove) {
+    window->drop_samples(remove);
+  }
+  pimpl->data = window;
 }
 
 void
-Search::init_caches()
+Search::add_samples(io::DataMatrix& samples)
 {
-  auto entropy_measure = measure_ptr(new it::EntropyMeasure());
-  int nvar = pimpl->data->get_nvar();
-  int ranks = pimpl->ranks;
-  int ncache = (pimpl->tuple_size > 2) ? 2 : 1;
-  auto variables = pimpl->data->variables();
+  _update_samples(&samples, 0);
+}
 
-  // Even very large data does not take a seriously long time to populate
-  // caches, especially compared to the the full runtime. Thus we can get away
-  // with not checking if caches can be reused (hard with the no-copy data
-  // model). So remake the caches every time.
-  pimpl->shared_caches.resize(ncache);
-  pimpl->shared_caches.assign(ncache, nullptr);
+void
+Search::remove_samples(std::size_t n)
+{
+  _update_samples(nullptr, n);
+}
 
-  auto mem_budget = pimpl->cache_size_bytes;
+void
+Search::slide_samples(io::DataMatrix& samples)
+{
+  _update_samples(&samples, samples.get_svar());
+}
 
-  // By taking each dimension on its own we prevent any two threads from
-  // seeing the same tuple. Cache must be a pre-allocated container, hence
-  // thread-safe writes to different elements.
-  if (ncache >= 1) {
-    try {
-      pimpl->shared_caches[0] =
-        cache_ptr(new cache::Flat1D(nvar));
-    } catch (std::bad_alloc const& ba) {
-      // cannot allocate this cache, stop the cache init
-      return;
-    }
+void
+Search::append_variables(io::DataMatrix& columns)
+{
+  if (!pimpl->data) {
+    throw SearchException("append_variables",
+                          "No data loaded, use load_file or load_ndarray.");
   }
-  if (ncache >= 2) {
-    try {
-      //TODO take from memory budget
-      pimpl->shared_caches[1] =
-        cache_ptr(new cache::Flat2D(nvar));
-    } catch (std::bad_alloc const& ba) {
-      // TODO try a smaller size?
-    }
+  auto& data = *pimpl->data;
+  if (data.has_strata()) {
+    throw SearchException("append_variables", "Variables cannot be appended with strata.");
+  }
+  if (data.is_deduplicated()) {
+    throw SearchException("append_variables", "Variables cannot be appended to deduplicated samples.");
   }
+  if (data.is_compacted()) {
+    throw SearchException("append_variables", "Variables cannot be appended when bins are compacted.");
+  }
+  auto nold = data.get_nvar();
+  auto nnew = columns.get_nvar();
+  auto nsamples = data.get_svar();
+  if (columns.get_svar() != nsamples) {
+    throw SearchException("append_variables",
+                          "Variables have " + std::to_string(columns.get_svar()) +
+                            " samples, expected " + std::to_string(nsamples));
+  }
+  // share the columns, data is never modified in place
+  auto appended = data_ptr(new io::DataMatrix(nold + nnew, nsamples, 1));
+  for (std::size_t ii = 0; ii < nold; ii++) {
+    appended->vectors[ii] = data.vectors[ii];
+    appended->bins[ii] = data.bins[ii];
+  }
+  for (std::size_t ii = 0; ii < nnew; ii++) {
+    appended->vectors[nold + ii] = columns.vectors[ii];
+    appended->bins[nold + ii] = columns.bins[ii];
+  }
+  pimpl->data = appended;
+  pimpl->count_caches.clear();
 
-  // TODO higher dimensions
+  if (pimpl->custom_tuple_space) {
+    return;
+  }
+  pimpl->tuple_space = nullptr;
+  // a pending delta search already starts at the earlier variables
+  if (!pimpl->delta_nvar && pimpl->searched_nvar == nold &&
+      pimpl->searched_tuple_size == pimpl->tuple_size) {
+    pimpl->delta_nvar = nold;
+  }
+}
 
-  for (int cc = 0; cc < ncache; cc++) {
-    if (!pimpl->shared_caches[cc]) {
-      continue;
-    }
-    int d = cc + 1;
-    std::vector<algorithm::Worker> workers(ranks);
-    std::vector<std::thread> threads(ranks - 1);
-    std::vector<cache_ptr> caches = { pimpl->shared_caches[cc] };
-    auto ts = tuple_space_ptr(new algorithm::TupleSpace(nvar, d)); //TODO: make it closer to the real TupleSpace ...
-    auto tuple_count = ts->count_tuples();
-    auto rank_bounds = divide_tuple_space(ranks, tuple_count);
-    for (int ii = 0; ii < ranks; ii++) {
-      auto calc = make_calculator(pimpl->counter, caches, variables);
-      workers[ii] = algorithm::Worker(
-        ts, rank_bounds[ii][0], rank_bounds[ii][1], calc, {}, entropy_measure);
-    }
-    for (int ii = 0; ii < ranks - 1; ii++) {
-      threads[ii] = std::thread(&algorithm::Worker::start, &workers[ii]);
-    }
-    workers.back().start();
-    for (auto& thread : threads) {
-      thread.join();
+static bool
+has_missing(Variable::tuple const& variables)
+{
+  for (auto const& var : variables) {
+    for (auto val : var) {
+      if (Variable::missingVal(val)) {
+        return true;
+      }
     }
   }
+  return false;
 }
 
 static void
-configure_in_memory_output(std::vector<flat_stream_ptr> &mem_outputs,
+configure_in_memory_output(std::vector<output_stream_ptr> &mem_outputs,
                            bool cutoff,
                            std::size_t ranks,
                            std::size_t tuple_count,
                            std::size_t tuple_offset,
-                           std::size_t rowsize)
+                           std::size_t rowsize,
+                           std::string const& map_file)
 {
   mem_outputs.clear();
-  if (cutoff) {
+  if (cutoff && !map_file.empty()) {
+    throw SearchException("start", "Mapped results need a row for every tuple, they cannot be used with a cutoff, screen or duplicate expansion.");
+  }
+  if (!map_file.empty()) {
+    try {
+      mem_outputs.push_back(flat_stream_ptr(new io::FlatOutputStream(map_file, tuple_count, rowsize, tuple_offset)));
+    } catch (io::FlatOutputStreamException &e) {
+      throw SearchException("start", e.what());
+    }
+  } else if (cutoff) {
     // can't know real size of the output, use dynamically expanding pattern
     mem_outputs.resize(ranks);
     for (int ii = 0; ii < ranks; ii++) {
@@ -577,11 +1900,238 @@ wait_print_progress(std::vector<algorithm::Worker> const& workers,
   }
 }
 
+// Pair matrix of the value columns, keeping the pairs of the variables
+// searched before
+pair_matrix_stream_ptr
+Search::configure_pair_matrix(measure_ptr const& measure,
+                              int tuple_size,
+                              bool permuting,
+                              pair_matrix_stream_ptr const& prior)
+{
+  if (tuple_size != 2) {
+    throw SearchException("start", "A pair matrix needs a tuple size of 2.");
+  }
+  auto const& names = measure->names(tuple_size, pimpl->full_output);
+  pimpl->pair_matrix_names.assign(names.begin() + tuple_size, names.end());
+  if (permuting) {
+    pimpl->pair_matrix_names.push_back("exceedances");
+  }
+  std::size_t nvar = pimpl->data->get_nvar();
+  auto nplanes = pimpl->pair_matrix_names.size();
+  pair_matrix_stream_ptr output;
+  try {
+    output = (pimpl->map_file.empty())
+      ? pair_matrix_stream_ptr(new io::PairMatrixOutputStream(nvar, nplanes))
+      : pair_matrix_stream_ptr(new io::PairMatrixOutputStream(pimpl->map_file, nvar, nplanes));
+  } catch (io::PairMatrixOutputStreamException& e) {
+    throw SearchException("start", std::string("Could not allocate the pair matrix: ") + e.what());
+  }
+  if (prior && prior->get_nplanes() == nplanes && prior->get_nvar() <= nvar) {
+    output->copy_pairs(*prior);
+  }
+  return output;
+}
+
+// Typed result columns for each rank, or one sized for all tuples when
+// every tuple has a row
+std::vector<output_stream_ptr>
+Search::configure_column_output(measure_ptr const& measure,
+                                int tuple_size,
+                                bool permuting,
+                                bool expanding,
+                                int ranks,
+                                std::size_t begin,
+                                std::size_t end)
+{
+  auto const& names = measure->names(tuple_size, pimpl->full_output);
+  std::vector<std::string> value_names(names.begin() + tuple_size, names.end());
+  if (permuting) {
+    value_names.push_back("exceedances");
+  }
+  auto sizes = pimpl->compact_value_sizes;
+  if (sizes.size() == 1) {
+    sizes.assign(value_names.size(), sizes.front());
+  } else if (sizes.size() != value_names.size()) {
+    throw SearchException("start",
+                          "Compact results have " + std::to_string(value_names.size()) +
+                            " value columns, " + std::to_string(sizes.size()) +
+                            " value types given.");
+  }
+  // copies of duplicate variables share the tuple number of their original
+  bool tuple_numbers = pimpl->compact_tuple_numbers;
+  if (tuple_numbers && expanding) {
+    throw SearchException("start", "Compact results with tuple numbers cannot expand duplicate variables.");
+  }
+  pimpl->compact_names.clear();
+  if (tuple_numbers) {
+    pimpl->compact_names.push_back("tuple_no");
+    pimpl->results_tuple_space = pimpl->tuple_space;
+  } else {
+    pimpl->compact_names.assign(names.begin(), names.begin() + tuple_size);
+  }
+  pimpl->compact_names.insert(pimpl->compact_names.end(), value_names.begin(), value_names.end());
+
+  std::vector<output_stream_ptr> outputs;
+  try {
+    if (pimpl->use_cutoff || pimpl->screen || expanding) {
+      for (int ii = 0; ii < ranks; ii++) {
+        outputs.push_back(column_stream_ptr(
+          new io::ColumnOutputStream(tuple_size, sizes, tuple_numbers)));
+      }
+    } else {
+      outputs.push_back(column_stream_ptr(
+        new io::ColumnOutputStream(tuple_size, sizes, tuple_numbers, end - begin, begin)));
+    }
+  } catch (io::ColumnOutputStreamException& e) {
+    throw SearchException("start", "Could not allocate space for all output tuples. Consider shrinking the TupleSpace, using a cutoff measure value, or switching to file-only output.");
+  }
+  return outputs;
+}
+
+// In-memory output of each rank: top-K heaps, result batches, a pair matrix,
+// compact columns or flat rows. Ranks share a stream sized for all their
+// tuples. Without in-memory output only top-K heaps and batches are made.
+std::vector<output_stream_ptr>
+Search::configure_result_outputs(measure_ptr const& measure,
+                                 int tuple_size,
+                                 bool permuting,
+                                 bool expanding,
+                                 bool in_memory_output,
+                                 bool delta,
+                                 int ranks,
+                                 std::size_t begin,
+                                 std::size_t end)
+{
+  bool batching = (pimpl->batches.queue != nullptr);
+  bool compact = in_memory_output && pimpl->compact_results && !pimpl->top_k && !batching;
+  if (batching && pimpl->top_k) {
+    throw SearchException("start", "Result batches cannot be used with top-K results.");
+  }
+  if (pimpl->pair_matrix && (pimpl->top_k || batching)) {
+    throw SearchException("start", "A pair matrix cannot be used with top-K results or result batches.");
+  }
+  if (pimpl->pair_matrix && compact) {
+    throw SearchException("start", "A pair matrix cannot be compact results.");
+  }
+  if (compact && !pimpl->map_file.empty()) {
+    throw SearchException("start", "Mapped results cannot be compact results.");
+  }
+
+  // the results of the last search are released first, a delta search keeps
+  // the pairs searched before
+  auto prior_pair_matrix =
+    (delta) ? joined_results<io::PairMatrixOutputStream>(pimpl->result_outputs) : nullptr;
+  pimpl->result_outputs.clear();
+  pimpl->results_tuple_space = nullptr;
+
+  std::vector<output_stream_ptr> outputs;
+  std::size_t rowsize = measure->names(tuple_size, pimpl->full_output).size() + permuting;
+  if (pimpl->top_k) {
+    for (int ii = 0; ii < ranks; ii++) {
+      outputs.push_back(top_k_stream_ptr(new io::TopKOutputStream(pimpl->top_k)));
+    }
+  } else if (batching) {
+    pimpl->batches.queue->set_rowsize(rowsize);
+    for (int ii = 0; ii < ranks; ii++) {
+      outputs.push_back(std::make_shared<io::BatchOutputStream>(
+        pimpl->batches.queue, rowsize, pimpl->batch_rows));
+    }
+  } else if (in_memory_output && pimpl->pair_matrix) {
+    outputs.push_back(
+      configure_pair_matrix(measure, tuple_size, permuting, prior_pair_matrix));
+  } else if (compact) {
+    outputs = configure_column_output(measure, tuple_size, permuting, expanding,
+                                      ranks, begin, end);
+  } else if (in_memory_output) {
+    // pruned tuples leave gaps and copies of duplicates add rows, so
+    // screening and expansion need the dynamic output too
+    configure_in_memory_output(outputs, pimpl->use_cutoff || pimpl->screen || expanding,
+                               ranks, end - begin, begin, rowsize, pimpl->map_file);
+  }
+  if (outputs.size() == 1) {
+    auto shared = outputs.front();
+    outputs.assign(ranks, shared);
+  }
+  return outputs;
+}
+
+// Link the segments of the streams of the ranks into the first, copied
+// into one array when read
+template<typename Stream>
+static bool
+relocate_results(std::vector<output_stream_ptr> const& outputs)
+{
+  auto first = joined_results<Stream>(outputs);
+  if (first) {
+    for (auto const& out : outputs) {
+      if (out != outputs.front()) {
+        first->relocate(static_cast<Stream&>(*out));
+      }
+    }
+  }
+  return first != nullptr;
+}
+
+// Join the in-memory output of the ranks after a search: merge the top-K
+// heaps with those of the variables searched before, hand over the partial
+// batches, or keep the rows, columns or pair matrix in one stream.
+void
+Search::join_result_outputs(bool delta)
+{
+  auto& outputs = pimpl->result_outputs;
+  auto prior_top_k = (delta) ? pimpl->top_k_output : nullptr;
+  pimpl->top_k_output = nullptr;
+  if (outputs.empty()) {
+    return;
+  }
+  if (pimpl->top_k) {
+    pimpl->top_k_output = std::static_pointer_cast<io::TopKOutputStream>(outputs.front());
+    for (std::size_t ii = 1; ii < outputs.size(); ii++) {
+      pimpl->top_k_output->merge(static_cast<io::TopKOutputStream&>(*outputs[ii]));
+    }
+    if (prior_top_k && prior_top_k->get_k() == pimpl->top_k) {
+      pimpl->top_k_output->merge(*prior_top_k);
+    }
+    publish_top_k();
+  } else if (pimpl->batches.queue) {
+    for (auto const& out : outputs) {
+      out->flush();
+    }
+    outputs.clear();
+  } else {
+    if (!relocate_results<io::FlatOutputStream>(outputs)) {
+      relocate_results<io::ColumnOutputStream>(outputs);
+    }
+    outputs.resize(1);
+    // start writing mapped results back to their file
+    outputs.front()->flush();
+  }
+}
+
+// A chunk [begin,end) of the tuple space handed out by a Coordinator
+struct Search::chunk_type
+{
+  std::string outfile;
+  count_t begin = 0;
+  count_t end = 0;
+  // counter and caches made by an earlier chunk
+  bool prepared = false;
+  // time taken by the search, without preparation
+  double seconds = 0;
+};
+
 //
 // Run full algoirithm as configured
 //
 void
 Search::start()
+{
+  finish_batches();
+  _start(nullptr);
+}
+
+void
+Search::_start(chunk_type* chunk)
 {
   // sanity checks
   if (!pimpl->data) {
@@ -595,55 +2145,218 @@ Search::start()
     throw SearchException(
       "start", "ranks for this Search cannot be greater than total_ranks.");
   }
+  bool resuming = pimpl->resuming;
+  pimpl->resuming = false;
+  bool checkpointing = !pimpl->checkpoint_file.empty();
+  if (checkpointing && pimpl->outfile.empty()) {
+    throw SearchException("start", "Checkpoints require an outfile, use set_outfile.");
+  }
+  if (checkpointing && pimpl->top_k) {
+    throw SearchException("start", "Checkpoints cannot be used with top-K results.");
+  }
+  bool permuting = (pimpl->permutations != 0);
+  if (permuting && pimpl->top_k) {
+    throw SearchException("start", "Permutation tests cannot be used with top-K results.");
+  }
+  if (permuting && pimpl->data->has_strata()) {
+    throw SearchException("start", "Permutation tests cannot be used with strata.");
+  }
+  if (permuting && pimpl->bootstrap_replicates) {
+    throw SearchException("start", "Permutation tests cannot be used with bootstrap replicates.");
+  }
+  if (permuting && pimpl->data->is_deduplicated()) {
+    throw SearchException("start", "Permutation tests cannot be used with deduplicated samples.");
+  }
+  auto measure = search_measure();
 
   int nvar = pimpl->data->get_nvar();
   int tuple_size = pimpl->tuple_size;
   auto variables = pimpl->data->variables();
+  // a chunk from a Coordinator is divided among the ranks of this Search and
+  // appended to the chunk file
+  bool chunked = (chunk != nullptr);
+  count_t chunk_begin = (chunked) ? chunk->begin : 0;
+  auto outfile = (chunked) ? chunk->outfile : pimpl->outfile;
+  bool in_memory_output = !chunked && pimpl->in_memory_output;
   auto total_ranks =
-    (pimpl->parallel_search) ? pimpl->total_ranks : pimpl->ranks;
-  auto start_rank = pimpl->start_rank;
+    (pimpl->parallel_search && !chunked) ? pimpl->total_ranks : pimpl->ranks;
+  auto start_rank = (chunked) ? 0 : pimpl->start_rank;
   auto ranks = pimpl->ranks;
-  auto num_threads = (pimpl->show_progress) ? pimpl->ranks : (pimpl->ranks - 1);
+  auto num_threads = (pimpl->show_progress || checkpointing) ? pimpl->ranks : (pimpl->ranks - 1);
 
   // load default tuplespace if one has not been set yet
-  if (!pimpl->tuple_space) {
+  // search only tuples with appended variables when the last search
+  // covered all the others
+  // permutation tests only search tuples with a permuted variable
+  // reduced searches leave out constant and duplicate variables
+  std::size_t delta_from = pimpl->delta_nvar;
+  bool permutation_space = permuting && !pimpl->custom_tuple_space && !delta_from;
+  auto reduction = variable_reduction();
+  bool reduced_space = (reduction != nullptr);
+  if (delta_from) {
+    pimpl->tuple_space = tuple_space_ptr(
+      new algorithm::TupleSpace(delta_from, nvar - delta_from, tuple_size));
+  } else if (permutation_space) {
+    pimpl->tuple_space =
+      permutation_tuple_space(nvar, pimpl->permuted, tuple_size);
+  } else if (reduction) {
+    pimpl->tuple_space = reduction->tuple_space(tuple_size);
+    if (!pimpl->expand_duplicates || !reduction->num_duplicates()) {
+      reduction = nullptr;
+    }
+  } else if (!pimpl->tuple_space) {
     pimpl->tuple_space = tuple_space_ptr(new algorithm::TupleSpace(nvar, tuple_size));
   }
+  if (pimpl->tuple_space->num_variables() > (std::size_t)nvar) {
+    throw SearchException("start",
+                          "TupleSpace has variable index " +
+                            std::to_string(pimpl->tuple_space->num_variables() - 1) +
+                            ", the data has " + std::to_string(nvar) + " variables.");
+  }
 
   // Create the probabilty distribution counter. The counter may recase the
   // data so it needs to have enough memory
-  pimpl->counter = make_counter(pimpl->probability_algorithm, variables);
+  if (!chunked || !chunk->prepared) {
+    pimpl->counter = make_counter(
+      pimpl->probability_algorithm, variables, pimpl->data->multiplicities());
+  }
+
+  // permuted copies of the permuted variables, counted separately
+  std::shared_ptr<algorithm::PermutationTest> permutation;
+  counter_ptr permutation_counter;
+  if (permuting) {
+    permutation = std::make_shared<algorithm::PermutationTest>(
+      variables, pimpl->permuted, pimpl->permutations, pimpl->permutation_seed);
+    permutation_counter =
+      make_counter(pimpl->probability_algorithm, permutation->variables());
+  }
 
   // Divide the tuple space into chunks for each rank
   auto max_tuples = pimpl->tuple_space->count_tuples();
   auto tuple_count = (pimpl->tuple_limit) ? pimpl->tuple_limit : max_tuples;
+  if (chunked) {
+    tuple_count = chunk->end - chunk->begin;
+  }
   auto rank_bounds = divide_tuple_space(total_ranks, tuple_count);
+  for (auto& bounds : rank_bounds) {
+    bounds[0] += chunk_begin;
+    bounds[1] += chunk_begin;
+  }
+
+  // state saved in checkpoints
+  algorithm::Checkpoint::state checkpoint_state;
+  checkpoint_state.tuple_count = tuple_count;
+  checkpoint_state.total_ranks = total_ranks;
+  checkpoint_state.start_rank = start_rank;
+  checkpoint_state.outfile = outfile;
+  if (resuming) {
+    auto const& saved = pimpl->resume_state;
+    if (saved.tuple_count != tuple_count || saved.total_ranks != total_ranks) {
+      throw SearchException("resume", "Checkpoint does not match the TupleSpace or ranks of this Search.");
+    }
+    checkpoint_state.stop = saved.stop;
+  } else {
+    for (int ii = 0; ii < ranks; ii++) {
+      checkpoint_state.stop.push_back(rank_bounds[start_rank + ii][1]);
+    }
+  }
+
+  // each thread writes its own shard file when sharding, otherwise the
+  // threads share the output file stream
+  bool sharding = pimpl->output_shards && !outfile.empty();
+  if (sharding && (checkpointing || resuming || pimpl->top_k || chunked)) {
+    throw SearchException("start", "Output shards cannot be used with checkpoints, top-K results or workers.");
+  }
+  if (sharding && pimpl->ordered_output) {
+    throw SearchException("start", "Output shards cannot be used with ordered output, merge the shards instead.");
+  }
+  std::vector<file_stream_ptr> shard_outputs;
+  std::vector<algorithm::Coordinator::chunk> shard_chunks;
+  if (sharding) {
+    auto header = output_header(measure, tuple_size, pimpl->full_output, permuting);
+    for (int ii = 0; ii < ranks; ii++) {
+      algorithm::Coordinator::chunk c;
+      c.start = rank_bounds[start_rank + ii][0];
+      c.stop = checkpoint_state.stop[ii];
+      c.shard = outfile + ".shard" + std::to_string(start_rank + ii);
+      shard_outputs.push_back(
+        make_file_output(pimpl->output_format, pimpl->output_precision,
+                         c.shard, header, tuple_size, std::ios_base::out));
+      c.begin = shard_outputs.back()->tell();
+      shard_chunks.push_back(c);
+    }
+  }
 
   // initialize output file stream
-  if (!pimpl->outfile.empty()) {
-    auto header = pimpl->measure->header(tuple_size, pimpl->full_output);
-    pimpl->file_output =
-      file_stream_ptr(new io::FileOutputStream(pimpl->outfile, header));
+  if (!outfile.empty() && !sharding) {
+    auto header = output_header(measure, tuple_size, pimpl->full_output, permuting);
+    if (resuming || chunked) {
+      if (resuming) {
+        truncate_outfile(outfile, pimpl->resume_state.offset);
+      }
+      pimpl->file_output =
+        make_file_output(pimpl->output_format, pimpl->output_precision,
+                         outfile, header, tuple_size,
+                         std::ios_base::out | std::ios_base::app);
+    } else {
+      pimpl->file_output =
+        make_file_output(pimpl->output_format, pimpl->output_precision,
+                         outfile, header, tuple_size, std::ios_base::out);
+    }
     if (!pimpl->file_output) {
       throw SearchException("start",
                             "Failed to create FileOutputStream from file '" +
-                              pimpl->outfile + "'");
+                              outfile + "'");
+    }
+  }
+
+  // Workers take blocks of tuples in order and a writer thread writes their
+  // results in tuple order
+  std::shared_ptr<io::OrderedWriter> ordered;
+  if (pimpl->ordered_output && pimpl->file_output) {
+    if (checkpointing || resuming || pimpl->top_k || chunked) {
+      throw SearchException("start", "Ordered output cannot be used with checkpoints, top-K results or workers.");
     }
+    ordered = std::make_shared<io::OrderedWriter>(
+      pimpl->file_output, rank_bounds[start_rank][0],
+      rank_bounds[start_rank + ranks - 1][1], ORDERED_BLOCKS_PER_RANK * ranks);
   }
 
-  // configure in-memory results output
-  if (pimpl->in_memory_output) {
-    std::size_t rowsize = pimpl->measure->names(tuple_size, pimpl->full_output).size();
-    auto tuple_offset = rank_bounds[start_rank][0];
-    auto size = rank_bounds[start_rank+ranks-1][1] - rank_bounds[start_rank][0];
-    configure_in_memory_output(pimpl->mem_outputs, pimpl->use_cutoff, ranks, size, tuple_offset, rowsize);
+  // configure in-memory results output, top-K results are copied out after
+  // the search
+  pimpl->result_outputs = configure_result_outputs(
+    measure, tuple_size, permuting, reduction != nullptr, in_memory_output,
+    delta_from != 0, ranks, rank_bounds[start_rank][0],
+    rank_bounds[start_rank + ranks - 1][1]);
+  auto prior_sketch = (delta_from) ? pimpl->sketch_output : nullptr;
+  pimpl->sketch_output = nullptr;
+  std::vector<sketch_stream_ptr> sketch_outputs;
+  if (pimpl->result_sketch) {
+    for (int ii = 0; ii < ranks; ii++) {
+      sketch_outputs.push_back(
+        sketch_stream_ptr(new io::SketchOutputStream(pimpl->sketch_accuracy)));
+    }
   }
 
-  // Only use caches for measures that use intermediate entropies
-  if (pimpl->use_cache && pimpl->measure->full_entropy()) {
+  // Only use caches for measures that use intermediate entropies. The chunks
+  // of a worker share the caches made for the first.
+  if (pimpl->use_cache && measure->full_entropy() && !(chunked && chunk->prepared)) {
     init_caches();
   }
+  if (chunked) {
+    chunk->prepared = true;
+  }
+
+  // Skip tuples that cannot reach the cutoff. The entropy bounds do not hold
+  // when entropies of different sub-tuples are computed over different rows.
+  bool use_bounds = (pimpl->use_cutoff || pimpl->top_k) &&
+                    measure->full_entropy() && !has_missing(*variables);
 
+  auto checkpoint = (checkpointing)
+                      ? std::make_shared<algorithm::Checkpoint>(ranks)
+                      : nullptr;
+
+  auto search_start = std::chrono::steady_clock::now();
   std::vector<algorithm::Worker> workers(ranks);
   std::vector<std::thread> threads(num_threads);
   // Create Workers
@@ -653,22 +2366,40 @@ Search::start()
     // Configure output streams. Each worker gets separate output streams
     // to avoid collision (single stream coordinated by mutex is too slow).
     std::vector<output_stream_ptr> out_streams;
-    if (pimpl->in_memory_output) {
-      out_streams.push_back((pimpl->mem_outputs.size() == ranks) ?
-          pimpl->mem_outputs[ii] : pimpl->mem_outputs.front());
+    if (!pimpl->result_outputs.empty()) {
+      out_streams.push_back(pimpl->result_outputs[ii]);
     }
-    if (pimpl->file_output) {
-      out_streams.push_back(std::shared_ptr<io::OutputStream>(
-        new io::FileOutputStream(*pimpl->file_output)));
+    if (pimpl->file_output && !pimpl->top_k) {
+      auto out = pimpl->file_output->clone();
+      out->set_ordered(ordered);
+      out_streams.push_back(out);
+    }
+    if (sharding) {
+      out_streams.push_back(shard_outputs[ii]);
+    }
+    if (!sketch_outputs.empty()) {
+      out_streams.push_back(sketch_outputs[ii]);
     }
     workers[ii] = algorithm::Worker(pimpl->tuple_space,
-                                    rank_bounds[start_rank + ii][0],
-                                    rank_bounds[start_rank + ii][1],
+                                    (resuming) ? pimpl->resume_state.next[ii]
+                                               : rank_bounds[start_rank + ii][0],
+                                    checkpoint_state.stop[ii],
                                     pimpl->cutoff,
                                     calc,
                                     out_streams,
-                                    pimpl->measure);
+                                    measure);
     workers[ii].output_all = pimpl->full_output;
+    workers[ii].screen = pimpl->screen;
+    workers[ii].use_bounds = use_bounds;
+    workers[ii].checkpoint = checkpoint;
+    workers[ii].checkpoint_index = ii;
+    if (permuting) {
+      workers[ii].permutation = permutation;
+      workers[ii].permutation_calc = entropy_calc_ptr(new it::EntropyCalculator(
+        permutation->variables(), permutation_counter));
+    }
+    workers[ii].reduction = reduction;
+    workers[ii].ordered = ordered;
   }
 
   // Start child ranks
@@ -676,7 +2407,10 @@ Search::start()
     threads[ii] = std::thread(&algorithm::Worker::start, &workers[ii]);
   }
 
-  if (pimpl->show_progress) {
+  if (checkpointing) {
+    wait_checkpoint(*checkpoint, checkpoint_state, pimpl->checkpoint_file,
+                    pimpl->checkpoint_interval, *pimpl->file_output);
+  } else if (pimpl->show_progress) {
     wait_print_progress(workers, tuple_count);
   } else {
     workers.back().start();
@@ -686,16 +2420,169 @@ Search::start()
   for (auto& thread : threads) {
     thread.join();
   }
+  if (chunked) {
+    std::chrono::duration<double> seconds =
+      std::chrono::steady_clock::now() - search_start;
+    chunk->seconds = seconds.count();
+  }
 
-  // combine in-memory output arrays
-  int narrays = pimpl->mem_outputs.size();
-  for (int ii = 1; ii < narrays; ii++) {
-    pimpl->mem_outputs.front()->relocate(*pimpl->mem_outputs[ii]);
+  // write the blocks still in the reorder buffer
+  if (ordered) {
+    workers.clear();
+    ordered->close();
   }
 
-  // cleanup output file stream
-  pimpl->in_memory_output = true;
+  // record where each shard's results are, and merge them in tuple order
+  if (sharding) {
+    for (int ii = 0; ii < ranks; ii++) {
+      shard_outputs[ii]->flush();
+      shard_chunks[ii].end = shard_outputs[ii]->tell();
+    }
+    shard_outputs.clear();
+    workers.clear();
+    auto manifest = outfile + ".manifest";
+    algorithm::Coordinator::write_manifest(manifest, tuple_count, shard_chunks);
+    if (pimpl->merge_shards) {
+      algorithm::Coordinator::merge_manifest(manifest, outfile, ranks);
+      for (auto const& c : shard_chunks) {
+        std::remove(c.shard.c_str());
+      }
+      std::remove(manifest.c_str());
+    }
+  }
+
+  // join the in-memory output of the ranks, top-K results are copied out
+  join_result_outputs(delta_from != 0);
+
+  // merge per-rank result sketches
+  if (!sketch_outputs.empty()) {
+    pimpl->sketch_output = sketch_outputs.front();
+    for (int ii = 1; ii < ranks; ii++) {
+      pimpl->sketch_output->merge(*sketch_outputs[ii]);
+    }
+    // results of the variables searched before
+    if (prior_sketch &&
+        prior_sketch->get_accuracy() == pimpl->sketch_output->get_accuracy()) {
+      pimpl->sketch_output->merge(*prior_sketch);
+    }
+  }
+
+  // search complete, the checkpoint is no longer needed
+  if (checkpointing) {
+    std::remove(pimpl->checkpoint_file.c_str());
+    pimpl->checkpoint_file = "";
+  }
+
+  // remember what was covered for a later delta search
+  if (!pimpl->custom_tuple_space && !chunked && !permuting) {
+    pimpl->searched_nvar = (pimpl->tuple_limit) ? 0 : nvar;
+    pimpl->searched_tuple_size = tuple_size;
+  }
+  if (delta_from && !chunked) {
+    pimpl->tuple_space = nullptr;
+    pimpl->delta_nvar = 0;
+  }
+  if (permutation_space || reduced_space) {
+    pimpl->tuple_space = nullptr;
+  }
+
+  // cleanup output file stream, a worker keeps its outfile for the next chunk
   pimpl->file_output = 0;
+  if (!chunked) {
+    pimpl->in_memory_output = true;
+    pimpl->outfile = "";
+  }
+}
+
+// Number of tuples start() would search, the same in every process that
+// searches the same data and configuration
+std::size_t
+Search::count_search_tuples()
+{
+  if (!pimpl->data) {
+    throw SearchException("start",
+                          "No data loaded, use load_file or load_ndarray.");
+  }
+  if (pimpl->tuple_limit) {
+    return pimpl->tuple_limit;
+  }
+  std::size_t nvar = pimpl->data->get_nvar();
+  auto delta_from = pimpl->delta_nvar;
+  if (delta_from) {
+    return algorithm::TupleSpace(delta_from, nvar - delta_from,
+                                 pimpl->tuple_size).count_tuples();
+  } else if (pimpl->permutations && !pimpl->custom_tuple_space) {
+    return permutation_tuple_space(nvar, pimpl->permuted, pimpl->tuple_size)
+      ->count_tuples();
+  } else if (auto reduction = variable_reduction()) {
+    return reduction->tuple_space(pimpl->tuple_size)->count_tuples();
+  } else if (pimpl->tuple_space) {
+    return pimpl->tuple_space->count_tuples();
+  }
+  return algorithm::TupleSpace(nvar, pimpl->tuple_size).count_tuples();
+}
+
+static count_t
+file_size(std::string const& filename)
+{
+  struct stat st;
+  if (stat(filename.c_str(), &st)) {
+    throw SearchException("start_worker", "Could not open output file '" + filename + "': " + std::strerror(errno));
+  }
+  return st.st_size;
+}
+
+void
+Search::start_coordinator(std::string const& socket_path,
+                          std::string const& manifest)
+{
+  algorithm::Coordinator coordinator(socket_path, count_search_tuples());
+  coordinator.run();
+  if (!manifest.empty()) {
+    coordinator.write_manifest(manifest);
+  }
+}
+
+void
+Search::start_worker(std::string const& socket_path)
+{
+  if (pimpl->outfile.empty()) {
+    throw SearchException("start_worker", "Workers require an outfile, use set_outfile.");
+  }
+  if (pimpl->top_k) {
+    throw SearchException("start_worker", "Workers cannot be used with top-K results.");
+  }
+  if (!pimpl->checkpoint_file.empty()) {
+    throw SearchException("start_worker", "Workers cannot be used with checkpoints.");
+  }
+  finish_batches();
+  auto tuple_count = count_search_tuples();
+  auto shard = pimpl->outfile + "." + std::to_string(getpid());
+
+  algorithm::CoordinatorClient client(socket_path);
+  client.hello(tuple_count, shard);
+
+  // every chunk is appended to the shard after a single header
+  {
+    make_file_output(pimpl->output_format, pimpl->output_precision, shard,
+                     output_header(search_measure(), pimpl->tuple_size,
+                                   pimpl->full_output, pimpl->permutations != 0),
+                     pimpl->tuple_size, std::ios_base::out);
+  }
+
+  chunk_type chunk;
+  chunk.outfile = shard;
+  count_t first, last;
+  while (client.next(first, last)) {
+    auto begin = file_size(shard);
+    chunk.begin = first;
+    chunk.end = last;
+    _start(&chunk);
+    client.report(first, last, chunk.seconds, begin, file_size(shard));
+  }
+
+  // cleanup as after start()
+  pimpl->in_memory_output = true;
   pimpl->outfile = "";
 }
 
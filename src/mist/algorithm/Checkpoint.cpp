@@ -0,0 +1,168 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "algorithm/Checkpoint.hpp"
+
+using namespace mist;
+using namespace mist::algorithm;
+
+#define CHECKPOINT_SIGNATURE "mist-checkpoint"
+#define CHECKPOINT_VERSION 1
+
+Checkpoint::Checkpoint(std::size_t nworkers)
+  : flag(false)
+  , nworkers(nworkers)
+  , positions(nworkers, 0)
+{}
+
+void
+Checkpoint::pause(std::size_t worker,
+                  count_t next,
+                  std::vector<output_stream_ptr> const& streams)
+{
+  for (auto& out : streams) {
+    out->flush();
+  }
+  std::unique_lock<std::mutex> lock(m);
+  if (!flag) {
+    // released before we got here
+    return;
+  }
+  auto gen = generation;
+  positions[worker] = next;
+  npaused++;
+  cv.notify_all();
+  cv.wait(lock, [this, gen] { return generation != gen; });
+}
+
+void
+Checkpoint::finish(std::size_t worker,
+                   count_t next,
+                   std::vector<output_stream_ptr> const& streams)
+{
+  for (auto& out : streams) {
+    out->flush();
+  }
+  std::unique_lock<std::mutex> lock(m);
+  positions[worker] = next;
+  nfinished++;
+  cv.notify_all();
+}
+
+bool
+Checkpoint::wait_done(std::chrono::seconds interval)
+{
+  std::unique_lock<std::mutex> lock(m);
+  return cv.wait_for(
+    lock, interval, [this] { return nfinished == nworkers; });
+}
+
+std::vector<Checkpoint::count_t>
+Checkpoint::pause_all()
+{
+  std::unique_lock<std::mutex> lock(m);
+  flag = true;
+  cv.wait(lock, [this] { return npaused + nfinished == nworkers; });
+  return positions;
+}
+
+void
+Checkpoint::release()
+{
+  std::unique_lock<std::mutex> lock(m);
+  flag = false;
+  npaused = 0;
+  generation++;
+  cv.notify_all();
+}
+
+void
+Checkpoint::write_file(std::string const& filename, state const& s)
+{
+  // write a temporary file and rename so a crash never leaves a partial
+  // checkpoint behind
+  auto tmp = filename + ".tmp";
+  {
+    std::ofstream ofs(tmp);
+    if (!ofs.is_open()) {
+      throw CheckpointException("write_file",
+                                "Could not open file '" + tmp +
+                                  "' for writing: " + std::strerror(errno));
+    }
+    ofs << CHECKPOINT_SIGNATURE << " " << CHECKPOINT_VERSION << "\n";
+    ofs << "tuple_count " << s.tuple_count << "\n";
+    ofs << "total_ranks " << s.total_ranks << "\n";
+    ofs << "start_rank " << s.start_rank << "\n";
+    ofs << "ranks " << s.next.size() << "\n";
+    ofs << "offset " << s.offset << "\n";
+    for (std::size_t ii = 0; ii < s.next.size(); ii++) {
+      ofs << "worker " << s.next[ii] << " " << s.stop[ii] << "\n";
+    }
+    // outfile last, the name may contain spaces
+    ofs << "outfile " << s.outfile << "\n";
+    ofs.flush();
+    if (!ofs) {
+      throw CheckpointException("write_file",
+                                "Error writing file '" + tmp + "'");
+    }
+  }
+  if (std::rename(tmp.c_str(), filename.c_str())) {
+    throw CheckpointException("write_file",
+                              "Could not rename '" + tmp + "' to '" +
+                                filename + "': " + std::strerror(errno));
+  }
+}
+
+Checkpoint::state
+Checkpoint::read_file(std::string const& filename)
+{
+  std::ifstream ifs(filename);
+  if (!ifs.is_open()) {
+    throw CheckpointException("read_file",
+                              "Could not open file '" + filename +
+                                "': " + std::strerror(errno));
+  }
+  state s;
+  std::string key;
+  int version = 0;
+  std::size_t ranks = 0;
+  ifs >> key >> version;
+  if (key != CHECKPOINT_SIGNATURE || version != CHECKPOINT_VERSION) {
+    throw CheckpointException("read_file",
+                              "File '" + filename +
+                                "' is not a supported checkpoint file");
+  }
+  while (ifs >> key) {
+    if (key == "tuple_count") {
+      ifs >> s.tuple_count;
+    } else if (key == "total_ranks") {
+      ifs >> s.total_ranks;
+    } else if (key == "start_rank") {
+      ifs >> s.start_rank;
+    } else if (key == "ranks") {
+      ifs >> ranks;
+    } else if (key == "offset") {
+      ifs >> s.offset;
+    } else if (key == "worker") {
+      count_t next, stop;
+      ifs >> next >> stop;
+      s.next.push_back(next);
+      s.stop.push_back(stop);
+    } else if (key == "outfile") {
+      ifs.get();
+      std::getline(ifs, s.outfile);
+    } else {
+      throw CheckpointException("read_file",
+                                "Unexpected key '" + key + "' in file '" +
+                                  filename + "'");
+    }
+  }
+  if (!ranks || s.next.size() != ranks || s.outfile.empty()) {
+    throw CheckpointException("read_file",
+                              "Checkpoint file '" + filename +
+                                "' is incomplete");
+  }
+  return s;
+}
@@ -0,0 +1,101 @@
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+#include "algorithm/Checkpoint.hpp"
+
+using namespace mist;
+using namespace algorithm;
+
+BOOST_AUTO_TEST_CASE(file_roundtrip)
+{
+  Checkpoint::state s;
+  s.tuple_count = 1000;
+  s.total_ranks = 4;
+  s.start_rank = 2;
+  s.outfile = "results with spaces.csv";
+  s.offset = 12345;
+  s.next = { 510, 760 };
+  s.stop = { 750, 1000 };
+
+  std::string filename = "Checkpoint.test.ckpt";
+  Checkpoint::write_file(filename, s);
+  auto r = Checkpoint::read_file(filename);
+  std::remove(filename.c_str());
+
+  BOOST_TEST(r.tuple_count == s.tuple_count);
+  BOOST_TEST(r.total_ranks == s.total_ranks);
+  BOOST_TEST(r.start_rank == s.start_rank);
+  BOOST_TEST(r.outfile == s.outfile);
+  BOOST_TEST(r.offset == s.offset);
+  BOOST_TEST(r.next == s.next);
+  BOOST_TEST(r.stop == s.stop);
+}
+
+BOOST_AUTO_TEST_CASE(read_bad_file)
+{
+  std::string filename = "Checkpoint.test.bad";
+  {
+    std::ofstream ofs(filename);
+    ofs << "not a checkpoint\n";
+  }
+  BOOST_CHECK_THROW(Checkpoint::read_file(filename), CheckpointException);
+  std::remove(filename.c_str());
+  BOOST_CHECK_THROW(Checkpoint::read_file(filename), CheckpointException);
+}
+
+BOOST_AUTO_TEST_CASE(pause_release)
+{
+  Checkpoint cp(2);
+  std::atomic<Checkpoint::count_t> pos0(0);
+  std::atomic<bool> stop(false);
+  // worker 0 runs until told to stop, worker 1 finishes immediately
+  std::thread w0([&] {
+    while (!stop) {
+      if (cp.requested()) {
+        cp.pause(0, pos0, {});
+      }
+      pos0++;
+    }
+    cp.finish(0, pos0, {});
+  });
+  cp.finish(1, 42, {});
+
+  auto positions = cp.pause_all();
+  auto paused_at = pos0.load();
+  BOOST_TEST(positions[0] == paused_at);
+  BOOST_TEST(positions[1] == 42);
+  // worker 0 does not move while paused
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  BOOST_TEST(pos0.load() == paused_at);
+  cp.release();
+
+  stop = true;
+  BOOST_TEST(cp.wait_done(std::chrono::seconds(10)));
+  w0.join();
+}
+
+// counts flushes instead of writing
+class FlushCount : public io::OutputStream
+{
+public:
+  int flushes = 0;
+  FlushCount()
+    : io::OutputStream(mutex_ptr(new mutex_type))
+  {}
+  void push(std::size_t, tuple_type const&, result_type const&){};
+  void push(std::size_t, tuple_type const&, it::entropy_type){};
+  void flush() { flushes++; };
+};
+
+BOOST_AUTO_TEST_CASE(finish_flushes)
+{
+  // the results of a finished worker are written before its position is
+  // recorded, same as a paused one
+  Checkpoint cp(1);
+  auto out = std::make_shared<FlushCount>();
+  cp.finish(0, 42, { out });
+  BOOST_TEST(out->flushes == 1);
+  BOOST_TEST(cp.pause_all()[0] == 42);
+}
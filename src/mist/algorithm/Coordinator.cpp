@@ -0,0 +1,607 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "algorithm/Coordinator.hpp"
+
+using namespace mist;
+using namespace mist::algorithm;
+
+#define MANIFEST_SIGNATURE "mist-manifest"
+#define MANIFEST_VERSION 1
+#define POLL_INTERVAL_MS 200
+// how long to wait for connected workers to hear that the search is done
+#define SHUTDOWN_SECONDS 10
+
+static sockaddr_un
+make_address(std::string const& path)
+{
+  sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    throw CoordinatorException("Coordinator",
+                               "Socket path '" + path + "' is too long");
+  }
+  std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  return addr;
+}
+
+static bool
+write_line(int fd, std::string const& line)
+{
+  auto msg = line + "\n";
+  std::size_t sent = 0;
+  while (sent < msg.size()) {
+    auto n = ::send(fd, msg.data() + sent, msg.size() - sent, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    sent += n;
+  }
+  return true;
+}
+
+// Append available bytes to buffer, false on EOF or error
+static bool
+read_some(int fd, std::string& buffer)
+{
+  char buf[4096];
+  auto n = ::recv(fd, buf, sizeof(buf), 0);
+  if (n < 0 && errno == EINTR) {
+    return true;
+  }
+  if (n <= 0) {
+    return false;
+  }
+  buffer.append(buf, n);
+  return true;
+}
+
+static bool
+pop_line(std::string& buffer, std::string& line)
+{
+  auto pos = buffer.find('\n');
+  if (pos == std::string::npos) {
+    return false;
+  }
+  line = buffer.substr(0, pos);
+  buffer.erase(0, pos + 1);
+  return true;
+}
+
+//
+// Coordinator
+//
+
+Coordinator::Coordinator(std::string const& socket_path, count_t tuple_count)
+  : socket_path(socket_path)
+  , tuple_count(tuple_count)
+{
+  if (tuple_count) {
+    pending.push_back({ 0, tuple_count });
+    pending_tuples = tuple_count;
+  }
+  auto addr = make_address(socket_path);
+  listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listen_fd < 0) {
+    throw CoordinatorException("Coordinator",
+                               std::string("Could not create socket: ") +
+                                 std::strerror(errno));
+  }
+  ::unlink(socket_path.c_str());
+  if (::bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) ||
+      ::listen(listen_fd, SOMAXCONN)) {
+    auto err = std::string(std::strerror(errno));
+    ::close(listen_fd);
+    throw CoordinatorException("Coordinator",
+                               "Could not listen on '" + socket_path +
+                                 "': " + err);
+  }
+}
+
+Coordinator::~Coordinator()
+{
+  for (auto const& p : peers) {
+    ::close(p.fd);
+  }
+  if (listen_fd >= 0) {
+    ::close(listen_fd);
+    ::unlink(socket_path.c_str());
+  }
+}
+
+void
+Coordinator::set_chunk_seconds(double seconds)
+{
+  if (seconds <= 0) {
+    throw CoordinatorException("set_chunk_seconds",
+                               "Chunk duration must be positive");
+  }
+  chunk_seconds = seconds;
+}
+
+void
+Coordinator::set_min_chunk(count_t tuples)
+{
+  min_chunk = std::max<count_t>(tuples, 1);
+}
+
+void
+Coordinator::set_lease_seconds(double seconds)
+{
+  lease_seconds = seconds;
+}
+
+std::vector<Coordinator::chunk> const&
+Coordinator::completed() const
+{
+  return done;
+}
+
+// Chunks last about chunk_seconds at the measured throughput of the worker,
+// starting with a small probe. Near the end chunks shrink so the remaining
+// tuples are shared by all workers.
+Coordinator::count_t
+Coordinator::chunk_size(peer const& p) const
+{
+  count_t size = (p.throughput > 0) ? p.throughput * chunk_seconds
+                                    : tuple_count / 1000;
+  count_t nworkers = 0;
+  for (auto const& other : peers) {
+    nworkers += other.hello;
+  }
+  size = std::min(size, pending_tuples / (2 * std::max<count_t>(nworkers, 1)));
+  return std::max(size, min_chunk);
+}
+
+bool
+Coordinator::assign(peer& p)
+{
+  if (pending.empty()) {
+    return false;
+  }
+  auto& range = pending.front();
+  auto size = std::min(chunk_size(p), range.second - range.first);
+  p.start = range.first;
+  p.stop = range.first + size;
+  range.first += size;
+  if (range.first == range.second) {
+    pending.pop_front();
+  }
+  pending_tuples -= size;
+  p.busy = true;
+  p.waiting = false;
+  p.assigned = clock::now();
+  return write_line(p.fd, "CHUNK " + std::to_string(p.start) + " " +
+                            std::to_string(p.stop));
+}
+
+void
+Coordinator::requeue(peer& p)
+{
+  if (p.busy) {
+    pending.push_front({ p.start, p.stop });
+    pending_tuples += p.stop - p.start;
+    p.busy = false;
+  }
+}
+
+bool
+Coordinator::handle(peer& p, std::string const& line)
+{
+  std::istringstream iss(line);
+  std::string cmd;
+  iss >> cmd;
+  if (cmd == "HELLO") {
+    count_t count = 0;
+    iss >> count;
+    iss.get();
+    std::getline(iss, p.shard);
+    if (count != tuple_count) {
+      write_line(p.fd, "ERROR TupleSpace has " + std::to_string(count) +
+                         " tuples, the coordinator has " +
+                         std::to_string(tuple_count));
+      return false;
+    }
+    p.hello = true;
+    return true;
+  } else if (cmd == "NEXT" && p.hello && !p.busy) {
+    p.waiting = true;
+    return true;
+  } else if (cmd == "REPORT" && p.busy) {
+    chunk c;
+    double seconds = 0;
+    iss >> c.start >> c.stop >> seconds >> c.begin >> c.end;
+    if (!iss || c.start != p.start || c.stop != p.stop) {
+      return false;
+    }
+    c.shard = p.shard;
+    done.push_back(c);
+    done_tuples += c.stop - c.start;
+    double throughput = (c.stop - c.start) / std::max(seconds, 1e-3);
+    p.throughput =
+      (p.throughput > 0) ? 0.5 * (p.throughput + throughput) : throughput;
+    p.busy = false;
+    return true;
+  }
+  return false;
+}
+
+void
+Coordinator::drop(std::size_t index)
+{
+  requeue(peers[index]);
+  ::close(peers[index].fd);
+  peers.erase(peers.begin() + index);
+}
+
+void
+Coordinator::run()
+{
+  std::vector<pollfd> fds;
+  auto shutdown_deadline = clock::time_point::max();
+  while (true) {
+    bool finished = (done_tuples == tuple_count);
+    if (finished) {
+      // tell workers there is nothing left, then stop once they are gone
+      if (shutdown_deadline == clock::time_point::max()) {
+        shutdown_deadline =
+          clock::now() + std::chrono::seconds(SHUTDOWN_SECONDS);
+      }
+      for (std::size_t ii = peers.size(); ii-- > 0;) {
+        if (peers[ii].waiting) {
+          write_line(peers[ii].fd, "DONE");
+          drop(ii);
+        }
+      }
+      if (peers.empty() || clock::now() > shutdown_deadline) {
+        break;
+      }
+    } else {
+      for (auto& p : peers) {
+        if (p.waiting && !p.busy && !pending.empty()) {
+          assign(p);
+        }
+      }
+    }
+
+    fds.assign(1, pollfd{ listen_fd, POLLIN, 0 });
+    for (auto const& p : peers) {
+      fds.push_back(pollfd{ p.fd, POLLIN, 0 });
+    }
+    auto ready = ::poll(fds.data(), fds.size(), POLL_INTERVAL_MS);
+    if (ready < 0 && errno != EINTR) {
+      throw CoordinatorException("run",
+                                 std::string("poll failed: ") +
+                                   std::strerror(errno));
+    }
+
+    // read requests, dropping workers that disconnected or misbehaved
+    std::vector<bool> dead(peers.size(), false);
+    for (std::size_t ii = 0; ready > 0 && ii < peers.size(); ii++) {
+      if (!fds[ii + 1].revents) {
+        continue;
+      }
+      auto& p = peers[ii];
+      if (!read_some(p.fd, p.buffer)) {
+        dead[ii] = true;
+        continue;
+      }
+      std::string line;
+      while (!dead[ii] && pop_line(p.buffer, line)) {
+        dead[ii] = !handle(p, line);
+      }
+    }
+    if (lease_seconds > 0) {
+      auto now = clock::now();
+      for (std::size_t ii = 0; ii < peers.size(); ii++) {
+        std::chrono::duration<double> held = now - peers[ii].assigned;
+        if (peers[ii].busy && held.count() > lease_seconds) {
+          dead[ii] = true;
+        }
+      }
+    }
+    for (std::size_t ii = peers.size(); ii-- > 0;) {
+      if (dead[ii]) {
+        drop(ii);
+      }
+    }
+
+    // accept new workers
+    if (ready > 0 && (fds[0].revents & POLLIN)) {
+      int fd = ::accept(listen_fd, nullptr, nullptr);
+      if (fd >= 0) {
+        peer p;
+        p.fd = fd;
+        peers.push_back(p);
+      }
+    }
+  }
+}
+
+void
+Coordinator::write_manifest(std::string const& filename) const
+{
+  write_manifest(filename, tuple_count, done);
+}
+
+void
+Coordinator::write_manifest(std::string const& filename,
+                            count_t tuple_count,
+                            std::vector<chunk> chunks)
+{
+  std::sort(chunks.begin(), chunks.end(), [](chunk const& a, chunk const& b) {
+    return a.start < b.start;
+  });
+  std::ofstream ofs(filename);
+  if (!ofs.is_open()) {
+    throw CoordinatorException("write_manifest",
+                               "Could not open file '" + filename +
+                                 "' for writing: " + std::strerror(errno));
+  }
+  ofs << MANIFEST_SIGNATURE << " " << MANIFEST_VERSION << "\n";
+  ofs << "tuple_count " << tuple_count << "\n";
+  // shard name last, it may contain spaces
+  for (auto const& c : chunks) {
+    ofs << "chunk " << c.start << " " << c.stop << " " << c.begin << " "
+        << c.end << " " << c.shard << "\n";
+  }
+  if (!ofs) {
+    throw CoordinatorException("write_manifest",
+                               "Error writing file '" + filename + "'");
+  }
+}
+
+std::vector<Coordinator::chunk>
+Coordinator::read_manifest(std::string const& filename)
+{
+  std::ifstream ifs(filename);
+  if (!ifs.is_open()) {
+    throw CoordinatorException("read_manifest",
+                               "Could not open file '" + filename +
+                                 "': " + std::strerror(errno));
+  }
+  std::string key;
+  int version = 0;
+  ifs >> key >> version;
+  if (key != MANIFEST_SIGNATURE || version != MANIFEST_VERSION) {
+    throw CoordinatorException("read_manifest",
+                               "File '" + filename +
+                                 "' is not a supported manifest file");
+  }
+  std::vector<chunk> chunks;
+  while (ifs >> key) {
+    if (key == "tuple_count") {
+      count_t count;
+      ifs >> count;
+    } else if (key == "chunk") {
+      chunk c;
+      ifs >> c.start >> c.stop >> c.begin >> c.end;
+      ifs.get();
+      std::getline(ifs, c.shard);
+      chunks.push_back(c);
+    } else {
+      throw CoordinatorException("read_manifest",
+                                 "Unexpected key '" + key + "' in file '" +
+                                   filename + "'");
+    }
+  }
+  return chunks;
+}
+
+// Copy bytes [begin,end) of a file to offset of another
+static void
+copy_range(std::string const& src, int out, Coordinator::count_t begin,
+           Coordinator::count_t end, Coordinator::count_t offset,
+           std::vector<char>& buffer)
+{
+  int in = open(src.c_str(), O_RDONLY);
+  if (in < 0) {
+    throw CoordinatorException("merge_manifest",
+                               "Could not open shard '" + src +
+                                 "': " + std::strerror(errno));
+  }
+  while (begin < end) {
+    auto want = std::min<Coordinator::count_t>(buffer.size(), end - begin);
+    auto got = pread(in, buffer.data(), want, begin);
+    if (got <= 0) {
+      close(in);
+      throw CoordinatorException("merge_manifest",
+                                 "Could not read shard '" + src + "'");
+    }
+    for (ssize_t put = 0; put < got;) {
+      auto n = pwrite(out, buffer.data() + put, got - put, offset + put);
+      if (n < 0) {
+        close(in);
+        throw CoordinatorException("merge_manifest",
+                                   std::string("Could not write: ") +
+                                     std::strerror(errno));
+      }
+      put += n;
+    }
+    begin += got;
+    offset += got;
+  }
+  close(in);
+}
+
+Coordinator::count_t
+Coordinator::merge_manifest(std::string const& manifest,
+                            std::string const& outfile,
+                            std::size_t threads)
+{
+  auto chunks = read_manifest(manifest);
+  if (chunks.empty()) {
+    throw CoordinatorException("merge_manifest",
+                               "No chunks in manifest '" + manifest + "'");
+  }
+  // the header is whatever precedes the first chunk of the first shard
+  auto const& first = chunks.front().shard;
+  count_t header = chunks.front().begin;
+  for (auto const& c : chunks) {
+    if (c.shard == first) {
+      header = std::min(header, c.begin);
+    }
+  }
+  std::vector<count_t> offsets;
+  count_t size = header;
+  for (auto const& c : chunks) {
+    offsets.push_back(size);
+    size += c.end - c.begin;
+  }
+
+  int out = open(outfile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (out < 0) {
+    throw CoordinatorException("merge_manifest",
+                               "Could not open file '" + outfile +
+                                 "' for writing: " + std::strerror(errno));
+  }
+  if (ftruncate(out, size)) {
+    close(out);
+    throw CoordinatorException("merge_manifest",
+                               "Could not size file '" + outfile +
+                                 "': " + std::strerror(errno));
+  }
+  // chunks interleaved among threads, the first also copies the header
+  threads = std::max<std::size_t>(1, std::min(threads, chunks.size()));
+  std::vector<std::exception_ptr> errors(threads);
+  auto copy_chunks = [&](std::size_t t) {
+    std::vector<char> buffer(1 << 20);
+    try {
+      if (t == 0) {
+        copy_range(first, out, 0, header, 0, buffer);
+      }
+      for (auto ii = t; ii < chunks.size(); ii += threads) {
+        auto const& c = chunks[ii];
+        copy_range(c.shard, out, c.begin, c.end, offsets[ii], buffer);
+      }
+    } catch (...) {
+      errors[t] = std::current_exception();
+    }
+  };
+  std::vector<std::thread> pool;
+  for (std::size_t t = 1; t < threads; t++) {
+    pool.emplace_back(copy_chunks, t);
+  }
+  copy_chunks(0);
+  for (auto& thread : pool) {
+    thread.join();
+  }
+  close(out);
+  for (auto const& e : errors) {
+    if (e) {
+      std::rethrow_exception(e);
+    }
+  }
+  return size;
+}
+
+//
+// CoordinatorClient
+//
+
+CoordinatorClient::CoordinatorClient(std::string const& socket_path,
+                                     double timeout_seconds)
+{
+  auto addr = make_address(socket_path);
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::duration<double>(timeout_seconds);
+  while (true) {
+    fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && !::connect(fd, (sockaddr*)&addr, sizeof(addr))) {
+      return;
+    }
+    auto err = std::string(std::strerror(errno));
+    if (fd >= 0) {
+      ::close(fd);
+      fd = -1;
+    }
+    if (std::chrono::steady_clock::now() > deadline) {
+      throw CoordinatorException("CoordinatorClient",
+                                 "Could not connect to '" + socket_path +
+                                   "': " + err);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+}
+
+CoordinatorClient::~CoordinatorClient()
+{
+  if (fd >= 0) {
+    ::close(fd);
+  }
+}
+
+void
+CoordinatorClient::send(std::string const& line)
+{
+  if (!write_line(fd, line)) {
+    throw CoordinatorException("CoordinatorClient",
+                               "Connection to coordinator lost");
+  }
+}
+
+std::string
+CoordinatorClient::receive()
+{
+  std::string line;
+  while (!pop_line(buffer, line)) {
+    if (!read_some(fd, buffer)) {
+      throw CoordinatorException("CoordinatorClient",
+                                 "Connection to coordinator lost");
+    }
+  }
+  return line;
+}
+
+void
+CoordinatorClient::hello(count_t tuple_count, std::string const& shard)
+{
+  send("HELLO " + std::to_string(tuple_count) + " " + shard);
+}
+
+bool
+CoordinatorClient::next(count_t& start, count_t& stop)
+{
+  send("NEXT");
+  auto line = receive();
+  std::istringstream iss(line);
+  std::string cmd;
+  iss >> cmd;
+  if (cmd == "CHUNK") {
+    iss >> start >> stop;
+    return true;
+  } else if (cmd == "DONE") {
+    return false;
+  }
+  throw CoordinatorException("CoordinatorClient",
+                             "Coordinator replied '" + line + "'");
+}
+
+void
+CoordinatorClient::report(count_t start,
+                          count_t stop,
+                          double seconds,
+                          count_t begin,
+                          count_t end)
+{
+  std::ostringstream oss;
+  oss << "REPORT " << start << " " << stop << " " << seconds << " " << begin
+      << " " << end;
+  send(oss.str());
+}
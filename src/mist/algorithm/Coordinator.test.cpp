@@ -0,0 +1,124 @@
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+#include "algorithm/Coordinator.hpp"
+
+using namespace mist;
+using namespace algorithm;
+
+BOOST_AUTO_TEST_CASE(chunks_cover_space)
+{
+  std::string socket = "Coordinator.test.sock";
+  Coordinator::count_t N = 10000;
+  Coordinator coordinator(socket, N);
+  coordinator.set_chunk_seconds(0.01);
+  coordinator.set_min_chunk(7);
+  std::thread server([&] { coordinator.run(); });
+
+  auto work = [&](std::string const& shard) {
+    CoordinatorClient client(socket, 10);
+    client.hello(N, shard);
+    Coordinator::count_t start, stop, offset = 0;
+    while (client.next(start, stop)) {
+      client.report(start, stop, 0.001, offset, offset + stop - start);
+      offset += stop - start;
+    }
+  };
+  // takes a chunk and dies without reporting it
+  std::thread quitter([&] {
+    CoordinatorClient client(socket, 10);
+    client.hello(N, "quitter");
+    Coordinator::count_t start, stop;
+    client.next(start, stop);
+  });
+  quitter.join();
+  std::thread w0(work, "shard 0");
+  std::thread w1(work, "shard 1");
+  w0.join();
+  w1.join();
+  server.join();
+
+  auto chunks = coordinator.completed();
+  std::sort(chunks.begin(), chunks.end(),
+            [](Coordinator::chunk const& a, Coordinator::chunk const& b) {
+              return a.start < b.start;
+            });
+  Coordinator::count_t next = 0;
+  for (auto const& c : chunks) {
+    BOOST_TEST(c.start == next);
+    BOOST_TEST(c.stop > c.start);
+    BOOST_TEST(c.shard != "quitter");
+    next = c.stop;
+  }
+  BOOST_TEST(next == N);
+
+  std::string manifest = "Coordinator.test.manifest";
+  coordinator.write_manifest(manifest);
+  auto read = Coordinator::read_manifest(manifest);
+  std::remove(manifest.c_str());
+  BOOST_TEST(read.size() == chunks.size());
+  for (std::size_t ii = 0; ii < read.size(); ii++) {
+    BOOST_TEST(read[ii].start == chunks[ii].start);
+    BOOST_TEST(read[ii].stop == chunks[ii].stop);
+    BOOST_TEST(read[ii].begin == chunks[ii].begin);
+    BOOST_TEST(read[ii].end == chunks[ii].end);
+    BOOST_TEST(read[ii].shard == chunks[ii].shard);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(reject_wrong_tuple_space)
+{
+  std::string socket = "Coordinator.test.sock";
+  Coordinator coordinator(socket, 100);
+  std::thread server([&] { coordinator.run(); });
+  {
+    CoordinatorClient client(socket, 10);
+    client.hello(99, "wrong");
+    Coordinator::count_t start, stop;
+    BOOST_CHECK_THROW(client.next(start, stop), CoordinatorException);
+  }
+  {
+    CoordinatorClient client(socket, 10);
+    client.hello(100, "right");
+    Coordinator::count_t start, stop;
+    while (client.next(start, stop)) {
+      client.report(start, stop, 0.001, 0, 0);
+    }
+  }
+  server.join();
+  BOOST_TEST(coordinator.completed().size() > 0);
+}
+
+BOOST_AUTO_TEST_CASE(merge_manifest)
+{
+  // two shards with a header each, chunks interleaved between them
+  std::string shards[2] = { "Coordinator.test.shard0", "Coordinator.test.shard1" };
+  {
+    std::ofstream a(shards[0]);
+    a << "h\n" << "0\n1\n" << "4\n5\n";
+    std::ofstream b(shards[1]);
+    b << "h\n" << "2\n3\n" << "6\n";
+  }
+  std::vector<Coordinator::chunk> chunks = { { 4, 6, 6, 10, shards[0] },
+                                             { 0, 2, 2, 6, shards[0] },
+                                             { 2, 4, 2, 6, shards[1] },
+                                             { 6, 7, 6, 8, shards[1] } };
+  std::string manifest = "Coordinator.test.manifest";
+  std::string merged = "Coordinator.test.merged";
+  Coordinator::write_manifest(manifest, 7, chunks);
+  for (std::size_t threads : { 1, 3 }) {
+    auto size = Coordinator::merge_manifest(manifest, merged, threads);
+    std::ifstream in(merged);
+    std::string text((std::istreambuf_iterator<char>(in)),
+                     std::istreambuf_iterator<char>());
+    BOOST_TEST(text == "h\n0\n1\n2\n3\n4\n5\n6\n");
+    BOOST_TEST(size == text.size());
+  }
+  for (auto f : { shards[0], shards[1], manifest, merged }) {
+    std::remove(f.c_str());
+  }
+}
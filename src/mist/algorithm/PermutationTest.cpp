@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <random>
+
+#include "Permutation.hpp"
+#include "algorithm/PermutationTest.hpp"
+
+using namespace mist;
+using namespace mist::algorithm;
+
+// Measures computed from the same counts can differ in the last bits
+#define PERMUTATION_TOLERANCE 1e-12
+
+// Sub-tuple positions of a d-tuple in the it::d layout, by size then
+// lexicographic
+static std::vector<PermutationTest::tuple_t>
+sub_tuple_positions(int d)
+{
+  std::vector<PermutationTest::tuple_t> subs;
+  for (int k = 1; k <= d; k++) {
+    std::vector<bool> mask(d, false);
+    std::fill(mask.begin(), mask.begin() + k, true);
+    do {
+      PermutationTest::tuple_t sub;
+      for (int ii = 0; ii < d; ii++) {
+        if (mask[ii]) {
+          sub.push_back(ii);
+        }
+      }
+      subs.push_back(sub);
+    } while (std::prev_permutation(mask.begin(), mask.end()));
+  }
+  return subs;
+}
+
+PermutationTest::PermutationTest(variables_ptr const& original,
+                                 tuple_t const& permuted,
+                                 count_t n,
+                                 unsigned seed)
+  : n(n)
+  , nvar(original->size())
+  , npermuted(permuted.size())
+  , slot(original->size(), -1)
+{
+  if (permuted.empty()) {
+    throw PermutationTestException("PermutationTest",
+                                   "No variables to permute");
+  }
+  for (std::size_t ii = 0; ii < npermuted; ii++) {
+    if (permuted[ii] >= nvar) {
+      throw PermutationTestException(
+        "PermutationTest",
+        "Permuted variable " + std::to_string(permuted[ii]) +
+          " out of range [0," + std::to_string(nvar) + ")");
+    }
+    slot[permuted[ii]] = ii;
+  }
+  for (int d = 0; d <= 4; d++) {
+    subs.push_back(sub_tuple_positions(d));
+  }
+
+  // copy k of permuted variable ii is variable nvar + k * npermuted + ii
+  vars = variables_ptr(new Variable::tuple(*original));
+  vars->reserve(nvar + n * npermuted);
+  std::size_t nsamples = (nvar) ? original->front().size() : 0;
+  IntegerPermutation perm(nsamples);
+  for (std::size_t ii = 0; ii < nsamples; ii++) {
+    perm[ii] = ii;
+  }
+  std::mt19937 gen(seed);
+  for (count_t k = 0; k < n; k++) {
+    perm.random(gen);
+    for (auto v : permuted) {
+      auto const& src = (*original)[v];
+      Variable copy(Variable::data_ptr(new Variable::data_t[nsamples]),
+                    nsamples, vars->size(), src.bins());
+      perm.apply(src, copy);
+      vars->push_back(copy);
+    }
+  }
+}
+
+bool
+PermutationTest::involved(tuple_t const& tuple) const
+{
+  for (auto v : tuple) {
+    if (slot[v] >= 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void
+PermutationTest::map(tuple_t const& tuple, count_t k, tuple_t& out) const
+{
+  out.resize(tuple.size());
+  for (std::size_t ii = 0; ii < tuple.size(); ii++) {
+    auto v = tuple[ii];
+    out[ii] = (slot[v] < 0) ? v : nvar + k * npermuted + slot[v];
+  }
+}
+
+PermutationTest::count_t
+PermutationTest::exceedances(it::Measure const& measure,
+                             it::EntropyCalculator& calc,
+                             tuple_t const& tuple,
+                             it::Entropy const* e,
+                             it::entropy_type observed,
+                             workspace& ws) const
+{
+  if (!involved(tuple)) {
+    return n;
+  }
+  auto d = tuple.size();
+  bool layout = e && d < subs.size() && e->size() == subs[d].size();
+  count_t count = 0;
+  for (count_t k = 0; k < n; k++) {
+    map(tuple, k, ws.mapped);
+    if (layout) {
+      ws.entropy = *e;
+      auto const& positions = subs[d];
+      for (std::size_t ss = 0; ss < positions.size(); ss++) {
+        auto const& sub = positions[ss];
+        if (sub.size() < 2) {
+          continue;
+        }
+        ws.sub.resize(sub.size());
+        bool changed = false;
+        for (std::size_t ii = 0; ii < sub.size(); ii++) {
+          ws.sub[ii] = ws.mapped[sub[ii]];
+          changed = changed || ws.sub[ii] >= nvar;
+        }
+        if (changed) {
+          ws.entropy[ss] = calc.entropy(ws.sub);
+        }
+      }
+      measure.compute(calc, ws.mapped, ws.entropy, ws.result);
+    } else {
+      measure.compute(calc, ws.mapped, ws.result);
+    }
+    if (ws.result.back() >= observed - PERMUTATION_TOLERANCE) {
+      count++;
+    }
+  }
+  return count;
+}
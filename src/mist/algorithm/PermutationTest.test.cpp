@@ -0,0 +1,80 @@
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <random>
+
+#include "algorithm/PermutationTest.hpp"
+#include "io/DataMatrix.hpp"
+#include "it/EntropyCalculator.hpp"
+#include "it/SymmetricDelta.hpp"
+
+using namespace mist;
+using namespace algorithm;
+
+// variable 1 is a copy of variable 0, the others are random
+static io::DataMatrix
+make_data(int nvar, int nrow)
+{
+  std::mt19937 gen(7);
+  std::vector<io::DataMatrix::data_t> data(nvar * nrow);
+  for (auto& x : data) {
+    x = gen() % 3;
+  }
+  std::copy(data.begin(), data.begin() + nrow, data.begin() + nrow);
+  return io::DataMatrix(data.data(), nvar, nrow);
+}
+
+BOOST_AUTO_TEST_CASE(permuted_copies)
+{
+  auto dm = make_data(4, 60);
+  auto vars = dm.variables();
+  PermutationTest test(vars, { 0, 2 }, 5, 1);
+  auto const& all = *test.variables();
+  BOOST_TEST(all.size() == 4 + 5 * 2);
+  for (std::size_t ii = 4; ii < all.size(); ii++) {
+    auto const& src = (*vars)[(ii % 2) ? 2 : 0];
+    std::vector<int> a(src.begin(), src.end());
+    std::vector<int> b(all[ii].begin(), all[ii].end());
+    std::sort(a.begin(), a.end());
+    std::sort(b.begin(), b.end());
+    BOOST_TEST(a == b);
+    BOOST_TEST(all[ii].index() == ii);
+  }
+  BOOST_TEST(test.involved({ 1, 2 }));
+  BOOST_TEST(!test.involved({ 1, 3 }));
+  BOOST_CHECK_THROW(PermutationTest(vars, { 4 }, 5, 1), PermutationTestException);
+}
+
+BOOST_AUTO_TEST_CASE(exceedances)
+{
+  auto dm = make_data(4, 60);
+  auto vars = dm.variables();
+  std::size_t n = 50;
+  PermutationTest test(vars, { 0 }, n, 3);
+  it::EntropyCalculator calc(vars);
+  it::EntropyCalculator perm_calc(test.variables());
+  it::SymmetricDelta measure;
+  PermutationTest::workspace ws;
+
+  // no permuted variable, every permutation ties
+  auto res = measure.compute(calc, { 1, 2 });
+  BOOST_TEST(test.exceedances(measure, perm_calc, { 1, 2 }, nullptr,
+                              res.back(), ws) == n);
+
+  // dependence is broken by every permutation
+  res = measure.compute(calc, { 0, 1 });
+  BOOST_TEST(test.exceedances(measure, perm_calc, { 0, 1 }, nullptr,
+                              res.back(), ws) == 0);
+
+  // reusing the unpermuted entropies gives the same counts
+  for (Variable::indexes tuple : { Variable::indexes{ 0, 2 },
+                                   Variable::indexes{ 0, 2, 3 } }) {
+    res = measure.compute(calc, tuple);
+    it::Entropy e(res.begin(), res.begin() + (1 << tuple.size()) - 1);
+    auto full = test.exceedances(measure, perm_calc, tuple, nullptr,
+                                 res.back(), ws);
+    auto reused = test.exceedances(measure, perm_calc, tuple, &e,
+                                   res.back(), ws);
+    BOOST_TEST(full == reused);
+    BOOST_TEST(full > 0);
+  }
+}
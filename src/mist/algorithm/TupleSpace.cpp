@@ -1,8 +1,15 @@
 #include "it/Entropy.hpp"
 #include "binomial.hpp"
 #include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <limits>
 #include <map>
 #include <set>
+#include <type_traits>
 
 #if BOOST_PYTHON_EXTENSIONS
 #include <boost/python/extract.hpp>
@@ -35,6 +42,35 @@ TupleSpace::TupleSpace(int N, int d)
   this->addVariableGroupTuple(groupTuple);
 };
 
+// delta space for N_new variables appended after N_old variables
+TupleSpace::TupleSpace(int N_old, int N_new, int d)
+  : tuple_size(d)
+{
+  if (N_new == 0 || d == 0) {
+    throw TupleSpaceException("TupleSpace",
+                              "Number of new variables and dimension cannot be zero.");
+  }
+  tuple_t old_vars(N_old);
+  tuple_t new_vars(N_new);
+  for (int ii = 0; ii < N_old; ii++) {
+    old_vars[ii] = ii;
+  }
+  for (int ii = 0; ii < N_new; ii++) {
+    new_vars[ii] = N_old + ii;
+  }
+  int old_group = (N_old) ? this->addVariableGroup("old", old_vars) : -1;
+  int new_group = this->addVariableGroup("new", new_vars);
+  // one group tuple for each number of new variables in the tuple
+  for (int nn = 1; nn <= d; nn++) {
+    if (nn > N_new || d - nn > N_old) {
+      continue;
+    }
+    tuple_t groupTuple(d - nn, old_group);
+    groupTuple.resize(d, new_group);
+    this->addVariableGroupTuple(groupTuple);
+  }
+};
+
 std::vector<std::string>
 TupleSpace::names() const
 {
@@ -71,6 +107,10 @@ TupleSpace::addVariableGroupTuple(std::vector<std::string> const& groupNames)
 void
 TupleSpace::addVariableGroupTuple(TupleSpace::tuple_t const& groupIndexes)
 {
+  if (!tupleList.empty()) {
+    throw TupleSpaceException("addVariableGroupTuple",
+                              "TupleSpace already defined by a tuple list.");
+  }
   // validate tuple size
   if (!tuple_size) {
     tuple_size = groupIndexes.size();
@@ -94,6 +134,10 @@ int
 TupleSpace::addVariableGroup(std::string const& name,
                              TupleSpace::tuple_t const& vars)
 {
+  if (!tupleList.empty()) {
+    throw TupleSpaceException("addVariableGroup",
+                              "TupleSpace already defined by a tuple list.");
+  }
   std::set<int> unique_vars;
   tuple_t group;
   for (auto var : vars) {
@@ -120,6 +164,218 @@ TupleSpace::addVariableGroup(std::string const& name,
   return index;
 }
 
+void
+TupleSpace::checkTupleSize(std::size_t d, std::string const& method)
+{
+  if (!variableGroups.empty()) {
+    throw TupleSpaceException(
+      method, "TupleSpace already defined by variable groups.");
+  }
+  if (!d) {
+    throw TupleSpaceException(method, "Tuple size cannot be zero.");
+  }
+  if (!tuple_size) {
+    tuple_size = d;
+  } else if ((std::size_t)tuple_size != d) {
+    throw TupleSpaceException(
+      method, "Could not add tuple, all tuples must be the same size");
+  }
+}
+
+void
+TupleSpace::addTuple(tuple_t const& tuple)
+{
+  checkTupleSize(tuple.size(), "addTuple");
+  tuple_t sorted(tuple);
+  std::sort(sorted.begin(), sorted.end());
+  if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+    throw TupleSpaceException("addTuple",
+                              "variable listed twice in the same tuple.");
+  }
+  tupleList.insert(tupleList.end(), sorted.begin(), sorted.end());
+}
+
+void
+TupleSpace::addTuples(tuple_t const& tuples, int d)
+{
+  if (d <= 0 || tuples.size() % d) {
+    throw TupleSpaceException("addTuples",
+                              "Packed tuple array length is not a multiple "
+                              "of the tuple size " +
+                                std::to_string(d));
+  }
+  checkTupleSize(d, "addTuples");
+  tupleList.reserve(tupleList.size() + tuples.size());
+  tuple_t tuple(d);
+  for (std::size_t ii = 0; ii < tuples.size(); ii += d) {
+    std::copy(tuples.begin() + ii, tuples.begin() + ii + d, tuple.begin());
+    addTuple(tuple);
+  }
+  sortTuples();
+}
+
+static inline bool
+is_tuple_sep(char c)
+{
+  return (std::isspace(c) || c == ',');
+}
+
+void
+TupleSpace::loadTupleFile(std::string const& filename)
+{
+  std::ifstream ifs(filename);
+  if (!ifs.is_open()) {
+    throw TupleSpaceException("loadTupleFile",
+                              "Could not open tuple file '" + filename +
+                                "': " + std::strerror(errno));
+  }
+  std::string line;
+  tuple_t tuples;
+  int d = 0;
+  std::size_t lineno = 0;
+  while (std::getline(ifs, line)) {
+    lineno++;
+    // a header is only allowed on the first line, and has a letter, so
+    // negative or otherwise malformed indexes are not taken for one
+    bool data = false;
+    bool malformed = false;
+    for (char c : line) {
+      if (std::isdigit(c)) {
+        data = true;
+      } else if (!is_tuple_sep(c)) {
+        malformed = true;
+      }
+    }
+    if (malformed && lineno == 1 &&
+        std::any_of(line.begin(), line.end(), [](unsigned char c) { return std::isalpha(c); })) {
+      continue;
+    }
+    if (malformed) {
+      throw TupleSpaceException("loadTupleFile",
+                                "Error loading file " + filename + ":" +
+                                  std::to_string(lineno) +
+                                  " - expected variable indexes separated by commas or whitespace");
+    }
+    if (!data) {
+      continue;
+    }
+    int n = 0;
+    const char* pos = line.c_str();
+    while (*pos) {
+      if (std::isdigit(*pos)) {
+        char* end;
+        auto index = std::strtoull(pos, &end, 10);
+        if (index > std::numeric_limits<index_t>::max()) {
+          throw TupleSpaceException("loadTupleFile",
+                                    "Error loading file " + filename + ":" +
+                                      std::to_string(lineno) +
+                                      " - variable index out of range");
+        }
+        tuples.push_back(index);
+        pos = end;
+        n++;
+      } else {
+        pos++;
+      }
+    }
+    if (!d) {
+      d = n;
+    } else if (d != n) {
+      throw TupleSpaceException("loadTupleFile",
+                                "Error loading file " + filename + ":" +
+                                  std::to_string(lineno) +
+                                  " - number of columns not equal to " +
+                                  std::to_string(d));
+    }
+  }
+  if (!d) {
+    throw TupleSpaceException("loadTupleFile",
+                              "No tuples found in file '" + filename + "'");
+  }
+  addTuples(tuples, d);
+}
+
+void
+TupleSpace::loadTupleFileBinary(std::string const& filename, int d)
+{
+  std::ifstream ifs(filename, std::ifstream::binary | std::ifstream::ate);
+  if (!ifs.is_open()) {
+    throw TupleSpaceException("loadTupleFileBinary",
+                              "Could not open tuple file '" + filename +
+                                "': " + std::strerror(errno));
+  }
+  std::size_t bytes = ifs.tellg();
+  if (d <= 0 || bytes % (d * sizeof(index_t))) {
+    throw TupleSpaceException("loadTupleFileBinary",
+                              "File '" + filename +
+                                "' size is not a multiple of the tuple size");
+  }
+  tuple_t tuples(bytes / sizeof(index_t));
+  ifs.seekg(0, std::ios::beg);
+  ifs.read(reinterpret_cast<char*>(tuples.data()), bytes);
+  if (!ifs) {
+    throw TupleSpaceException("loadTupleFileBinary",
+                              "Error reading file '" + filename + "'");
+  }
+  addTuples(tuples, d);
+}
+
+void
+TupleSpace::sortTuples()
+{
+  if (tupleList.empty()) {
+    return;
+  }
+  std::size_t d = tuple_size;
+  std::size_t n = tupleList.size() / d;
+  // sort an index of tuple positions, then gather
+  std::vector<std::size_t> order(n);
+  for (std::size_t ii = 0; ii < n; ii++) {
+    order[ii] = ii;
+  }
+  auto const* base = tupleList.data();
+  std::sort(order.begin(), order.end(), [base, d](std::size_t a, std::size_t b) {
+    return std::lexicographical_compare(
+      base + a * d, base + a * d + d, base + b * d, base + b * d + d);
+  });
+  std::vector<index_t> sorted;
+  sorted.reserve(tupleList.size());
+  for (std::size_t ii = 0; ii < n; ii++) {
+    auto const* t = base + order[ii] * d;
+    // drop duplicate tuples
+    if (!sorted.empty() && std::equal(t, t + d, sorted.end() - d)) {
+      continue;
+    }
+    sorted.insert(sorted.end(), t, t + d);
+  }
+  tupleList.swap(sorted);
+}
+
+bool
+TupleSpace::isTupleList() const
+{
+  return !tupleList.empty();
+}
+
+std::size_t
+TupleSpace::num_variables() const
+{
+  std::size_t n = 0;
+  if (isTupleList()) {
+    auto max = std::max_element(tupleList.begin(), tupleList.end());
+    return *max + 1;
+  }
+  for (auto const& group_tuple : variableGroupTuples) {
+    for (auto group : group_tuple) {
+      auto const& vars = variableGroups[group];
+      if (!vars.empty()) {
+        n = std::max<std::size_t>(n, *std::max_element(vars.begin(), vars.end()) + 1);
+      }
+    }
+  }
+  return n;
+}
+
 TupleSpace::tuple_t const&
 TupleSpace::getVariableGroup(int index) const
 {
@@ -205,6 +461,88 @@ TupleSpace::pyAddVariableGroupTuple(p::list const& list)
   }
   addVariableGroupTuple(groups);
 }
+
+void
+TupleSpace::pyAddTuple(p::list const& list)
+{
+  int n = p::len(list);
+  algorithm::TupleSpace::tuple_t tuple(n);
+  for (int ii = 0; ii < n; ii++) {
+    p::extract<int> var(list[ii]);
+    if (var.check()) {
+      tuple[ii] = var;
+    } else {
+      throw TupleSpaceException("pyAddTuple",
+                                "Expected list with elements type int");
+    }
+  }
+  addTuple(tuple);
+}
+
+// unsigned indexes cannot be negative, without comparing them to 0
+template<typename T>
+static inline bool
+is_negative(T val, std::true_type)
+{
+  return val < 0;
+}
+template<typename T>
+static inline bool
+is_negative(T val, std::false_type)
+{
+  return false;
+}
+
+template<typename T>
+static void
+copy_ndarray_tuples(np::ndarray const& array, TupleSpace::tuple_t& tuples)
+{
+  auto nrow = array.shape(0);
+  auto ncol = array.shape(1);
+  auto rstride = array.get_strides()[0];
+  auto cstride = array.get_strides()[1];
+  auto data = array.get_data();
+  tuples.resize(nrow * ncol);
+  for (Py_intptr_t ii = 0; ii < nrow; ii++) {
+    for (Py_intptr_t jj = 0; jj < ncol; jj++) {
+      T val = *reinterpret_cast<T*>(data + ii * rstride + jj * cstride);
+      if (is_negative(val, std::is_signed<T>())) {
+        throw TupleSpaceException("pyAddTuples",
+                                  "Negative variable index in tuple array");
+      }
+      if (static_cast<std::uint64_t>(val) > std::numeric_limits<TupleSpace::index_t>::max()) {
+        throw TupleSpaceException("pyAddTuples",
+                                  "Variable index " + std::to_string(val) +
+                                    " in tuple array out of range");
+      }
+      tuples[ii * ncol + jj] = val;
+    }
+  }
+}
+
+void
+TupleSpace::pyAddTuples(np::ndarray const& array)
+{
+  if (array.get_nd() != 2) {
+    throw TupleSpaceException("pyAddTuples",
+                              "Expected 2-dimensional ndarray, one tuple per row");
+  }
+  tuple_t tuples;
+  auto dtype = array.get_dtype();
+  if (dtype == np::dtype::get_builtin<std::int32_t>()) {
+    copy_ndarray_tuples<std::int32_t>(array, tuples);
+  } else if (dtype == np::dtype::get_builtin<std::int64_t>()) {
+    copy_ndarray_tuples<std::int64_t>(array, tuples);
+  } else if (dtype == np::dtype::get_builtin<std::uint32_t>()) {
+    copy_ndarray_tuples<std::uint32_t>(array, tuples);
+  } else if (dtype == np::dtype::get_builtin<std::uint64_t>()) {
+    copy_ndarray_tuples<std::uint64_t>(array, tuples);
+  } else {
+    throw TupleSpaceException("pyAddTuples",
+                              "Invalid ndarray dtype, must be an integer type");
+  }
+  addTuples(tuples, array.shape(1));
+}
 #endif
 
 static std::vector<std::size_t>
@@ -250,6 +588,9 @@ TupleSpace::count_tuples_group_tuple(tuple_t const& group_tuple) const
 TupleSpace::count_t
 TupleSpace::count_tuples() const
 {
+  if (!tupleList.empty()) {
+    return tupleList.size() / tuple_size;
+  }
   count_t total = 0;
   for (auto const& group_tuple : this->variableGroupTuples) {
     total += count_tuples_group_tuple(group_tuple);
@@ -322,6 +663,10 @@ find_index(TupleSpace::tuple_t const& group_tuple,
 TupleSpace::tuple_t
 TupleSpace::find_tuple(count_t target) const
 {
+  if (!tupleList.empty()) {
+    throw TupleSpaceException("find_tuple",
+                              "Not defined for tuple lists, use get_tuple.");
+  }
   // The fast-forward algorithm maintains a skipped tuple count so that when
   // the count equals the target count we have found the target tuple.
   count_t count = 0;
@@ -344,6 +689,128 @@ TupleSpace::find_tuple(count_t target) const
   return ret;
 }
 
+TupleSpace::tuple_t
+TupleSpace::get_tuple(count_t target) const
+{
+  if (target >= count_tuples()) {
+    throw TupleSpaceException("get_tuple",
+                              "tuple number " + std::to_string(target) +
+                                " out of range.");
+  }
+  if (!tupleList.empty()) {
+    auto it = tupleList.begin() + target * tuple_size;
+    return tuple_t(it, it + tuple_size);
+  }
+  auto ffw = find_tuple(target);
+  auto const& group_tuple = variableGroupTuples[ffw[0]];
+  tuple_t tuple(tuple_size);
+  for (int ii = 0; ii < tuple_size; ii++) {
+    tuple[ii] = variableGroups[group_tuple[ii]][ffw[ii + 1]];
+  }
+  return tuple;
+}
+
+static void
+traverse_list(TupleSpace const& ts, std::vector<TupleSpace::index_t> const& list, TupleSpace::count_t start, TupleSpace::count_t stop, TupleSpaceTraverser& traverser)
+{
+  std::size_t d = ts.tupleSize();
+  TupleSpace::count_t n = list.size() / d;
+  TupleSpace::tuple_t tuple(d);
+  for (auto count = start; count < stop && count < n; count++) {
+    auto it = list.begin() + count * d;
+    std::copy(it, it + d, tuple.begin());
+    traverser.process_tuple(count, tuple);
+  }
+}
+
+// Positions of the sub-tuples of a d-tuple, in the same order as the
+// it::d2, it::d3, it::d4 entropy layouts: by size, then lexicographic.
+static std::vector<TupleSpace::tuple_t>
+sub_tuple_positions(int d)
+{
+  std::vector<TupleSpace::tuple_t> subs;
+  for (int k = 1; k <= d; k++) {
+    std::vector<bool> mask(d, false);
+    std::fill(mask.begin(), mask.begin() + k, true);
+    do {
+      TupleSpace::tuple_t sub;
+      for (int ii = 0; ii < d; ii++) {
+        if (mask[ii]) {
+          sub.push_back(ii);
+        }
+      }
+      subs.push_back(sub);
+    } while (std::prev_permutation(mask.begin(), mask.end()));
+  }
+  return subs;
+}
+
+static void
+traverse_list_entropy(TupleSpace const& ts, std::vector<TupleSpace::index_t> const& list, TupleSpace::count_t start, TupleSpace::count_t stop, TupleSpaceTraverser& traverser, it::EntropyCalculator & ecalc)
+{
+  std::size_t d = ts.tupleSize();
+  TupleSpace::count_t n = list.size() / d;
+  auto subs = sub_tuple_positions(d);
+  it::Entropy entropy(subs.size());
+
+  // sub tuples on the stack
+  std::vector<TupleSpace::tuple_t> sub_tuples;
+  std::vector<unsigned> sub_max;
+  for (auto const& sub : subs) {
+    sub_tuples.push_back(TupleSpace::tuple_t(sub.size()));
+    sub_max.push_back(sub.back());
+  }
+
+  TupleSpace::tuple_t tuple(d);
+  std::size_t prefix = 0; // length of prefix shared with previous tuple
+  for (auto count = start; count < stop && count < n; count++) {
+    auto it = list.begin() + count * d;
+    for (prefix = 0; count > start && prefix < d; prefix++) {
+      if (tuple[prefix] != it[prefix]) {
+        break;
+      }
+    }
+    std::copy(it, it + d, tuple.begin());
+    // only recompute sub-tuples that differ from the previous tuple, leading
+    // pair first so it can be screened
+    std::size_t last = subs.size() - 1;
+    for (unsigned pass = 0; pass < 2; pass++) {
+      for (std::size_t ss = 0; ss < last; ss++) {
+        if ((count > start && sub_max[ss] < prefix) ||
+            (pass == 0) != (sub_max[ss] <= 1)) {
+          continue;
+        }
+        auto& sub_tuple = sub_tuples[ss];
+        for (std::size_t ii = 0; ii < sub_tuple.size(); ii++) {
+          sub_tuple[ii] = tuple[subs[ss][ii]];
+        }
+        entropy[ss] = ecalc.entropy(sub_tuple);
+      }
+      // prune the run of tuples starting with this pair
+      if (pass == 0 && d > 2 && (count == start || prefix < 2) &&
+          !traverser.process_prefix(
+            sub_tuples[d], entropy[0], entropy[1], entropy[d])) {
+        auto end = count + 1;
+        while (end < stop && end < n && list[end * d] == tuple[0] &&
+               list[end * d + 1] == tuple[1]) {
+          end++;
+        }
+        traverser.skip_tuples(count, end - count);
+        count = end - 1;
+        break;
+      }
+      if (pass == 1) {
+        // the full tuple is always new
+        if (d > 2 && !traverser.process_partial(count, tuple, entropy)) {
+          break;
+        }
+        entropy[last] = ecalc.entropy(tuple);
+        traverser.process_tuple_entropy(count, tuple, entropy);
+      }
+    }
+  }
+}
+
 static void
 traverse_d1(TupleSpace const& ts, TupleSpace::count_t start, TupleSpace::count_t stop, TupleSpaceTraverser& traverser)
 {
@@ -588,6 +1055,23 @@ traverse_d3_entropy(TupleSpace const& ts, TupleSpace::count_t start, TupleSpace:
         t012[1] = v1;
         entropy[(unsigned)it::d3::e1]  = ecalc.entropy(t1);
         entropy[(unsigned)it::d3::e01] = ecalc.entropy(t01);
+        // prune all tuples starting with this pair
+        if (!traverser.process_prefix(t01,
+                                      entropy[(unsigned)it::d3::e0],
+                                      entropy[(unsigned)it::d3::e1],
+                                      entropy[(unsigned)it::d3::e01])) {
+          unsigned i2start = (init) ? ffw[3] : starts[g2];
+          TupleSpace::count_t skip = (i2start < N[g2]) ? N[g2] - i2start : 0;
+          skip = std::min(skip, stop - count);
+          if (skip) {
+            traverser.skip_tuples(count, skip);
+            count += skip;
+            init = false;
+            work = count < stop;
+          }
+          starts[g2] = 0;
+          continue;
+        }
         for (unsigned i2 = (init) ? ffw[3] : starts[g2]; i2 < N[g2] && work; i2++) {
           starts[g2] = i2 + 1;
           auto v2 = groups[g2][i2];
@@ -598,6 +1082,12 @@ traverse_d3_entropy(TupleSpace const& ts, TupleSpace::count_t start, TupleSpace:
           entropy[(unsigned)it::d3::e2]   = ecalc.entropy(t2);
           entropy[(unsigned)it::d3::e02]  = ecalc.entropy(t02);
           entropy[(unsigned)it::d3::e12]  = ecalc.entropy(t12);
+          if (!traverser.process_partial(count, t012, entropy)) {
+            count++;
+            init = false;
+            work = count < stop;
+            continue;
+          }
           entropy[(unsigned)it::d3::e012] = ecalc.entropy(t012);
           traverser.process_tuple_entropy(count, t012, entropy);
           count++;
@@ -741,6 +1231,30 @@ traverse_d4_entropy(TupleSpace const& ts, TupleSpace::count_t start, TupleSpace:
         t0123[1] = v1;
         entropy[(unsigned)it::d4::e1]  = ecalc.entropy(t1);
         entropy[(unsigned)it::d4::e01] = ecalc.entropy(t01);
+        // prune all tuples starting with this pair
+        if (!traverser.process_prefix(t01,
+                                      entropy[(unsigned)it::d4::e0],
+                                      entropy[(unsigned)it::d4::e1],
+                                      entropy[(unsigned)it::d4::e01])) {
+          auto first = count;
+          for (unsigned i2 = (init) ? ffw[3] : starts[g2]; i2 < N[g2] && work; i2++) {
+            starts[g2] = i2 + 1;
+            unsigned i3start = (init) ? ffw[4] : starts[g3];
+            TupleSpace::count_t skip = (i3start < N[g3]) ? N[g3] - i3start : 0;
+            skip = std::min(skip, stop - count);
+            if (skip) {
+              count += skip;
+              init = false;
+              work = count < stop;
+            }
+            starts[g3] = 0;
+          }
+          if (count > first) {
+            traverser.skip_tuples(first, count - first);
+          }
+          starts[g2] = 0;
+          continue;
+        }
         for (unsigned i2 = (init) ? ffw[3] : starts[g2]; i2 < N[g2] && work; i2++) {
           starts[g2] = i2 + 1;
           auto v2 = groups[g2][i2];
@@ -774,6 +1288,12 @@ traverse_d4_entropy(TupleSpace const& ts, TupleSpace::count_t start, TupleSpace:
             entropy[(unsigned)it::d4::e013]  = ecalc.entropy(t013);
             entropy[(unsigned)it::d4::e023]  = ecalc.entropy(t023);
             entropy[(unsigned)it::d4::e123]  = ecalc.entropy(t123);
+            if (!traverser.process_partial(count, t0123, entropy)) {
+              count++;
+              init = false;
+              work = count < stop;
+              continue;
+            }
             entropy[(unsigned)it::d4::e0123] = ecalc.entropy(t0123);
             traverser.process_tuple_entropy(count, t0123, entropy);
             count++;
@@ -805,6 +1325,14 @@ TupleSpace::traverse_entropy(it::EntropyCalculator &ecalc, TupleSpaceTraverser&
 void
 TupleSpace::traverse(count_t start, count_t stop, TupleSpaceTraverser& traverser) const
 {
+  // the traversals visit at least one tuple
+  if (start >= stop) {
+    return;
+  }
+  if (!tupleList.empty()) {
+    traverse_list(*this, tupleList, start, stop, traverser);
+    return;
+  }
   switch(tuple_size) {
     case 1: traverse_d1(*this, start, stop, traverser); break;
     case 2: traverse_d2(*this, start, stop, traverser); break;
@@ -818,6 +1346,16 @@ TupleSpace::traverse(count_t start, count_t stop, TupleSpaceTraverser& traverser
 void
 TupleSpace::traverse_entropy(count_t start, count_t stop, it::EntropyCalculator &ecalc, TupleSpaceTraverser& traverser) const
 {
+  if (start >= stop) {
+    return;
+  }
+  if (!tupleList.empty()) {
+    if (tuple_size < 2 || tuple_size > 4) {
+      throw TupleSpaceException("traverse_entropy", "Tuple size must be in range [2,4].");
+    }
+    traverse_list_entropy(*this, tupleList, start, stop, traverser, ecalc);
+    return;
+  }
   switch(tuple_size) {
     case 1:
       throw TupleSpaceException("traverse_entropy", "Tuple size 1 unsupported.");
@@ -1,7 +1,11 @@
 #include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <set>
 #include <stdexcept>
 
 #include "algorithm/TupleSpace.hpp"
+#include "it/EntropyCalculator.hpp"
 
 using namespace mist;
 using namespace algorithm;
@@ -44,6 +48,29 @@ BOOST_AUTO_TEST_CASE(traverse_equal_count2)
   BOOST_TEST(ts.count_tuples() == 45);
 }
 
+class Collector : public Counter {
+public:
+  void process_tuple(TupleSpace::count_t tuple_no, TupleSpace::tuple_t const& tuple){ this->tuples.insert(tuple); };
+  std::set<TupleSpace::tuple_t> tuples;
+};
+
+BOOST_AUTO_TEST_CASE(delta_space)
+{
+  for (int d = 2; d <= 4; d++) {
+    Collector full, old, delta;
+    TupleSpace(9, d).traverse(full);
+    TupleSpace(6, d).traverse(old);
+    TupleSpace ts(6, 3, d);
+    ts.traverse(delta);
+    BOOST_TEST(ts.count_tuples() == delta.tuples.size());
+    BOOST_TEST(delta.tuples.size() + old.tuples.size() == full.tuples.size());
+    for (auto const& tuple : delta.tuples) {
+      BOOST_TEST(full.tuples.count(tuple) == 1);
+      BOOST_TEST(old.tuples.count(tuple) == 0);
+    }
+  }
+}
+
 // tests that we are in the regime of uint64, otherwise there would be overflow
 BOOST_AUTO_TEST_CASE(count_large)
 {
@@ -51,6 +78,123 @@ BOOST_AUTO_TEST_CASE(count_large)
   BOOST_TEST(ts.count_tuples() == 4999950000);
 }
 
+BOOST_AUTO_TEST_CASE(tuple_list_sorted_unique)
+{
+  TupleSpace ts;
+  ts.addTuples({ 4, 2, 0, 3, 2, 4, 0, 1 }, 2);
+  BOOST_TEST(ts.isTupleList());
+  BOOST_TEST(ts.count_tuples() == 3);
+  BOOST_TEST(ts.get_tuple(0) == TupleSpace::tuple_t({ 0, 1 }));
+  BOOST_TEST(ts.get_tuple(1) == TupleSpace::tuple_t({ 0, 3 }));
+  BOOST_TEST(ts.get_tuple(2) == TupleSpace::tuple_t({ 2, 4 }));
+  Counter cntr;
+  ts.traverse(1, 3, cntr);
+  BOOST_TEST(cntr.count == 2);
+}
+
+BOOST_AUTO_TEST_CASE(tuple_list_errors)
+{
+  TupleSpace ts;
+  ts.addTuple({ 0, 1, 2 });
+  BOOST_CHECK_THROW(ts.addTuple({ 0, 1 }), TupleSpaceException);
+  BOOST_CHECK_THROW(ts.addTuple({ 0, 1, 1 }), TupleSpaceException);
+  BOOST_CHECK_THROW(ts.addVariableGroup("A", { 0, 1 }), TupleSpaceException);
+  TupleSpace groups(5, 2);
+  BOOST_CHECK_THROW(groups.addTuple({ 0, 1 }), TupleSpaceException);
+}
+
+BOOST_AUTO_TEST_CASE(num_variables)
+{
+  BOOST_TEST(TupleSpace(30, 3).num_variables() == 30);
+  TupleSpace list;
+  list.addTuples({ 0, 1, 31 }, 3);
+  BOOST_TEST(list.num_variables() == 32);
+  TupleSpace groups;
+  groups.addVariableGroup("A", { 0, 1 });
+  groups.addVariableGroup("B", { 7 });
+  groups.addVariableGroup("unused", { 40 });
+  groups.addVariableGroupTuple({ 0, 1 });
+  BOOST_TEST(groups.num_variables() == 8);
+}
+
+static TupleSpace
+load_tuple_text(std::string const& text)
+{
+  auto path = (boost::filesystem::temp_directory_path() /
+               boost::filesystem::unique_path()).string();
+  std::ofstream(path) << text;
+  TupleSpace ts;
+  try {
+    ts.loadTupleFile(path);
+  } catch (...) {
+    boost::filesystem::remove(path);
+    throw;
+  }
+  boost::filesystem::remove(path);
+  return ts;
+}
+
+BOOST_AUTO_TEST_CASE(load_tuple_file_header)
+{
+  auto ts = load_tuple_text("v0,v1\n0,1\n\n2\t3\n");
+  BOOST_TEST(ts.count_tuples() == 2);
+  BOOST_TEST(ts.get_tuple(1) == TupleSpace::tuple_t({ 2, 3 }));
+  // header only on the first line, malformed lines are not skipped
+  BOOST_CHECK_THROW(load_tuple_text("0,1\nv0,v1\n"), TupleSpaceException);
+  BOOST_CHECK_THROW(load_tuple_text("0,1\n1;2\n"), TupleSpaceException);
+  BOOST_CHECK_THROW(load_tuple_text("-1,2\n0,1\n"), TupleSpaceException);
+  BOOST_CHECK_THROW(load_tuple_text("0,4294967296\n"), TupleSpaceException);
+}
+
+BOOST_AUTO_TEST_CASE(get_tuple_groups)
+{
+  TupleSpace ts(5, 3);
+  BOOST_TEST(ts.get_tuple(0) == TupleSpace::tuple_t({ 0, 1, 2 }));
+  BOOST_TEST(ts.get_tuple(9) == TupleSpace::tuple_t({ 2, 3, 4 }));
+}
+
+// Reject every tuple starting with variable 0
+class PrefixScreen : public Counter {
+public:
+  bool process_prefix(TupleSpace::tuple_t const& prefix, it::entropy_type e0, it::entropy_type e1, it::entropy_type e01) { return prefix[0] != 0; };
+  void skip_tuples(TupleSpace::count_t tuple_no, TupleSpace::count_t n) { this->skipped += n; };
+  TupleSpace::count_t skipped = 0;
+};
+
+static it::EntropyCalculator::variables_ptr
+make_variables(int nvar)
+{
+  int nrow = 8;
+  auto vars = it::EntropyCalculator::variables_ptr(new Variable::tuple);
+  for (int ii = 0; ii < nvar; ii++) {
+    Variable::data_ptr data(new Variable::data_t[nrow]);
+    for (int jj = 0; jj < nrow; jj++) {
+      data[jj] = (jj * (ii + 1)) % 2;
+    }
+    vars->push_back(Variable(data, nrow, ii, 2));
+  }
+  return vars;
+}
+
+BOOST_AUTO_TEST_CASE(traverse_entropy_prefix_screen)
+{
+  auto vars = make_variables(6);
+  TupleSpace full(6, 3);
+  TupleSpace list;
+  for (TupleSpace::count_t ii = 0; ii < full.count_tuples(); ii++) {
+    list.addTuple(full.get_tuple(ii));
+  }
+  for (auto ts : { &full, &list }) {
+    // split in two ranges to exercise fast-forward
+    PrefixScreen screen;
+    it::EntropyCalculator ecalc(vars);
+    ts->traverse_entropy(0, 7, ecalc, screen);
+    ts->traverse_entropy(7, 20, ecalc, screen);
+    BOOST_TEST(screen.count == 10);
+    BOOST_TEST(screen.skipped == 10);
+  }
+}
+
 //BOOST_AUTO_TEST_CASE(count_large1)
 //{
 //  TupleSpace ts(1e6, 3);
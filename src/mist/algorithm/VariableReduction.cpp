@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <unordered_map>
+
+#include "algorithm/VariableReduction.hpp"
+
+using namespace mist;
+using namespace mist::algorithm;
+
+// FNV-1a over the column values
+static std::uint64_t
+hash_column(Variable const& var)
+{
+  std::uint64_t h = 14695981039346656037ULL;
+  auto data = var.begin();
+  auto n = var.size();
+  for (std::size_t ii = 0; ii < n; ii++) {
+    h ^= static_cast<std::uint8_t>(data[ii]);
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+static bool
+is_constant_column(Variable const& var)
+{
+  auto data = var.begin();
+  auto n = var.size();
+  if (!n || VARIABLE_MISSING_VAL(data[0])) {
+    return false;
+  }
+  return std::all_of(data, data + n, [&](Variable::data_t v) { return v == data[0]; });
+}
+
+static bool
+equal_columns(Variable const& a, Variable const& b)
+{
+  return a.size() == b.size() && std::equal(a.begin(), a.begin() + a.size(), b.begin());
+}
+
+VariableReduction::VariableReduction(Variable::tuple const& vars,
+                                     std::size_t threads)
+{
+  auto nvar = vars.size();
+  std::vector<std::uint64_t> hashes(nvar);
+  std::vector<char> constants(nvar, 0);
+
+  // hash interleaved columns in each thread
+  threads = std::max<std::size_t>(1, std::min(threads, nvar));
+  auto hash_columns = [&](std::size_t first) {
+    for (auto ii = first; ii < nvar; ii += threads) {
+      hashes[ii] = hash_column(vars[ii]);
+      constants[ii] = is_constant_column(vars[ii]);
+    }
+  };
+  std::vector<std::thread> pool;
+  for (std::size_t tt = 1; tt < threads; tt++) {
+    pool.emplace_back(hash_columns, tt);
+  }
+  hash_columns(0);
+  for (auto& thread : pool) {
+    thread.join();
+  }
+
+  // classes of equal columns, chained by hash
+  is_constant.assign(constants.begin(), constants.end());
+  rep.resize(nvar);
+  classes.assign(nvar, tuple_t());
+  std::unordered_map<std::uint64_t, tuple_t> reps_by_hash;
+  for (std::size_t ii = 0; ii < nvar; ii++) {
+    rep[ii] = ii;
+    auto& candidates = reps_by_hash[hashes[ii]];
+    for (auto r : candidates) {
+      if (equal_columns(vars[r], vars[ii])) {
+        rep[ii] = r;
+        break;
+      }
+    }
+    if (rep[ii] == ii) {
+      candidates.push_back(ii);
+    } else {
+      nduplicates++;
+    }
+    classes[rep[ii]].push_back(ii);
+  }
+  for (std::size_t ii = 0; ii < nvar; ii++) {
+    if (is_constant[ii]) {
+      nconstant++;
+    } else if (rep[ii] == ii) {
+      _kept.push_back(ii);
+    }
+  }
+}
+
+VariableReduction::tuple_space_ptr
+VariableReduction::tuple_space(int d) const
+{
+  auto ts = tuple_space_ptr(new TupleSpace());
+  int group = ts->addVariableGroup("kept", _kept);
+  ts->addVariableGroupTuple(tuple_t(d, group));
+  return ts;
+}
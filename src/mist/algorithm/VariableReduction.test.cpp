@@ -0,0 +1,87 @@
+#include <boost/test/unit_test.hpp>
+#include <random>
+#include <set>
+
+#include "algorithm/VariableReduction.hpp"
+#include "io/DataMatrix.hpp"
+
+using namespace mist;
+using namespace algorithm;
+
+// 1 copies 0, 2 is constant, 4 copies 3, 6 copies the constant 2, 7 is
+// constant but for a missing value, the others are random
+static io::DataMatrix
+make_data(int nrow)
+{
+  int nvar = 8;
+  std::mt19937 gen(3);
+  std::vector<io::DataMatrix::data_t> data(nvar * nrow);
+  for (auto& x : data) {
+    x = gen() % 3;
+  }
+  auto col = [&](int ii) { return data.begin() + ii * nrow; };
+  std::copy(col(0), col(1), col(1));
+  std::fill(col(2), col(3), 1);
+  std::copy(col(3), col(4), col(4));
+  std::copy(col(2), col(3), col(6));
+  std::fill(col(7), col(8), 2);
+  *col(7) = -1;
+  return io::DataMatrix(data.data(), nvar, nrow);
+}
+
+BOOST_AUTO_TEST_CASE(classes)
+{
+  auto dm = make_data(50);
+  VariableReduction reduction(*dm.variables());
+  BOOST_TEST(reduction.kept() == VariableReduction::tuple_t({ 0, 3, 5, 7 }));
+  BOOST_TEST(reduction.num_constant() == 2);
+  BOOST_TEST(reduction.num_duplicates() == 3);
+  BOOST_TEST(reduction.constant(2));
+  BOOST_TEST(reduction.constant(6));
+  BOOST_TEST(!reduction.constant(7));
+  BOOST_TEST(reduction.representative(1) == 0);
+  BOOST_TEST(reduction.representative(4) == 3);
+  BOOST_TEST(reduction.representative(6) == 2);
+  BOOST_TEST(reduction.representative(5) == 5);
+  BOOST_TEST(reduction.members(0) == VariableReduction::tuple_t({ 0, 1 }));
+}
+
+BOOST_AUTO_TEST_CASE(threads_agree)
+{
+  auto dm = make_data(50);
+  VariableReduction serial(*dm.variables(), 1);
+  VariableReduction parallel(*dm.variables(), 3);
+  BOOST_TEST(serial.kept() == parallel.kept());
+  for (std::size_t ii = 0; ii < 8; ii++) {
+    BOOST_TEST(serial.representative(ii) == parallel.representative(ii));
+    BOOST_TEST(serial.constant(ii) == parallel.constant(ii));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(tuple_space)
+{
+  auto dm = make_data(50);
+  VariableReduction reduction(*dm.variables());
+  BOOST_TEST(reduction.tuple_space(2)->count_tuples() == 6);
+  BOOST_TEST(reduction.tuple_space(3)->count_tuples() == 4);
+}
+
+BOOST_AUTO_TEST_CASE(copies)
+{
+  auto dm = make_data(50);
+  VariableReduction reduction(*dm.variables());
+  std::set<VariableReduction::tuple_t> seen;
+  VariableReduction::tuple_t copy;
+  reduction.for_each_copy({ 0, 3, 5 }, copy, [&](VariableReduction::tuple_t const& c) {
+    seen.insert(c);
+  });
+  std::set<VariableReduction::tuple_t> expected = { { 1, 3, 5 },
+                                                    { 0, 4, 5 },
+                                                    { 1, 4, 5 } };
+  BOOST_TEST((seen == expected));
+  seen.clear();
+  reduction.for_each_copy({ 5, 7 }, copy, [&](VariableReduction::tuple_t const& c) {
+    seen.insert(c);
+  });
+  BOOST_TEST(seen.empty());
+}
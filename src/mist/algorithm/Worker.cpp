@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <functional>
 
@@ -12,47 +13,136 @@ using namespace mist::algorithm;
 void
 Worker::process_tuple(count_t tuple_no, tuple_t const& tuple)
 {
+  if (checkpoint && checkpoint->requested()) {
+    checkpoint->pause(checkpoint_index, tuple_no, out_streams);
+  }
   this->measure->compute(*this->calc, tuple, this->result);
   ++(*this->tuples);
   if (result.back() < cutoff) {
     return;
   }
-  for (auto& out : out_streams) {
-    if (this->output_all) {
-      out->push(tuple_no, tuple, result);
-    } else {
-      out->push(tuple_no, tuple, result.back());
-    }
-  }
+  output(tuple_no, tuple, nullptr);
 }
 
 void
 Worker::process_tuple_entropy(count_t tuple_no, tuple_t const& tuple, it::Entropy const& e)
 {
+  if (checkpoint && checkpoint->requested()) {
+    checkpoint->pause(checkpoint_index, tuple_no, out_streams);
+  }
   this->measure->compute(*this->calc, tuple, e, this->result);
   ++(*this->tuples);
   if (result.back() < cutoff) {
     return;
   }
-  for (auto& out : out_streams) {
+  output(tuple_no, tuple, &e);
+}
+
+void
+Worker::output(count_t tuple_no, tuple_t const& tuple, it::Entropy const* e)
+{
+  bool use_values = permutation || (nvalues > 1 && !this->output_all);
+  if (use_values) {
     if (this->output_all) {
+      values = result;
+    } else {
+      values.assign(result.end() - nvalues, result.end());
+    }
+    // permutation tests append the exceedance count
+    if (permutation) {
+      values.push_back(permutation->exceedances(*measure, *permutation_calc,
+                                                tuple, e, result.back(),
+                                                permutation_workspace));
+    }
+  }
+  push(tuple_no, tuple, use_values);
+  if (reduction) {
+    reduction->for_each_copy(tuple, copy, [&](tuple_t const& c) {
+      if (this->output_all) {
+        push(tuple_no, c, use_values);
+        return;
+      }
+      sorted_copy = c;
+      std::sort(sorted_copy.begin(), sorted_copy.end());
+      push(tuple_no, sorted_copy, use_values);
+    });
+  }
+}
+
+void
+Worker::push(count_t tuple_no, tuple_t const& tuple, bool use_values)
+{
+  for (auto& out : out_streams) {
+    if (use_values) {
+      out->push(tuple_no, tuple, values);
+    } else if (this->output_all) {
       out->push(tuple_no, tuple, result);
     } else {
       out->push(tuple_no, tuple, result.back());
     }
+    // bounded streams raise the cutoff as they fill
+    auto min = out->min_value();
+    if (min > cutoff) {
+      cutoff = min;
+    }
   }
 }
 
+bool
+Worker::process_prefix(tuple_t const& prefix,
+                       it::entropy_type e0,
+                       it::entropy_type e1,
+                       it::entropy_type e01)
+{
+  return !screen || screen->pass(e0, e1, e01);
+}
+
 void
-Worker::start()
+Worker::skip_tuples(count_t tuple_no, count_t n)
+{
+  // pruned tuples count as seen for progress reporting
+  (*this->tuples) += n;
+}
+
+bool
+Worker::process_partial(count_t tuple_no, tuple_t const& tuple, it::Entropy const& e)
+{
+  if (!use_bounds || measure->upper_bound(e, tuple.size()) >= cutoff) {
+    return true;
+  }
+  ++(*this->tuples);
+  return false;
+}
+
+void
+Worker::search(count_t begin, count_t end)
 {
   bool full = measure->full_entropy();
 
   if (full) {
-    ts->traverse_entropy(start_no, stop_no, *calc.get(), *this);
+    ts->traverse_entropy(begin, end, *calc.get(), *this);
   }
   else {
-    ts->traverse(start_no, stop_no, *this);
+    ts->traverse(begin, end, *this);
+  }
+}
+
+void
+Worker::start()
+{
+  if (ordered) {
+    count_t block, begin, end;
+    while (ordered->next_block(block, begin, end)) {
+      search(begin, end);
+      for (auto& out : out_streams) {
+        out->end_block(block);
+      }
+    }
+  } else {
+    search(start_no, stop_no);
+  }
+  if (checkpoint) {
+    checkpoint->finish(checkpoint_index, stop_no, out_streams);
   }
 }
 
@@ -89,8 +179,19 @@ Worker::Worker(Worker const& other)
   , calc(new it::EntropyCalculator(*other.calc))
   , out_streams(other.out_streams)
   , measure(other.measure)
+  , nvalues(other.nvalues)
   , tuples(new atomic_count_t)
 {
+  screen = other.screen;
+  use_bounds = other.use_bounds;
+  checkpoint = other.checkpoint;
+  checkpoint_index = other.checkpoint_index;
+  permutation = other.permutation;
+  reduction = other.reduction;
+  ordered = other.ordered;
+  if (other.permutation_calc) {
+    permutation_calc.reset(new it::EntropyCalculator(*other.permutation_calc));
+  }
   tuples->store(0);
 }
 
@@ -104,6 +205,17 @@ Worker::operator=(Worker const& other)
   calc = entropy_calc_ptr(new it::EntropyCalculator(*other.calc));
   out_streams = other.out_streams;
   measure = other.measure;
+  nvalues = other.nvalues;
+  screen = other.screen;
+  use_bounds = other.use_bounds;
+  checkpoint = other.checkpoint;
+  checkpoint_index = other.checkpoint_index;
+  permutation = other.permutation;
+  reduction = other.reduction;
+  ordered = other.ordered;
+  permutation_calc.reset((other.permutation_calc)
+                           ? new it::EntropyCalculator(*other.permutation_calc)
+                           : nullptr);
   tuples = std::unique_ptr<atomic_count_t>(new atomic_count_t);
   tuples->store(other.tuples->load());
   return *this;
@@ -123,13 +235,15 @@ Worker::Worker(tuple_space_ptr const& ts,
   , calc(std::move(calc))
   , out_streams(out_streams)
   , measure(measure)
+  , nvalues(measure->num_values())
   , tuples(new atomic_count_t)
 {
   // cannot set these in member initialization list?
-  if (ts->getVariableGroups().empty()) {
+  if (ts->isTupleList()) {
+    // explicit tuple list, no variable groups to check
+  } else if (ts->getVariableGroups().empty()) {
     throw WorkerException("Worker", "TuplesSpace variable groups empty.");
-  }
-  if (ts->getVariableGroupTuples().empty()) {
+  } else if (ts->getVariableGroupTuples().empty()) {
     throw WorkerException("Worker", "TuplesSpace variable group tuples empty.");
   }
   for (auto& out : out_streams) {
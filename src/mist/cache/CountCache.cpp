@@ -0,0 +1,145 @@
+#include <algorithm>
+
+#include "cache/CountCache.hpp"
+
+using namespace mist;
+using namespace mist::cache;
+
+CountCache::CountCache(Variable::tuple const& vars,
+                       std::vector<Variable::index_t> const& packed,
+                       int d)
+  : d(d)
+{
+  // sort each key, then sort and deduplicate the keys
+  std::vector<key_type> sorted;
+  auto nkeys = packed.size() / d;
+  sorted.reserve(nkeys);
+  for (std::size_t ii = 0; ii < nkeys; ii++) {
+    key_type key(packed.begin() + ii * d, packed.begin() + (ii + 1) * d);
+    std::sort(key.begin(), key.end());
+    sorted.push_back(key);
+  }
+  std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+  keys.reserve(sorted.size() * d);
+  counts.reserve(sorted.size());
+  std::vector<std::size_t> bins(d);
+  for (auto const& key : sorted) {
+    keys.insert(keys.end(), key.begin(), key.end());
+    for (int ii = 0; ii < d; ii++) {
+      bins[ii] = vars[key[ii]].bins();
+    }
+    counts.emplace_back(bins);
+  }
+  entropies.assign(counts.size(), 0);
+}
+
+// Binary search over the packed, sorted keys
+std::size_t
+CountCache::find(key_type const& key) const
+{
+  if (key.size() != static_cast<std::size_t>(d)) {
+    return counts.size();
+  }
+  Variable::index_t sorted[4];
+  key_type sorted_key;
+  auto const* begin = key.data();
+  if (d <= 4) {
+    std::copy(key.begin(), key.end(), sorted);
+    std::sort(sorted, sorted + d);
+    begin = sorted;
+  } else {
+    sorted_key = key;
+    std::sort(sorted_key.begin(), sorted_key.end());
+    begin = sorted_key.data();
+  }
+  auto end = begin + d;
+  std::size_t lo = 0;
+  std::size_t hi = counts.size();
+  while (lo < hi) {
+    auto mid = lo + (hi - lo) / 2;
+    auto it = keys.begin() + mid * d;
+    if (std::lexicographical_compare(it, it + d, begin, end)) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo < counts.size() && std::equal(begin, end, keys.begin() + lo * d)) {
+    return lo;
+  }
+  return counts.size();
+}
+
+bool
+CountCache::has(key_type const& key)
+{
+  return find(key) < counts.size();
+}
+
+void
+CountCache::put(key_type const& key, val_type const& val)
+{}
+
+CountCache::val_type
+CountCache::get(key_type const& key)
+{
+  auto ii = find(key);
+  if (ii < counts.size()) {
+    this->_hits++;
+    return entropies[ii];
+  } else {
+    this->_misses++;
+    throw CountCacheOutOfRange("get", this->key_to_string(key));
+  }
+}
+
+std::size_t
+CountCache::size()
+{
+  return counts.size();
+}
+
+std::size_t
+CountCache::bytes()
+{
+  std::size_t bytes = keys.size() * sizeof(Variable::index_t) +
+                      entropies.size() * sizeof(val_type);
+  for (auto const& count : counts) {
+    bytes += count.size() * sizeof(it::CountTable::count_t);
+  }
+  return bytes;
+}
+
+std::size_t
+CountCache::tables() const
+{
+  return counts.size();
+}
+
+void
+CountCache::update(Variable::tuple const& added,
+                   Variable::tuple const& removed,
+                   std::size_t begin,
+                   std::size_t end)
+{
+  key_type key(d);
+  end = std::min(end, counts.size());
+  for (std::size_t ii = begin; ii < end; ii++) {
+    std::copy(keys.begin() + ii * d, keys.begin() + (ii + 1) * d, key.begin());
+    if (!removed.empty()) {
+      counts[ii].remove(removed, key);
+    }
+    if (!added.empty()) {
+      counts[ii].add(added, key);
+    }
+    entropies[ii] = counts[ii].entropy();
+  }
+}
+
+void
+CountCache::update(Variable::tuple const& added, Variable::tuple const& removed)
+{
+  update(added, removed, 0, counts.size());
+}
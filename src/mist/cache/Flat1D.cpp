@@ -39,6 +39,14 @@ Flat1D::get(key_type const& key)
   }
 }
 
+void
+Flat1D::grow(std::size_t nvar)
+{
+  if (nvar > this->data.size()) {
+    this->data.resize(nvar, DOUBLE_UNSET);
+  }
+}
+
 std::size_t
 Flat1D::size()
 {
@@ -1,3 +1,4 @@
+#include <utility>
 
 #include "binomial.hpp"
 #include "cache/Flat2D.hpp"
@@ -5,10 +6,16 @@
 using namespace mist;
 using namespace mist::cache;
 
+// Pairs i < j are ordered by j so the entries of the first n variables do
+// not depend on the total number of variables, and the cache can grow.
+// Joint entropy is symmetric, so unsorted tuples share the entry.
 static inline std::size_t
-index(std::size_t n, std::size_t i, std::size_t j)
+index(std::size_t i, std::size_t j)
 {
-  return ((n*(n-1))/2) - ((n-i)*((n-i)-1))/2 + j - i - 1;
+  if (i > j) {
+    std::swap(i, j);
+  }
+  return (j * (j - 1)) / 2 + i;
 }
 
 Flat2D::Flat2D()
@@ -25,19 +32,19 @@ Flat2D::Flat2D(std::size_t nvar)
 bool
 Flat2D::has(key_type const& key)
 {
-  return (data[index(nvar, key[0], key[1])] != DOUBLE_UNSET);
+  return (data[index(key[0], key[1])] != DOUBLE_UNSET);
 }
 
 void
 Flat2D::put(key_type const& key, val_type const& val)
 {
-  this->data[index(nvar, key[0], key[1])] = val;
+  this->data[index(key[0], key[1])] = val;
 }
 
 Flat2D::val_type
 Flat2D::get(key_type const& key)
 {
-  auto ii = index(nvar, key[0], key[1]);
+  auto ii = index(key[0], key[1]);
   if (this->data[ii] != DOUBLE_UNSET) {
     this->_hits++;
     return this->data[ii];
@@ -47,6 +54,15 @@ Flat2D::get(key_type const& key)
   }
 }
 
+void
+Flat2D::grow(std::size_t nvar)
+{
+  if (nvar > this->nvar) {
+    this->nvar = nvar;
+    this->data.resize(binomial(nvar, 2), DOUBLE_UNSET);
+  }
+}
+
 std::size_t
 Flat2D::size()
 {
@@ -0,0 +1,155 @@
+#include <algorithm>
+
+#include "io/BatchOutputStream.hpp"
+
+using namespace mist;
+using namespace mist::io;
+
+BatchQueue::BatchQueue(std::size_t max_batches)
+  : max_batches(std::max<std::size_t>(1, max_batches))
+{
+}
+
+void
+BatchQueue::push(batch_ptr const& batch)
+{
+  {
+    std::unique_lock<std::mutex> lock(m);
+    popped.wait(lock, [&] { return cancelled || batches.size() < max_batches; });
+    if (cancelled) {
+      return;
+    }
+    batches.push_back(batch);
+  }
+  pushed.notify_one();
+}
+
+bool
+BatchQueue::pop(batch_ptr& batch)
+{
+  {
+    std::unique_lock<std::mutex> lock(m);
+    pushed.wait(lock, [&] { return closed || !batches.empty(); });
+    if (batches.empty()) {
+      if (error) {
+        auto e = error;
+        error = nullptr;
+        std::rethrow_exception(e);
+      }
+      return false;
+    }
+    batch = batches.front();
+    batches.pop_front();
+  }
+  popped.notify_one();
+  return true;
+}
+
+void
+BatchQueue::close()
+{
+  {
+    std::unique_lock<std::mutex> lock(m);
+    closed = true;
+  }
+  pushed.notify_all();
+}
+
+void
+BatchQueue::fail(std::exception_ptr e)
+{
+  std::unique_lock<std::mutex> lock(m);
+  error = e;
+}
+
+void
+BatchQueue::cancel()
+{
+  {
+    std::unique_lock<std::mutex> lock(m);
+    cancelled = true;
+    batches.clear();
+  }
+  popped.notify_all();
+}
+
+#if BOOST_PYTHON_EXTENSIONS
+np::ndarray
+BatchQueue::py_next()
+{
+  batch_ptr batch;
+  bool more = false;
+  std::exception_ptr e;
+  PyThreadState* state = PyEval_SaveThread();
+  try {
+    more = pop(batch);
+  } catch (...) {
+    e = std::current_exception();
+  }
+  PyEval_RestoreThread(state);
+  if (e) {
+    std::rethrow_exception(e);
+  }
+  if (!more) {
+    PyErr_SetNone(PyExc_StopIteration);
+    p::throw_error_already_set();
+  }
+  return np::from_data(batch->data(),
+                       np::dtype::get_builtin<data_t>(),
+                       p::make_tuple(batch->size() / rowsize, rowsize),
+                       p::make_tuple(sizeof(data_t) * rowsize, sizeof(data_t)),
+                       py_owner(batch));
+}
+#endif
+
+BatchOutputStream::BatchOutputStream(std::shared_ptr<BatchQueue> const& queue,
+                                     std::size_t rowsize,
+                                     std::size_t batch_rows)
+  : OutputStream(mutex_ptr(new mutex_type))
+  , queue(queue)
+  , rowsize(rowsize)
+  , batch_rows(std::max<std::size_t>(1, batch_rows))
+{
+  if (!queue) {
+    throw BatchOutputStreamException("BatchOutputStream", "Invalid queue");
+  }
+}
+
+void
+BatchOutputStream::write_row(tuple_type const& tuple, data_t const* values, std::size_t n)
+{
+  if (tuple.size() + n != rowsize) {
+    throw BatchOutputStreamException("push", "Unexpected tuple and result length");
+  }
+  if (!batch) {
+    batch = std::make_shared<BatchQueue::batch_type>();
+    batch->reserve(batch_rows * rowsize);
+  }
+  batch->insert(batch->end(), tuple.begin(), tuple.end());
+  batch->insert(batch->end(), values, values + n);
+  if (batch->size() == batch_rows * rowsize) {
+    queue->push(batch);
+    batch = nullptr;
+  }
+}
+
+void
+BatchOutputStream::push(std::size_t tuple_no, tuple_type const& tuple, result_type const& result)
+{
+  write_row(tuple, result.data(), result.size());
+}
+
+void
+BatchOutputStream::push(std::size_t tuple_no, tuple_type const& tuple, it::entropy_type result)
+{
+  write_row(tuple, &result, 1);
+}
+
+void
+BatchOutputStream::flush()
+{
+  if (batch && !batch->empty()) {
+    queue->push(batch);
+  }
+  batch = nullptr;
+}
@@ -0,0 +1,59 @@
+
+#include <boost/test/unit_test.hpp>
+#include <stdexcept>
+#include <thread>
+
+#include "io/BatchOutputStream.hpp"
+
+using namespace mist;
+using namespace mist::io;
+
+BOOST_AUTO_TEST_CASE(BatchOutputStream_batches)
+{
+  auto queue = std::make_shared<BatchQueue>(1);
+  std::thread producer([&] {
+    BatchOutputStream out(queue, 3, 2);
+    for (Variable::index_t ii = 0; ii < 5; ii++) {
+      out.push(ii, { ii, ii + 1 }, 0.5 * ii);
+    }
+    out.flush();
+    queue->close();
+  });
+  std::vector<std::size_t> sizes;
+  std::vector<double> rows;
+  BatchQueue::batch_ptr batch;
+  while (queue->pop(batch)) {
+    sizes.push_back(batch->size() / 3);
+    rows.insert(rows.end(), batch->begin(), batch->end());
+  }
+  producer.join();
+  std::vector<std::size_t> expect_sizes = { 2, 2, 1 };
+  BOOST_TEST(sizes == expect_sizes, boost::test_tools::per_element());
+  BOOST_TEST(rows.size() == 15);
+  BOOST_TEST(rows[12] == 4);
+  BOOST_TEST(rows[14] == 2.0);
+}
+
+BOOST_AUTO_TEST_CASE(BatchOutputStream_fail_cancel)
+{
+  BatchQueue failed(1);
+  failed.push(std::make_shared<BatchQueue::batch_type>(3, 1.0));
+  failed.fail(std::make_exception_ptr(std::runtime_error("search failed")));
+  failed.close();
+  BatchQueue::batch_ptr batch;
+  // batches before the failure first
+  BOOST_TEST(failed.pop(batch));
+  BOOST_CHECK_THROW(failed.pop(batch), std::runtime_error);
+  BOOST_TEST(!failed.pop(batch));
+
+  // a cancelled queue never blocks the search
+  BatchQueue cancelled(1);
+  cancelled.cancel();
+  BatchOutputStream out(std::shared_ptr<BatchQueue>(&cancelled, [](BatchQueue*) {}), 2, 1);
+  for (Variable::index_t ii = 0; ii < 4; ii++) {
+    out.push(ii, { ii }, 1.0);
+  }
+  cancelled.close();
+  BOOST_TEST(!cancelled.pop(batch));
+  BOOST_CHECK_THROW(out.push(0, { 0, 1 }, 1.0), BatchOutputStreamException);
+}
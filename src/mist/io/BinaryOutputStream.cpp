@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+#include "io/BinaryOutputStream.hpp"
+
+using namespace mist;
+using namespace mist::io;
+
+const char BinaryOutputStream::magic[8] = { 'M', 'I', 'S', 'T', 'B', 'I', 'N', '1' };
+
+static std::vector<std::string>
+split_names(std::string const& header)
+{
+  std::vector<std::string> names;
+  std::size_t begin = 0;
+  while (begin <= header.size()) {
+    auto end = header.find(',', begin);
+    if (end == std::string::npos) {
+      end = header.size();
+    }
+    names.push_back(header.substr(begin, end - begin));
+    begin = end + 1;
+  }
+  return names;
+}
+
+static std::size_t
+count_values(std::string const& header, std::size_t tuple_size)
+{
+  auto ncol = split_names(header).size();
+  if (ncol <= tuple_size) {
+    throw BinaryOutputStreamException("BinaryOutputStream",
+                                      "Header '" + header + "' has no value columns");
+  }
+  return ncol - tuple_size;
+}
+
+// write buffer of each stream, at least one record, checked before the file
+// is opened
+static std::size_t
+buffer_size(std::string const& header, std::size_t tuple_size, std::size_t value_size)
+{
+  if (value_size != 4 && value_size != 8) {
+    throw BinaryOutputStreamException("BinaryOutputStream",
+                                      "Value size " + std::to_string(value_size) +
+                                        " not 4 or 8 bytes");
+  }
+  auto record = tuple_size * sizeof(BinaryOutputStream::index_type) +
+                count_values(header, tuple_size) * value_size;
+  return std::max<std::size_t>(BUFFER_MAX_SIZE_DEFAULT, record);
+}
+
+static void
+put_u32(std::string& s, std::uint32_t v)
+{
+  s.append(reinterpret_cast<char const*>(&v), sizeof(v));
+}
+
+BinaryOutputStream::BinaryOutputStream(std::string const& filename,
+                                       std::string const& header,
+                                       std::size_t tuple_size,
+                                       std::size_t value_size,
+                                       std::ios_base::openmode mode)
+  : FileOutputStream(filename,
+                     mode | std::ios_base::binary,
+                     buffer_size(header, tuple_size, value_size))
+  , tuple_size(tuple_size)
+  , nvalues(count_values(header, tuple_size))
+  , value_size(value_size)
+  , record_size(tuple_size * sizeof(index_type) + nvalues * value_size)
+{
+  this->header = header;
+  if (mode & std::ios_base::app) {
+    return;
+  }
+  std::string h(magic, sizeof(magic));
+  auto fixed = sizeof(magic) + 5 * sizeof(std::uint32_t);
+  auto size = (fixed + header.size() + 7) / 8 * 8;
+  put_u32(h, size);
+  put_u32(h, tuple_size);
+  put_u32(h, nvalues);
+  put_u32(h, value_size);
+  put_u32(h, header.size());
+  h += header;
+  h.resize(size, '\0');
+  direct_write(h);
+}
+
+BinaryOutputStream::BinaryOutputStream(BinaryOutputStream const& other)
+  : FileOutputStream(other)
+  , tuple_size(other.tuple_size)
+  , nvalues(other.nvalues)
+  , value_size(other.value_size)
+  , record_size(other.record_size)
+{
+}
+
+std::shared_ptr<FileOutputStream>
+BinaryOutputStream::clone() const
+{
+  return std::shared_ptr<FileOutputStream>(new BinaryOutputStream(*this));
+}
+
+template<class Value>
+void
+BinaryOutputStream::write_record(tuple_type const& tuple, data_t const* values)
+{
+  if (tuple.size() != tuple_size) {
+    throw BinaryOutputStreamException("push",
+                                      "Tuple size " + std::to_string(tuple.size()) +
+                                        ", expected " + std::to_string(tuple_size));
+  }
+  reserve(record_size);
+  auto out = buffer->data() + buffer_cur_size;
+  for (std::size_t ii = 0; ii < tuple_size; ii++) {
+    index_type index = tuple[ii];
+    std::memcpy(out, &index, sizeof(index));
+    out += sizeof(index);
+  }
+  for (std::size_t ii = 0; ii < nvalues; ii++) {
+    Value value = values[ii];
+    std::memcpy(out, &value, sizeof(value));
+    out += sizeof(value);
+  }
+  buffer_cur_size += record_size;
+}
+
+void
+BinaryOutputStream::push(std::size_t tuple_no,
+                         tuple_type const& tuple,
+                         result_type const& result)
+{
+  if (result.size() != nvalues) {
+    throw BinaryOutputStreamException("push",
+                                      "Result size " + std::to_string(result.size()) +
+                                        ", expected " + std::to_string(nvalues));
+  }
+  if (value_size == 4) {
+    write_record<float>(tuple, result.data());
+  } else {
+    write_record<double>(tuple, result.data());
+  }
+}
+
+void
+BinaryOutputStream::push(std::size_t tuple_no,
+                         tuple_type const& tuple,
+                         it::entropy_type result)
+{
+  if (nvalues != 1) {
+    throw BinaryOutputStreamException("push",
+                                      "Result size 1, expected " + std::to_string(nvalues));
+  }
+  if (value_size == 4) {
+    write_record<float>(tuple, &result);
+  } else {
+    write_record<double>(tuple, &result);
+  }
+}
+
+static std::uint32_t
+get_u32(std::ifstream& in)
+{
+  std::uint32_t v = 0;
+  in.read(reinterpret_cast<char*>(&v), sizeof(v));
+  return v;
+}
+
+template<class Value>
+static void
+read_values(std::ifstream& in, std::size_t n, std::vector<double>& values)
+{
+  Value v;
+  for (std::size_t ii = 0; ii < n; ii++) {
+    in.read(reinterpret_cast<char*>(&v), sizeof(v));
+    values.push_back(v);
+  }
+}
+
+BinaryOutputStream::contents
+BinaryOutputStream::read_file(std::string const& filename)
+{
+  std::ifstream in(filename, std::ios_base::binary);
+  if (!in.is_open()) {
+    throw BinaryOutputStreamException("read_file",
+                                      "Could not open file '" + filename +
+                                        "': " + std::strerror(errno));
+  }
+  char m[sizeof(magic)];
+  in.read(m, sizeof(m));
+  if (!in || !std::equal(m, m + sizeof(m), magic)) {
+    throw BinaryOutputStreamException("read_file",
+                                      "File '" + filename + "' is not a binary results file");
+  }
+  contents c;
+  std::size_t size = get_u32(in);
+  c.tuple_size = get_u32(in);
+  c.nvalues = get_u32(in);
+  c.value_size = get_u32(in);
+  std::string header(get_u32(in), '\0');
+  in.read(&header[0], header.size());
+  if (!in || (c.value_size != 4 && c.value_size != 8)) {
+    throw BinaryOutputStreamException("read_file",
+                                      "Bad header in file '" + filename + "'");
+  }
+  c.names = split_names(header);
+  in.seekg(size);
+  // records until the end of the file
+  index_type index;
+  while (in.read(reinterpret_cast<char*>(&index), sizeof(index))) {
+    c.tuples.push_back(index);
+    for (std::size_t ii = 1; ii < c.tuple_size; ii++) {
+      in.read(reinterpret_cast<char*>(&index), sizeof(index));
+      c.tuples.push_back(index);
+    }
+    if (c.value_size == 4) {
+      read_values<float>(in, c.nvalues, c.values);
+    } else {
+      read_values<double>(in, c.nvalues, c.values);
+    }
+    if (!in) {
+      throw BinaryOutputStreamException("read_file",
+                                        "Truncated record in file '" + filename + "'");
+    }
+  }
+  return c;
+}
@@ -0,0 +1,67 @@
+
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+
+#include "io/BinaryOutputStream.hpp"
+
+using namespace mist;
+using namespace mist::io;
+
+BOOST_AUTO_TEST_CASE(BinaryOutputStream_round_trip)
+{
+  auto path = (boost::filesystem::temp_directory_path() /
+               boost::filesystem::unique_path()).string();
+  {
+    BinaryOutputStream out(path, "v0,v1,H,I", 2);
+    out.push(0, { 0, 1 }, { 1.5, 0.25 });
+    out.flush();
+    // a Worker copy writes to the same file
+    auto copy = out.clone();
+    copy->push(1, { 2, 3 }, { -1.0, 1e-300 });
+  }
+  auto c = BinaryOutputStream::read_file(path);
+  BOOST_TEST((c.names == std::vector<std::string>{ "v0", "v1", "H", "I" }));
+  BOOST_TEST(c.tuple_size == 2);
+  BOOST_TEST(c.nvalues == 2);
+  BOOST_TEST(c.value_size == 8);
+  BOOST_TEST(c.size() == 2);
+  BOOST_TEST((c.tuples == std::vector<BinaryOutputStream::index_type>{ 0, 1, 2, 3 }));
+  BOOST_TEST((c.values == std::vector<double>{ 1.5, 0.25, -1.0, 1e-300 }));
+
+  // appending writes records only
+  {
+    BinaryOutputStream out(path, "v0,v1,H,I", 2, 8,
+                           std::ios_base::out | std::ios_base::app);
+    out.push(2, { 4, 5 }, { 2.0, 3.0 });
+  }
+  c = BinaryOutputStream::read_file(path);
+  BOOST_TEST(c.size() == 3);
+  BOOST_TEST(c.tuples.back() == 5);
+  boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(BinaryOutputStream_float32)
+{
+  auto path = (boost::filesystem::temp_directory_path() /
+               boost::filesystem::unique_path()).string();
+  {
+    BinaryOutputStream out(path, "v0,v1,v2,SymmetricDelta", 3, 4);
+    for (std::uint32_t ii = 0; ii < 10000; ii++) {
+      out.push(ii, { ii, ii + 1, ii + 2 }, 0.5 * ii);
+    }
+    BOOST_CHECK_THROW(out.push(0, { 0, 1, 2 }, { 1.0, 2.0 }),
+                      BinaryOutputStreamException);
+  }
+  // records are 3 indexes and a float, after the padded header
+  auto size = boost::filesystem::file_size(path);
+  BOOST_TEST((size - 10000 * 16) % 8 == 0);
+  auto c = BinaryOutputStream::read_file(path);
+  BOOST_TEST(c.value_size == 4);
+  BOOST_TEST(c.size() == 10000);
+  BOOST_TEST(c.tuples[3 * 9999 + 2] == 10001);
+  BOOST_TEST(c.values[9999] == 0.5f * 9999);
+  boost::filesystem::remove(path);
+
+  BOOST_CHECK_THROW(BinaryOutputStream(path, "v0,v1", 2), BinaryOutputStreamException);
+  BOOST_CHECK_THROW(BinaryOutputStream(path, "v0,v1,H", 2, 2), BinaryOutputStreamException);
+}
@@ -0,0 +1,198 @@
+#include <cstring>
+#include <new>
+
+#include "io/ColumnOutputStream.hpp"
+
+using namespace mist;
+using namespace mist::io;
+
+ColumnOutputStream::ColumnOutputStream(std::size_t tuple_size,
+                                       std::vector<std::size_t> const& value_sizes,
+                                       bool tuple_numbers,
+                                       std::size_t size,
+                                       std::size_t offset)
+  : OutputStream(mutex_ptr(new mutex_type))
+  , tuple_size(tuple_size)
+  , ntuple_columns((tuple_numbers) ? 1 : tuple_size)
+  , nvalues(value_sizes.size())
+  , tuple_numbers(tuple_numbers)
+  , rows(0)
+  , fixed_size(size)
+  , offset(offset)
+{
+  for (std::size_t ii = 0; ii < ntuple_columns; ii++) {
+    columns.push_back({ (tuple_numbers) ? sizeof(tuple_no_type) : sizeof(index_type),
+                        std::make_shared<std::vector<char>>() });
+  }
+  for (auto width : value_sizes) {
+    if (width != sizeof(float) && width != sizeof(double)) {
+      throw ColumnOutputStreamException("ColumnOutputStream",
+                                        "Value size " + std::to_string(width) +
+                                          " not 4 or 8 bytes");
+    }
+    columns.push_back({ width, std::make_shared<std::vector<char>>() });
+  }
+  try {
+    for (auto& c : columns) {
+      c.data->resize(fixed_size * c.width);
+    }
+  } catch (std::bad_alloc& e) {
+    throw ColumnOutputStreamException("ColumnOutputStream",
+                                      "Not enough memory to init columns");
+  }
+}
+
+// Row of the next result, appended unless sized
+std::size_t
+ColumnOutputStream::next_row(std::size_t tuple_no, std::size_t d, std::size_t n)
+{
+  if (d != tuple_size || n != nvalues) {
+    throw ColumnOutputStreamException("push", "Unexpected tuple and result length");
+  }
+  if (fixed_size) {
+    if (tuple_no < offset || tuple_no - offset >= fixed_size) {
+      throw ColumnOutputStreamException("push", "Tuple number out of range");
+    }
+    return tuple_no - offset;
+  }
+  try {
+    for (auto& c : columns) {
+      c.data->resize((rows + 1) * c.width);
+    }
+  } catch (std::bad_alloc& e) {
+    throw ColumnOutputStreamException("push", "Could not push result, out of memory");
+  }
+  return rows++;
+}
+
+void
+ColumnOutputStream::put_value(column& c, std::size_t row, double value)
+{
+  if (c.width == sizeof(float)) {
+    float f = value;
+    std::memcpy(c.data->data() + row * sizeof(f), &f, sizeof(f));
+  } else {
+    std::memcpy(c.data->data() + row * sizeof(value), &value, sizeof(value));
+  }
+}
+
+void
+ColumnOutputStream::write_row(std::size_t tuple_no,
+                              tuple_type const& tuple,
+                              data_t const* values,
+                              std::size_t n)
+{
+  auto row = next_row(tuple_no, tuple.size(), n);
+  if (tuple_numbers) {
+    tuple_no_type number = tuple_no;
+    std::memcpy(columns[0].data->data() + row * sizeof(number), &number, sizeof(number));
+  } else {
+    for (std::size_t ii = 0; ii < tuple_size; ii++) {
+      index_type index = tuple[ii];
+      std::memcpy(columns[ii].data->data() + row * sizeof(index), &index, sizeof(index));
+    }
+  }
+  for (std::size_t ii = 0; ii < n; ii++) {
+    put_value(columns[ntuple_columns + ii], row, values[ii]);
+  }
+}
+
+void
+ColumnOutputStream::push(std::size_t tuple_no,
+                         tuple_type const& tuple,
+                         result_type const& result)
+{
+  write_row(tuple_no, tuple, result.data(), result.size());
+}
+
+void
+ColumnOutputStream::push(std::size_t tuple_no,
+                         tuple_type const& tuple,
+                         it::entropy_type result)
+{
+  write_row(tuple_no, tuple, &result, 1);
+}
+
+void
+ColumnOutputStream::relocate(ColumnOutputStream& other)
+{
+  if (fixed_size) {
+    throw ColumnOutputStreamException("relocate", "Cannot append to sized columns");
+  }
+  if (other.columns.size() != columns.size() || other.tuple_size != tuple_size) {
+    throw ColumnOutputStreamException("relocate", "Columns do not match");
+  }
+  for (std::size_t ii = 0; ii < columns.size(); ii++) {
+    if (other.columns[ii].width != columns[ii].width) {
+      throw ColumnOutputStreamException("relocate", "Columns do not match");
+    }
+  }
+  for (std::size_t ii = 0; ii < columns.size(); ii++) {
+    auto& from = other.columns[ii].data;
+    try {
+      columns[ii].data->insert(columns[ii].data->end(), from->begin(), from->end());
+    } catch (std::bad_alloc& e) {
+      throw ColumnOutputStreamException("relocate", "Could not move data, out of memory");
+    }
+    from = std::make_shared<std::vector<char>>();
+  }
+  rows += other.size();
+  other.rows = 0;
+  other.fixed_size = 0;
+}
+
+std::size_t
+ColumnOutputStream::size() const
+{
+  return (fixed_size) ? fixed_size : rows;
+}
+
+ColumnOutputStream::index_type
+ColumnOutputStream::index(std::size_t row, std::size_t position) const
+{
+  index_type index;
+  std::memcpy(&index, columns[position].data->data() + row * sizeof(index), sizeof(index));
+  return index;
+}
+
+ColumnOutputStream::tuple_no_type
+ColumnOutputStream::tuple_no(std::size_t row) const
+{
+  tuple_no_type n;
+  std::memcpy(&n, columns[0].data->data() + row * sizeof(n), sizeof(n));
+  return n;
+}
+
+double
+ColumnOutputStream::value(std::size_t row, std::size_t value_column) const
+{
+  auto const& c = columns[ntuple_columns + value_column];
+  if (c.width == sizeof(float)) {
+    float f;
+    std::memcpy(&f, c.data->data() + row * sizeof(f), sizeof(f));
+    return f;
+  }
+  double v;
+  std::memcpy(&v, c.data->data() + row * sizeof(v), sizeof(v));
+  return v;
+}
+
+#if BOOST_PYTHON_EXTENSIONS
+np::ndarray
+ColumnOutputStream::py_get_column(std::size_t column)
+{
+  auto const& c = columns.at(column);
+  np::dtype dtype = np::dtype::get_builtin<double>();
+  if (column < ntuple_columns) {
+    dtype = (tuple_numbers) ? np::dtype::get_builtin<tuple_no_type>()
+                            : np::dtype::get_builtin<index_type>();
+  } else if (c.width == sizeof(float)) {
+    dtype = np::dtype::get_builtin<float>();
+  }
+  return np::from_data(c.data->data(),
+                       dtype,
+                       p::make_tuple(size()),
+                       p::make_tuple(c.width),
+                       py_owner(c.data));
+}
+#endif
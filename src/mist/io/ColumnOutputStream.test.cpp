@@ -0,0 +1,52 @@
+
+#include <boost/test/unit_test.hpp>
+
+#include "io/ColumnOutputStream.hpp"
+
+using namespace mist;
+using namespace mist::io;
+
+BOOST_AUTO_TEST_CASE(ColumnOutputStream_append)
+{
+  ColumnOutputStream a(2, { 4, 8 });
+  ColumnOutputStream b(2, { 4, 8 });
+  a.push(0, { 0, 1 }, { 0.1, 0.1 });
+  b.push(5, { 4, 70000 }, { 1.0 / 3, 1.0 / 3 });
+  a.relocate(b);
+  BOOST_TEST(a.size() == 2);
+  BOOST_TEST(b.size() == 0);
+  BOOST_TEST(a.num_columns() == 4);
+  BOOST_TEST(a.column_width(0) == 4);
+  BOOST_TEST(a.column_width(2) == 4);
+  BOOST_TEST(a.column_width(3) == 8);
+  BOOST_TEST(a.index(1, 0) == 4);
+  BOOST_TEST(a.index(1, 1) == 70000);
+  // float32 column rounds, float64 column exact
+  BOOST_TEST(a.value(1, 0) == (double)(float)(1.0 / 3));
+  BOOST_TEST(a.value(1, 1) == 1.0 / 3);
+  auto indexes = static_cast<ColumnOutputStream::index_type const*>(a.column_data(0));
+  BOOST_TEST(indexes[0] == 0);
+  BOOST_TEST(indexes[1] == 4);
+
+  BOOST_CHECK_THROW(a.push(0, { 0, 1, 2 }, { 0.1, 0.1 }), ColumnOutputStreamException);
+  BOOST_CHECK_THROW(a.push(0, { 0, 1 }, 0.1), ColumnOutputStreamException);
+  ColumnOutputStream c(2, { 8, 8 });
+  BOOST_CHECK_THROW(a.relocate(c), ColumnOutputStreamException);
+  BOOST_CHECK_THROW(ColumnOutputStream(2, { 2 }), ColumnOutputStreamException);
+}
+
+BOOST_AUTO_TEST_CASE(ColumnOutputStream_tuple_numbers)
+{
+  ColumnOutputStream out(3, { 8 }, true, 3, 100);
+  out.push(102, { 7, 8, 9 }, 2.5);
+  out.push(100, { 1, 2, 3 }, 0.5);
+  BOOST_TEST(out.size() == 3);
+  BOOST_TEST(out.has_tuple_numbers());
+  BOOST_TEST(out.num_columns() == 2);
+  BOOST_TEST(out.column_width(0) == 8);
+  BOOST_TEST(out.tuple_no(0) == 100);
+  BOOST_TEST(out.tuple_no(2) == 102);
+  BOOST_TEST(out.value(2, 0) == 2.5);
+  BOOST_CHECK_THROW(out.push(103, { 1, 2, 3 }, 0.5), ColumnOutputStreamException);
+  BOOST_CHECK_THROW(out.push(99, { 1, 2, 3 }, 0.5), ColumnOutputStreamException);
+}
@@ -1,6 +1,8 @@
+#include <algorithm>
 #include <cctype>
 #include <cerrno>
 #include <cstring>
+#include <unordered_map>
 
 #include "io/DataMatrix.hpp"
 
@@ -250,6 +252,270 @@ DataMatrix::variables()
   return this->_variables;
 }
 
+void
+DataMatrix::set_strata(index_t column)
+{
+  if (column >= nvar) {
+    throw DataMatrixException("set_strata",
+                              "Column " + std::to_string(column) +
+                                " out of range [0," + std::to_string(nvar) +
+                                ")");
+  }
+  if (nvar == 1) {
+    throw DataMatrixException("set_strata",
+                              "Cannot use the only variable as strata.");
+  }
+  strata_vector = vectors[column];
+  strata_bins = bins[column];
+  vectors.erase(vectors.begin() + column);
+  bins.erase(bins.begin() + column);
+  if (!bin_values.empty()) {
+    bin_values.erase(bin_values.begin() + column);
+  }
+  nvar--;
+  // the Variables tuple is sized for the old columns
+  _variables = nullptr;
+}
+
+void
+DataMatrix::drop_samples(std::size_t n)
+{
+  if (has_strata() || is_deduplicated()) {
+    throw DataMatrixException("drop_samples",
+                              "Samples cannot be dropped with strata or when deduplicated.");
+  }
+  if (n >= svar) {
+    throw DataMatrixException("drop_samples", "Cannot drop all samples.");
+  }
+  for (auto& v : vectors) {
+    v = Variable::data_ptr(v, v.get() + n);
+  }
+  row_offset += n;
+  svar -= n;
+  nrow -= n;
+  // the Variables tuple may be shared with a copy of this matrix
+  _variables = nullptr;
+}
+
+void
+DataMatrix::append_samples(DataMatrix const& other)
+{
+  if (has_strata() || is_deduplicated() || is_compacted()) {
+    throw DataMatrixException("append_samples",
+                              "Samples cannot be appended with strata, when deduplicated or compacted.");
+  }
+  if (other.nvar != nvar) {
+    throw DataMatrixException("append_samples",
+                              "Samples have " + std::to_string(other.nvar) +
+                                " variables, expected " + std::to_string(nvar));
+  }
+  auto nadd = other.svar;
+  auto end = row_offset + svar;
+  if (!rows_written || *rows_written != end || end + nadd > row_capacity) {
+    // copy to memory of our own with room to grow
+    auto capacity = 2 * (svar + nadd);
+    for (auto& v : vectors) {
+      auto grown = Variable::data_ptr(new data_t[capacity]);
+      std::copy(v.get(), v.get() + svar, grown.get());
+      v = grown;
+    }
+    row_offset = 0;
+    row_capacity = capacity;
+    rows_written = std::make_shared<std::size_t>(svar);
+    end = svar;
+  }
+  for (std::size_t ii = 0; ii < nvar; ii++) {
+    auto src = other.vectors[ii].get();
+    std::copy(src, src + nadd, vectors[ii].get() + svar);
+  }
+  *rows_written = end + nadd;
+  svar += nadd;
+  nrow += nadd;
+  _variables = nullptr;
+}
+
+bool
+DataMatrix::has_strata() const
+{
+  return static_cast<bool>(strata_vector);
+}
+
+Variable
+DataMatrix::get_strata() const
+{
+  if (!strata_vector) {
+    throw DataMatrixException("get_strata", "No strata column set.");
+  }
+  return mist::Variable(strata_vector, svar, 0, strata_bins);
+}
+
+std::size_t
+DataMatrix::deduplicate()
+{
+  // all columns of a sample, including strata
+  std::vector<data_t const*> cols;
+  for (auto const& v : vectors) {
+    cols.push_back(v.get());
+  }
+  if (strata_vector) {
+    cols.push_back(strata_vector.get());
+  }
+  // hash each sample a column at a time to stay cache friendly
+  std::vector<std::uint64_t> hashes(svar, 1469598103934665603ULL);
+  for (auto col : cols) {
+    for (std::size_t jj = 0; jj < svar; jj++) {
+      hashes[jj] = (hashes[jj] ^ static_cast<std::uint8_t>(col[jj])) * 1099511628211ULL;
+    }
+  }
+  auto same = [&cols](std::size_t a, std::size_t b) {
+    for (auto col : cols) {
+      if (col[a] != col[b]) {
+        return false;
+      }
+    }
+    return true;
+  };
+  // unique samples chained by hash, in order of first occurrence
+  std::vector<std::size_t> unique;
+  std::vector<std::size_t> next;
+  std::unordered_map<std::uint64_t, std::size_t> heads;
+  auto counts = std::make_shared<std::vector<multiplicity_t>>();
+  auto const& prior = _multiplicities;
+  const std::size_t none = -1;
+  for (std::size_t jj = 0; jj < svar; jj++) {
+    auto weight = (prior) ? (*prior)[jj] : 1;
+    auto found = heads.find(hashes[jj]);
+    std::size_t u = (found == heads.end()) ? none : found->second;
+    while (u != none && !same(unique[u], jj)) {
+      u = next[u];
+    }
+    if (u != none) {
+      (*counts)[u] += weight;
+      continue;
+    }
+    u = unique.size();
+    unique.push_back(jj);
+    counts->push_back(weight);
+    next.push_back((found == heads.end()) ? none : found->second);
+    heads[hashes[jj]] = u;
+  }
+
+  auto nunique = unique.size();
+  auto collapse = [&unique, nunique](Variable::data_ptr const& src) {
+    auto dst = Variable::data_ptr(new data_t[nunique]);
+    for (std::size_t u = 0; u < nunique; u++) {
+      dst.get()[u] = src.get()[unique[u]];
+    }
+    return dst;
+  };
+  for (auto& v : vectors) {
+    v = collapse(v);
+  }
+  if (strata_vector) {
+    strata_vector = collapse(strata_vector);
+  }
+  svar = nunique;
+  _multiplicities = counts;
+  // the Variables are sized for the old samples
+  _variables = nullptr;
+  return nunique;
+}
+
+bool
+DataMatrix::is_deduplicated() const
+{
+  return static_cast<bool>(_multiplicities);
+}
+
+DataMatrix::multiplicities_ptr
+DataMatrix::multiplicities() const
+{
+  return _multiplicities;
+}
+
+std::size_t
+DataMatrix::get_nsamples() const
+{
+  if (!_multiplicities) {
+    return svar;
+  }
+  std::size_t n = 0;
+  for (auto m : *_multiplicities) {
+    n += m;
+  }
+  return n;
+}
+
+std::size_t
+DataMatrix::compact_bins()
+{
+  if (bin_values.empty()) {
+    bin_values.resize(nvar);
+    for (std::size_t ii = 0; ii < nvar; ii++) {
+      for (int b = 0; b < bins[ii]; b++) {
+        bin_values[ii].push_back(b);
+      }
+    }
+  }
+  std::size_t remapped = 0;
+  for (std::size_t ii = 0; ii < nvar; ii++) {
+    auto src = vectors[ii].get();
+    std::vector<bool> seen(bins[ii], false);
+    for (std::size_t jj = 0; jj < svar; jj++) {
+      if (!VARIABLE_MISSING_VAL(src[jj])) {
+        seen[src[jj]] = true;
+      }
+    }
+    // new bin of each old bin, in value order
+    std::vector<data_t> remap(bins[ii], -1);
+    std::vector<data_t> values;
+    for (int b = 0; b < bins[ii]; b++) {
+      if (seen[b]) {
+        remap[b] = values.size();
+        values.push_back(bin_values[ii][b]);
+      }
+    }
+    if (values.size() == (std::size_t)bins[ii] || values.empty()) {
+      continue;
+    }
+    auto dst = Variable::data_ptr(new data_t[svar]);
+    for (std::size_t jj = 0; jj < svar; jj++) {
+      dst.get()[jj] = (VARIABLE_MISSING_VAL(src[jj])) ? src[jj] : remap[src[jj]];
+    }
+    vectors[ii] = dst;
+    bins[ii] = values.size();
+    bin_values[ii] = values;
+    remapped++;
+  }
+  _variables = nullptr;
+  return remapped;
+}
+
+bool
+DataMatrix::is_compacted() const
+{
+  return !bin_values.empty();
+}
+
+std::vector<DataMatrix::data_t>
+DataMatrix::get_bin_values(index_t column) const
+{
+  if (column >= nvar) {
+    throw DataMatrixException("get_bin_values",
+                              "Column " + std::to_string(column) +
+                                " out of range [0," + std::to_string(nvar) +
+                                ")");
+  }
+  if (!bin_values.empty()) {
+    return bin_values[column];
+  }
+  std::vector<data_t> values;
+  for (int b = 0; b < bins[column]; b++) {
+    values.push_back(b);
+  }
+  return values;
+}
+
 void
 DataMatrix::write_file(std::string const& filename, char sep)
 {
@@ -43,3 +43,112 @@ BOOST_AUTO_TEST_CASE(DataMatrix_constructor_array2)
   DataMatrix test_matrix4(test_data, 6, 2);
   DataMatrix test_matrix5(test_data, 12, 1);
 }
+
+BOOST_AUTO_TEST_CASE(DataMatrix_set_strata)
+{
+  DataMatrix::data_t test_data[12] = { 0, 1, 0, 1, 2, 2, 0, 1, 1, 0, 1, 0 };
+  DataMatrix test_matrix(test_data, 3, 4);
+  BOOST_TEST(!test_matrix.has_strata());
+  BOOST_CHECK_THROW(test_matrix.get_strata(), DataMatrixException);
+  BOOST_CHECK_THROW(test_matrix.set_strata(3), DataMatrixException);
+
+  test_matrix.set_strata(1);
+  BOOST_TEST(test_matrix.has_strata());
+  BOOST_TEST(test_matrix.get_nvar() == 2);
+  BOOST_TEST(test_matrix.variables()->size() == 2);
+
+  auto strata = test_matrix.get_strata();
+  BOOST_TEST(strata.bins() == 3);
+  BOOST_TEST(strata[0] == 2);
+  BOOST_TEST(strata[3] == 1);
+  // later variables move down
+  BOOST_TEST(test_matrix.get_variable(1)[0] == 1);
+  BOOST_TEST(test_matrix.get_variable(1)[1] == 0);
+}
+
+BOOST_AUTO_TEST_CASE(DataMatrix_deduplicate)
+{
+  // samples (0,1) (1,0) (0,1) (1,1) (1,0) (0,1)
+  DataMatrix::data_t test_data[12] = { 0, 1, 0, 1, 1, 0, 1, 0, 1, 1, 0, 1 };
+  DataMatrix test_matrix(test_data, 2, 6);
+  BOOST_TEST(!test_matrix.is_deduplicated());
+  BOOST_TEST(!test_matrix.multiplicities());
+
+  BOOST_TEST(test_matrix.deduplicate() == 3);
+  BOOST_TEST(test_matrix.is_deduplicated());
+  BOOST_TEST(test_matrix.get_svar() == 3);
+  BOOST_TEST(test_matrix.get_nsamples() == 6);
+  BOOST_TEST(test_matrix.variables()->front().size() == 3);
+  // unique samples in order of first occurrence
+  auto m = *test_matrix.multiplicities();
+  BOOST_TEST((m == std::vector<DataMatrix::multiplicity_t>{ 3, 2, 1 }));
+  auto v0 = test_matrix.get_variable(0);
+  auto v1 = test_matrix.get_variable(1);
+  BOOST_TEST(v0[0] == 0);
+  BOOST_TEST(v1[0] == 1);
+  BOOST_TEST(v0[2] == 1);
+  BOOST_TEST(v1[2] == 1);
+
+  // again keeps the multiplicities
+  BOOST_TEST(test_matrix.deduplicate() == 3);
+  BOOST_TEST(test_matrix.get_nsamples() == 6);
+}
+
+BOOST_AUTO_TEST_CASE(DataMatrix_compact_bins)
+{
+  // variable 0 has values {0,4,7} and a missing value, 1 is already dense
+  DataMatrix::data_t test_data[10] = { 7, 0, -1, 4, 7, 0, 1, 1, 0, 1 };
+  DataMatrix test_matrix(test_data, 2, 5);
+  BOOST_TEST(test_matrix.get_variable(0).bins() == 8);
+  auto shared = test_matrix.vectors[1];
+
+  BOOST_TEST(test_matrix.compact_bins() == 1);
+  BOOST_TEST(test_matrix.is_compacted());
+  auto v0 = test_matrix.get_variable(0);
+  BOOST_TEST(v0.bins() == 3);
+  BOOST_TEST(v0[0] == 2);
+  BOOST_TEST(v0[1] == 0);
+  BOOST_TEST(VARIABLE_MISSING_VAL(v0[2]));
+  BOOST_TEST(v0[3] == 1);
+  auto values = test_matrix.get_bin_values(0);
+  BOOST_TEST((values == std::vector<DataMatrix::data_t>{ 0, 4, 7 }));
+  // dense columns are not copied
+  BOOST_TEST(test_matrix.vectors[1] == shared);
+  BOOST_TEST(test_matrix.get_bin_values(1).size() == 2);
+  // the input is not modified
+  BOOST_TEST(test_data[0] == 7);
+
+  // again is a no-op
+  BOOST_TEST(test_matrix.compact_bins() == 0);
+  BOOST_TEST((test_matrix.get_bin_values(0) == values));
+}
+
+BOOST_AUTO_TEST_CASE(DataMatrix_append_drop_samples)
+{
+  DataMatrix::data_t rows[4] = { 0, 1, 1, 0 };
+  DataMatrix::data_t more[4] = { 2, 2, 3, 3 };
+  DataMatrix window(rows, 2, 2);
+  DataMatrix added(more, 2, 2);
+
+  window.append_samples(added);
+  window.drop_samples(1);
+  BOOST_TEST(window.get_svar() == 3);
+  DataMatrix::data_t expect[2][3] = { { 1, 2, 2 }, { 0, 3, 3 } };
+  for (int ii = 0; ii < 2; ii++) {
+    for (int jj = 0; jj < 3; jj++) {
+      BOOST_TEST(window.get_variable(ii)[jj] == expect[ii][jj]);
+    }
+  }
+
+  // copies share the rows, appending to one does not change the other
+  DataMatrix copy(window);
+  window.append_samples(added);
+  copy.append_samples(DataMatrix(rows, 2, 2));
+  BOOST_TEST(window.get_svar() == 5);
+  BOOST_TEST(copy.get_svar() == 5);
+  BOOST_TEST(window.get_variable(0)[3] == 2);
+  BOOST_TEST(copy.get_variable(0)[3] == 0);
+
+  BOOST_CHECK_THROW(window.drop_samples(5), DataMatrixException);
+  BOOST_CHECK_THROW(window.append_samples(DataMatrix(rows, 4, 1)), DataMatrixException);
+}
@@ -1,11 +1,17 @@
+#include <algorithm>
 #include "cerrno"
+#include "cstdlib"
 #include "cstring"
 #include "iostream"
 
 #include "io/FileOutputStream.hpp"
+#include "io/OrderedWriter.hpp"
 #include "it/Entropy.hpp"
 #include <exception>
 
+#include <fcntl.h>
+#include <unistd.h>
+
 using namespace mist;
 using namespace mist::io;
 
@@ -23,40 +29,89 @@ FileOutputStream::init()
       "init",
       std::string("Could not allocate write buffer: ") + std::strerror(errno));
   }
-  if (!double_strbuf.size()) {
-    throw FileOutputStreamException(
-      "init",
-      std::string("Could not allocate double-to-string buffer: ") +
-        std::strerror(errno));
+}
+
+// Make room for len more bytes in the buffer, writing it out when full
+void
+FileOutputStream::reserve(size_type len)
+{
+  if (buffer_cur_size + len <= buffer_max_size) {
+    return;
+  }
+  // a block is written whole by the OrderedWriter
+  if (ordered) {
+    buffer_max_size = std::max(2 * buffer_max_size, buffer_cur_size + len);
+    buffer->resize(buffer_max_size);
+    return;
+  }
+  if (buffer_cur_size) {
+    std::unique_lock<mutex_type> lock(*this->m.get());
+    file->write(buffer->data(), buffer_cur_size);
+    buffer_cur_size = 0;
+  }
+  if (len > buffer_max_size) {
+    buffer->resize(len);
+    buffer_max_size = len;
   }
 }
 
-// XXX: speed of string conversion has large performance impact
-// snprintf with pre-allocated buffer faster than sstream and
-// boost::lexical_cast
-inline std::string
-double_to_string_fast(FileOutputStream::buffer_type &buff, double v)
+// Digits of an index written straight into the buffer
+static inline char*
+write_index(char* out, Variable::index_t v)
 {
-  std::string ret; // declare return to encourage RVO
-  snprintf(buff.data(), DOUBLE_BUFFER_MAX_SIZE - 1, "%g", v);
-  buff.data()[DOUBLE_BUFFER_MAX_SIZE - 1] = '\0';
-  ret = buff.data();
-  return ret; // TODO Malloc thrashing here
+  char digits[10];
+  int n = 0;
+  do {
+    digits[n++] = '0' + v % 10;
+    v /= 10;
+  } while (v);
+  while (n) {
+    *out++ = digits[--n];
+  }
+  return out;
+}
+
+// Shortest of 15, 16 or 17 significant digits that reads back as the same
+// double
+static inline int
+format_round_trip(char* out, double v)
+{
+  int len = 0;
+  for (int p = 15; p <= 17; p++) {
+    len = snprintf(out, DOUBLE_BUFFER_MAX_SIZE, "%.*g", p, v);
+    if (std::strtod(out, nullptr) == v) {
+      break;
+    }
+  }
+  return len;
+}
+
+static inline char*
+write_value(char* out, double v, int precision)
+{
+  int len = (precision)
+              ? snprintf(out, DOUBLE_BUFFER_MAX_SIZE, "%.*g", precision, v)
+              : format_round_trip(out, v);
+  return out + len;
 }
 
 void
-FileOutputStream::buffered_write(std::string const& ss)
+FileOutputStream::write_row(tuple_type const& tuple, data_t const* values, size_type n)
 {
-  auto len = ss.length();
-  if (buffer_cur_size + len >= buffer_max_size) {
-    std::unique_lock<mutex_type> lock(*this->m.get());
-    file->write(buffer->data(), buffer_cur_size);
-    file->write(ss.data(), len);
-    buffer_cur_size = 0;
-  } else {
-    std::copy(ss.c_str(), ss.c_str() + len, buffer->data() + buffer_cur_size);
-    buffer_cur_size += len;
+  // each index is at most 10 digits, each value fits DOUBLE_BUFFER_MAX_SIZE
+  // including the terminator snprintf writes
+  reserve(tuple.size() * 11 + n * DOUBLE_BUFFER_MAX_SIZE + 1);
+  auto out = buffer->data() + buffer_cur_size;
+  for (auto t : tuple) {
+    out = write_index(out, t);
+    *out++ = ',';
+  }
+  for (size_type ii = 0; ii < n; ii++) {
+    out = write_value(out, values[ii], precision);
+    *out++ = ',';
   }
+  out[-1] = '\n';
+  buffer_cur_size = out - buffer->data();
 }
 
 void
@@ -71,7 +126,6 @@ FileOutputStream::FileOutputStream(std::string const& filename)
   : OutputStream(mutex_ptr(new mutex_type))
   , file(file_ptr(new file_type(filename)))
   , buffer(buffer_ptr(new buffer_type(BUFFER_MAX_SIZE_DEFAULT)))
-  , double_strbuf(DOUBLE_BUFFER_MAX_SIZE)
   , buffer_max_size(BUFFER_MAX_SIZE_DEFAULT)
   , buffer_cur_size(0)
   , filename(filename)
@@ -85,8 +139,7 @@ FileOutputStream::FileOutputStream(std::string const& filename,
   : OutputStream(mutex_ptr(new mutex_type))
   , file(file_ptr(new file_type(filename)))
   , buffer(buffer_ptr(new buffer_type(buffer_max_size)))
-  , double_strbuf(DOUBLE_BUFFER_MAX_SIZE)
-  , buffer_max_size(BUFFER_MAX_SIZE_DEFAULT)
+  , buffer_max_size(buffer_max_size)
   , buffer_cur_size(0)
   , filename(filename)
   , header("")
@@ -98,11 +151,11 @@ FileOutputStream::FileOutputStream(FileOutputStream const& other)
   : OutputStream(other.m)
   , file(other.file)
   , buffer(buffer_ptr(new buffer_type(other.buffer_max_size)))
-  , double_strbuf(other.double_strbuf.size())
   , buffer_max_size(other.buffer_max_size)
   , buffer_cur_size(0)
   , filename(other.filename)
   , header("")
+  , precision(other.precision)
 {
   init();
 }
@@ -112,7 +165,6 @@ FileOutputStream::FileOutputStream(std::string const& filename,
   : OutputStream(mutex_ptr(new mutex_type))
   , file(file_ptr(new file_type(filename)))
   , buffer(buffer_ptr(new buffer_type(BUFFER_MAX_SIZE_DEFAULT)))
-  , double_strbuf(DOUBLE_BUFFER_MAX_SIZE)
   , buffer_max_size(BUFFER_MAX_SIZE_DEFAULT)
   , buffer_cur_size(0)
   , filename(filename)
@@ -128,8 +180,7 @@ FileOutputStream::FileOutputStream(std::string const& filename,
   : OutputStream(mutex_ptr(new mutex_type))
   , file(file_ptr(new file_type(filename)))
   , buffer(buffer_ptr(new buffer_type(buffer_max_size)))
-  , double_strbuf(DOUBLE_BUFFER_MAX_SIZE)
-  , buffer_max_size(BUFFER_MAX_SIZE_DEFAULT)
+  , buffer_max_size(buffer_max_size)
   , buffer_cur_size(0)
   , filename(filename)
   , header(header)
@@ -138,6 +189,49 @@ FileOutputStream::FileOutputStream(std::string const& filename,
   direct_write(header + "\n");
 }
 
+FileOutputStream::FileOutputStream(std::string const& filename,
+                                   std::string const& header,
+                                   std::ios_base::openmode mode)
+  : OutputStream(mutex_ptr(new mutex_type))
+  , file(file_ptr(new file_type(filename, mode)))
+  , buffer(buffer_ptr(new buffer_type(BUFFER_MAX_SIZE_DEFAULT)))
+  , buffer_max_size(BUFFER_MAX_SIZE_DEFAULT)
+  , buffer_cur_size(0)
+  , filename(filename)
+  , header(header)
+{
+  init();
+  if (mode & std::ios_base::app) {
+    // position at the end so tell() is right before the first write
+    file->seekp(0, std::ios_base::end);
+  } else {
+    direct_write(header + "\n");
+  }
+}
+
+FileOutputStream::FileOutputStream(std::string const& filename,
+                                   std::ios_base::openmode mode,
+                                   size_type buffer_max_size)
+  : OutputStream(mutex_ptr(new mutex_type))
+  , file(file_ptr(new file_type(filename, mode)))
+  , buffer(buffer_ptr(new buffer_type(buffer_max_size)))
+  , buffer_max_size(buffer_max_size)
+  , buffer_cur_size(0)
+  , filename(filename)
+  , header("")
+{
+  init();
+  if (mode & std::ios_base::app) {
+    file->seekp(0, std::ios_base::end);
+  }
+}
+
+std::shared_ptr<FileOutputStream>
+FileOutputStream::clone() const
+{
+  return std::shared_ptr<FileOutputStream>(new FileOutputStream(*this));
+}
+
 FileOutputStream::~FileOutputStream()
 {
   if (buffer_cur_size) {
@@ -171,26 +265,99 @@ FileOutputStream::~FileOutputStream()
 void
 FileOutputStream::push(std::size_t tuple_no, tuple_type const& tuple, result_type const& result)
 {
-  std::string ss = "";
-  for (auto t : tuple) {
-    ss += std::to_string(t) + ",";
+  write_row(tuple, result.data(), result.size());
+}
+
+void
+FileOutputStream::push(std::size_t tuple_no, tuple_type const& tuple, it::entropy_type result)
+{
+  write_row(tuple, &result, 1);
+}
+
+void
+FileOutputStream::set_precision(int digits)
+{
+  if (digits < 0 || digits > 17) {
+    throw FileOutputStreamException("set_precision",
+                                    "Precision " + std::to_string(digits) +
+                                      " out of range [0,17]");
+  }
+  precision = digits;
+}
+
+int
+FileOutputStream::get_precision() const
+{
+  return precision;
+}
+
+void
+FileOutputStream::flush()
+{
+  std::unique_lock<mutex_type> lock(*this->m.get());
+  if (buffer_cur_size) {
+    file->write(buffer->data(), buffer_cur_size);
+    buffer_cur_size = 0;
   }
-  for (auto it = result.begin(); it < result.end() - 1; it++) {
-    ss += double_to_string_fast(double_strbuf, *it) + ",";
+  file->flush();
+  if (!*file) {
+    throw FileOutputStreamException("flush",
+                                    "Could not write to file '" + filename +
+                                      "': " + std::strerror(errno));
   }
-  ss += double_to_string_fast(double_strbuf, result.back()) + "\n";
-  this->buffered_write(ss);
 }
 
 void
-FileOutputStream::push(std::size_t tuple_no, tuple_type const& tuple, it::entropy_type result)
+FileOutputStream::sync()
 {
-  std::string ss = "";
-  for (auto t : tuple) {
-    ss += std::to_string(t) + ",";
+  flush();
+  // the stream has no descriptor of its own, any descriptor of the file
+  // syncs its data
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0 || ::fsync(fd)) {
+    auto err = std::string(std::strerror(errno));
+    if (fd >= 0) {
+      ::close(fd);
+    }
+    throw FileOutputStreamException("sync",
+                                    "Could not sync file '" + filename +
+                                      "': " + err);
+  }
+  ::close(fd);
+}
+
+void
+FileOutputStream::set_ordered(std::shared_ptr<OrderedWriter> const& writer)
+{
+  ordered = writer;
+}
+
+void
+FileOutputStream::end_block(std::size_t block)
+{
+  if (ordered) {
+    ordered->submit(block, *buffer, buffer_cur_size);
+    buffer_cur_size = 0;
   }
-  ss += double_to_string_fast(double_strbuf, result) + "\n";
-  this->buffered_write(ss);
+}
+
+void
+FileOutputStream::write_block(char const* data, size_type size)
+{
+  std::unique_lock<mutex_type> lock(*this->m.get());
+  file->write(data, size);
+  if (!*file) {
+    throw FileOutputStreamException("write_block",
+                                    "Could not write to file '" + filename +
+                                      "': " + std::strerror(errno));
+  }
+}
+
+FileOutputStream::size_type
+FileOutputStream::tell()
+{
+  std::unique_lock<mutex_type> lock(*this->m.get());
+  return file->tellp();
 }
 
 std::string
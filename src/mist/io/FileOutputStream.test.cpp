@@ -0,0 +1,82 @@
+
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <cstdlib>
+#include <fstream>
+
+#include "io/FileOutputStream.hpp"
+
+using namespace mist;
+using namespace mist::io;
+
+static std::vector<std::string>
+read_lines(std::string const& filename)
+{
+  std::ifstream in(filename);
+  std::vector<std::string> lines;
+  std::string line;
+  while (std::getline(in, line)) {
+    lines.push_back(line);
+  }
+  return lines;
+}
+
+BOOST_AUTO_TEST_CASE(FileOutputStream_rows)
+{
+  auto path = (boost::filesystem::temp_directory_path() /
+               boost::filesystem::unique_path()).string();
+  {
+    FileOutputStream out(path, "v0,v1,H");
+    out.push(0, { 0, 4294967295u }, 1.0 / 3);
+    out.push(1, { 10, 200 }, { -2.5e-10, 0.0, 1e300 });
+  }
+  auto lines = read_lines(path);
+  BOOST_TEST(lines.size() == 3);
+  BOOST_TEST(lines[0] == "v0,v1,H");
+  // same as printf %g
+  BOOST_TEST(lines[1] == "0,4294967295,0.333333");
+  BOOST_TEST(lines[2] == "10,200,-2.5e-10,0,1e+300");
+  boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(FileOutputStream_precision)
+{
+  auto path = (boost::filesystem::temp_directory_path() /
+               boost::filesystem::unique_path()).string();
+  std::vector<double> values = { 0.1, 1.0 / 3, 2.0 / 3, 1e-17, 12345.678 };
+  {
+    FileOutputStream out(path, "v0,v1");
+    out.set_precision(0);
+    for (auto v : values) {
+      out.push(0, { 1 }, v);
+    }
+    out.set_precision(3);
+    out.push(0, { 1 }, 12345.678);
+    BOOST_CHECK_THROW(out.set_precision(18), FileOutputStreamException);
+  }
+  auto lines = read_lines(path);
+  BOOST_TEST(lines[1] == "1,0.1");
+  for (std::size_t ii = 0; ii < values.size(); ii++) {
+    auto v = lines[ii + 1].substr(2);
+    BOOST_TEST(std::strtod(v.c_str(), nullptr) == values[ii]);
+  }
+  BOOST_TEST(lines.back() == "1,1.23e+04");
+  boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(FileOutputStream_wide_rows)
+{
+  // rows longer than the buffer grow it
+  auto path = (boost::filesystem::temp_directory_path() /
+               boost::filesystem::unique_path()).string();
+  std::vector<double> wide(5000, 0.5);
+  {
+    FileOutputStream out(path, "h", 16);
+    out.push(0, { 1, 2 }, wide);
+    out.push(1, { 3, 4 }, wide);
+  }
+  auto lines = read_lines(path);
+  BOOST_TEST(lines.size() == 3);
+  BOOST_TEST(lines[2].size() == 4 + 5000 * 4 - 1);
+  boost::filesystem::remove(path);
+}
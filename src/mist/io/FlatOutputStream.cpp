@@ -1,4 +1,12 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <new>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include "io/FlatOutputStream.hpp"
 #include "it/Entropy.hpp"
@@ -6,6 +14,9 @@
 using namespace mist;
 using namespace mist::io;
 
+const std::size_t FlatOutputStream::SEGMENT_ROWS_MIN;
+const std::size_t FlatOutputStream::SEGMENT_ROWS_MAX;
+
 FlatOutputStream::FlatOutputStream()
   : FlatOutputStream(0, 0, 0)
 {
@@ -28,12 +39,51 @@ FlatOutputStream::FlatOutputStream(std::size_t size, std::size_t rowsize, std::s
   , offset(offset)
 {
   try {
-    data = new std::vector<data_t>((size) * rowsize);
+    data.reset(new std::vector<data_t>((size) * rowsize));
   } catch (std::bad_alloc) {
     throw FlatOutputStreamException("FlatOutputStream", "Not enough memory to init array");
   }
 };
 
+FlatOutputStream::FlatOutputStream(std::string const& filename,
+                                   std::size_t size,
+                                   std::size_t rowsize,
+                                   std::size_t offset)
+  : OutputStream(mutex_ptr(new mutex_type))
+  , data(new std::vector<data_t>())
+  , size(size)
+  , rowsize(rowsize)
+  , offset(offset)
+  , mapped_file(filename)
+{
+  std::size_t bytes = size * rowsize * sizeof(data_t);
+  if (!bytes) {
+    throw FlatOutputStreamException("FlatOutputStream", "Mapped results need a size");
+  }
+  int fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    throw FlatOutputStreamException("FlatOutputStream",
+                                    "Could not open file '" + filename +
+                                      "': " + std::strerror(errno));
+  }
+  // sparse file, pages are allocated as rows are written
+  void* addr = MAP_FAILED;
+  if (::ftruncate(fd, bytes) == 0) {
+    addr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  int err = errno;
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    throw FlatOutputStreamException("FlatOutputStream",
+                                    "Could not map file '" + filename +
+                                      "': " + std::strerror(err));
+  }
+  mapped = static_cast<data_t*>(addr);
+  mapping = std::shared_ptr<data_t>(mapped, [bytes](data_t* rows) {
+    ::munmap(rows, bytes);
+  });
+}
+
 FlatOutputStream::~FlatOutputStream()
 {
 };
@@ -51,23 +101,14 @@ FlatOutputStream::push(std::size_t tuple_no, tuple_type const& tuple, result_typ
 
   // push into store
   if (!size) {
-    try {
-      data->insert(data->end(), tuple.begin(), tuple.end());
-      data->insert(data->end(), result.begin(), result.end());
-    } catch (std::bad_alloc &e) {
-      throw FlatOutputStreamException("push", "Could not push result, out of memory");
-    }
+    auto& segment = next_row();
+    segment.insert(segment.end(), tuple.begin(), tuple.end());
+    segment.insert(segment.end(), result.begin(), result.end());
   }
   else {
-    std::size_t index = (tuple_no-offset)*rowsize;
-    for (auto d : tuple) {
-      (*data)[index] = d;
-      index++;
-    }
-    for (auto d : result) {
-      (*data)[index] = d;
-      index++;
-    }
+    auto row = rows() + (tuple_no-offset)*rowsize;
+    row = std::copy(tuple.begin(), tuple.end(), row);
+    std::copy(result.begin(), result.end(), row);
   }
 }
 
@@ -84,51 +125,129 @@ FlatOutputStream::push(std::size_t tuple_no, tuple_type const& tuple, it::entrop
 
   // push into store
   if (!size) {
+    auto& segment = next_row();
+    segment.insert(segment.end(), tuple.begin(), tuple.end());
+    segment.push_back(result);
+  }
+  else {
+    auto row = rows() + (tuple_no-offset)*rowsize;
+    row = std::copy(tuple.begin(), tuple.end(), row);
+    *row = result;
+  }
+}
+
+// Segment with room for another row, the rows fit its capacity so it is
+// never reallocated
+FlatOutputStream::segment_type&
+FlatOutputStream::next_row()
+{
+  if (segments.empty() ||
+      segments.back()->size() + rowsize > segments.back()->capacity()) {
     try {
-      data->insert(data->end(), tuple.begin(), tuple.end());
-      data->push_back(result);
+      auto segment = std::make_shared<segment_type>();
+      segment->reserve(segment_rows * rowsize);
+      segments.push_back(std::move(segment));
     } catch (std::bad_alloc &e) {
       throw FlatOutputStreamException("push", "Could not push result, out of memory");
     }
+    segment_rows = std::min(2 * segment_rows, SEGMENT_ROWS_MAX);
   }
-  else {
-    std::size_t index = (tuple_no-offset)*rowsize;
-    for (auto d : tuple) {
-      (*data)[index] = d;
-      index++;
+  return *segments.back();
+}
+
+// Copy the segments to the end of the data array, threads segments at a time
+// so no more than those are held twice
+void
+FlatOutputStream::gather(std::size_t threads)
+{
+  if (segments.empty()) {
+    return;
+  }
+  // arrays over the rows keep their buffer, growing it would move it
+  if (data.use_count() > 1) {
+    data = std::make_shared<std::vector<data_t>>(*data);
+  }
+  std::size_t total = data->size();
+  for (auto const& segment : segments) {
+    total += segment->size();
+  }
+  try {
+    data->reserve(total);
+  } catch (std::bad_alloc &e) {
+    throw FlatOutputStreamException("get_results", "Could not gather results, out of memory");
+  }
+  threads = std::max<std::size_t>(1, threads);
+  std::vector<std::size_t> begin(threads);
+  for (std::size_t first = 0; first < segments.size(); first += threads) {
+    auto last = std::min(segments.size(), first + threads);
+    auto end = data->size();
+    for (auto ii = first; ii < last; ii++) {
+      begin[ii - first] = end;
+      end += segments[ii]->size();
+    }
+    data->resize(end);
+    auto copy = [&](std::size_t ii) {
+      std::copy(segments[ii]->begin(), segments[ii]->end(),
+                data->begin() + begin[ii - first]);
+      segments[ii].reset();
+    };
+    std::vector<std::thread> pool;
+    for (auto ii = first + 1; ii < last; ii++) {
+      pool.emplace_back(copy, ii);
+    }
+    copy(first);
+    for (auto& thread : pool) {
+      thread.join();
     }
-    (*data)[index] = result;
   }
+  segments.clear();
 }
 
 std::vector<FlatOutputStream::data_t> const&
-FlatOutputStream::get_results()
+FlatOutputStream::get_results(std::size_t threads)
 {
+  if (mapped) {
+    throw FlatOutputStreamException("get_results",
+                                    "Results are mapped from file '" +
+                                      mapped_file + "', see get_mapped_results");
+  }
+  gather(threads);
   return *data;
 }
 
+void
+FlatOutputStream::flush()
+{
+  if (mapped) {
+    ::msync(mapped, size * rowsize * sizeof(data_t), MS_ASYNC);
+  }
+}
+
 // move the data from other into this
 // other is empty after the operation
 void
 FlatOutputStream::relocate(FlatOutputStream &other)
 {
-  try {
-    data->insert(data->end(), other.data->begin(), other.data->end());
-    other.data->clear();
-  } catch (std::bad_alloc &e) {
-    throw FlatOutputStreamException("relocate", "Could not move data, not enough memory for temporary copy.");
+  if (!other.data->empty()) {
+    segments.push_back(other.data);
+    other.data = std::make_shared<std::vector<data_t>>();
+  }
+  for (auto& segment : other.segments) {
+    segments.push_back(std::move(segment));
   }
+  other.segments.clear();
 }
 
 #if BOOST_PYTHON_EXTENSIONS
 np::ndarray
-FlatOutputStream::py_get_results()
+FlatOutputStream::py_get_results(std::size_t threads)
 {
+  gather(threads);
   // TODO should this also include tuples, or keep them separate?
-	return np::from_data(data->data(),
+	return np::from_data(rows(),
                        np::dtype::get_builtin<data_t>(),
-                       p::make_tuple(data->size() / rowsize, rowsize),
+                       p::make_tuple((mapped) ? size : data->size() / rowsize, rowsize),
                        p::make_tuple(sizeof(data_t)*rowsize,sizeof(data_t)*1),
-                       p::object());
+                       py_owner((mapped) ? std::shared_ptr<void>(mapping) : std::shared_ptr<void>(data)));
 }
 #endif
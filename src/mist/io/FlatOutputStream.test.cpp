@@ -0,0 +1,71 @@
+
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+#include "io/FlatOutputStream.hpp"
+
+using namespace mist;
+using namespace mist::io;
+
+BOOST_AUTO_TEST_CASE(FlatOutputStream_fixed)
+{
+  FlatOutputStream out(3, 3, 10);
+  out.push(12, { 2, 3 }, 0.5);
+  out.push(10, { 0, 1 }, 1.5);
+  out.push(11, { 1, 2 }, { 2.5 });
+  std::vector<double> expect = { 0, 1, 1.5, 1, 2, 2.5, 2, 3, 0.5 };
+  BOOST_TEST(out.get_results() == expect, boost::test_tools::per_element());
+  BOOST_CHECK_THROW(out.push(13, { 3, 4 }, 0.5), FlatOutputStreamException);
+  BOOST_CHECK_THROW(out.push(10, { 3 }, 0.5), FlatOutputStreamException);
+}
+
+BOOST_AUTO_TEST_CASE(FlatOutputStream_segments)
+{
+  // enough rows for several segments in each stream
+  std::size_t nrows = 5 * FlatOutputStream::SEGMENT_ROWS_MIN + 7;
+  FlatOutputStream a(3, 0);
+  FlatOutputStream b(3, 0);
+  FlatOutputStream c(3, 0);
+  std::vector<double> expect;
+  for (auto* out : { &a, &b, &c }) {
+    for (std::size_t ii = 0; ii < nrows; ii++) {
+      Variable::index_t v = expect.size() / 3;
+      out->push(v, { v, v + 1 }, 0.25 * v);
+      expect.insert(expect.end(), { (double)v, (double)v + 1, 0.25 * v });
+    }
+  }
+  a.relocate(b);
+  a.relocate(c);
+  BOOST_TEST(b.get_results().empty());
+  BOOST_TEST(a.get_results(3) == expect, boost::test_tools::per_element());
+
+  // rows pushed after reading follow the gathered rows
+  a.push(0, { 1, 2 }, 0.5);
+  expect.insert(expect.end(), { 1, 2, 0.5 });
+  BOOST_TEST(a.get_results(2) == expect, boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(FlatOutputStream_mapped)
+{
+  auto path = (boost::filesystem::temp_directory_path() /
+               boost::filesystem::unique_path()).string();
+  {
+    FlatOutputStream out(path, 3, 3, 10);
+    out.push(12, { 2, 3 }, 0.5);
+    out.push(10, { 0, 1 }, { 1.5 });
+    out.flush();
+    BOOST_TEST(out.get_mapped_results()[2] == 1.5);
+    BOOST_CHECK_THROW(out.get_results(), FlatOutputStreamException);
+    BOOST_CHECK_THROW(out.push(13, { 3, 4 }, 0.5), FlatOutputStreamException);
+  }
+  // raw rows, the unwritten row zero
+  std::vector<double> expect = { 0, 1, 1.5, 0, 0, 0, 2, 3, 0.5 };
+  std::vector<double> rows(expect.size());
+  std::ifstream in(path, std::ios_base::binary);
+  in.read(reinterpret_cast<char*>(rows.data()), rows.size() * sizeof(double));
+  BOOST_TEST(in.gcount() == (std::streamsize)(rows.size() * sizeof(double)));
+  BOOST_TEST(rows == expect, boost::test_tools::per_element());
+  boost::filesystem::remove(path);
+  BOOST_CHECK_THROW(FlatOutputStream("/nonexistent/results", 3, 3, 0), FlatOutputStreamException);
+}
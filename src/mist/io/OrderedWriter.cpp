@@ -0,0 +1,135 @@
+#include <algorithm>
+
+#include "io/FileOutputStream.hpp"
+#include "io/OrderedWriter.hpp"
+
+using namespace mist;
+using namespace mist::io;
+
+const OrderedWriter::count_t OrderedWriter::BLOCK_SIZE_DEFAULT;
+
+OrderedWriter::OrderedWriter(file_stream_ptr const& file,
+                             count_t start,
+                             count_t stop,
+                             size_type capacity,
+                             count_t block_size)
+  : file(file)
+  , start(start)
+  , stop(stop)
+  , capacity(capacity)
+  , block_size(block_size)
+  , taken(0)
+{
+  if (!file) {
+    throw OrderedWriterException("OrderedWriter", "Invalid output stream");
+  }
+  if (!capacity || !block_size) {
+    throw OrderedWriterException("OrderedWriter",
+                                 "Capacity and block size must be at least 1");
+  }
+  if (stop < start) {
+    throw OrderedWriterException("OrderedWriter",
+                                 "Stop tuple " + std::to_string(stop) +
+                                   " before start " + std::to_string(start));
+  }
+  nblocks = (stop - start + block_size - 1) / block_size;
+  writer = std::thread(&OrderedWriter::write_blocks, this);
+}
+
+OrderedWriter::~OrderedWriter()
+{
+  if (writer.joinable()) {
+    {
+      std::unique_lock<std::mutex> lock(m);
+      closing = true;
+    }
+    submitted.notify_one();
+    writer.join();
+  }
+}
+
+bool
+OrderedWriter::next_block(count_t& block, count_t& begin, count_t& end)
+{
+  block = taken++;
+  if (block >= nblocks) {
+    return false;
+  }
+  begin = start + block * block_size;
+  end = std::min(stop, begin + block_size);
+  return true;
+}
+
+void
+OrderedWriter::submit(count_t block, buffer_type& buffer, size_type size)
+{
+  auto buffer_size = buffer.size();
+  {
+    std::unique_lock<std::mutex> lock(m);
+    // backpressure, wait for room in the reorder buffer
+    written.wait(lock, [&] { return error || block < next + capacity; });
+    if (error) {
+      throw OrderedWriterException("submit", "Writer stopped after an error");
+    }
+    pending_block b;
+    if (!free_buffers.empty()) {
+      b.buffer = std::move(free_buffers.back());
+      free_buffers.pop_back();
+    }
+    b.buffer.swap(buffer);
+    b.size = size;
+    pending.emplace(block, std::move(b));
+  }
+  submitted.notify_one();
+  buffer.resize(buffer_size);
+}
+
+void
+OrderedWriter::write_blocks()
+{
+  std::unique_lock<std::mutex> lock(m);
+  while (next < nblocks) {
+    submitted.wait(lock, [&] { return closing || pending.count(next); });
+    auto it = pending.find(next);
+    if (it == pending.end()) {
+      break;
+    }
+    auto b = std::move(it->second);
+    pending.erase(it);
+    lock.unlock();
+    try {
+      file->write_block(b.buffer.data(), b.size);
+    } catch (...) {
+      lock.lock();
+      error = std::current_exception();
+      written.notify_all();
+      return;
+    }
+    lock.lock();
+    next++;
+    free_buffers.push_back(std::move(b.buffer));
+    written.notify_all();
+  }
+}
+
+void
+OrderedWriter::close()
+{
+  {
+    std::unique_lock<std::mutex> lock(m);
+    closing = true;
+  }
+  submitted.notify_one();
+  if (writer.joinable()) {
+    writer.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  if (next < nblocks) {
+    throw OrderedWriterException("close",
+                                 "Block " + std::to_string(next) +
+                                   " of " + std::to_string(nblocks) +
+                                   " was not submitted");
+  }
+}
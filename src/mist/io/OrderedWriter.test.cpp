@@ -0,0 +1,68 @@
+
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <thread>
+
+#include "io/FileOutputStream.hpp"
+#include "io/OrderedWriter.hpp"
+
+using namespace mist;
+using namespace mist::io;
+
+BOOST_AUTO_TEST_CASE(OrderedWriter_order)
+{
+  auto path = (boost::filesystem::temp_directory_path() /
+               boost::filesystem::unique_path()).string();
+  std::size_t ntuples = 50;
+  {
+    auto file = std::make_shared<FileOutputStream>(path, "v0,H");
+    // smallest reorder buffer, every thread waits on the slowest
+    auto writer = std::make_shared<OrderedWriter>(file, 0, ntuples, 1, 3);
+    BOOST_TEST(writer->num_blocks() == 17);
+    auto work = [&](std::size_t rank) {
+      auto out = file->clone();
+      out->set_ordered(writer);
+      OrderedWriter::count_t block, begin, end;
+      while (writer->next_block(block, begin, end)) {
+        for (auto ii = begin; ii < end; ii++) {
+          out->push(ii, { (Variable::index_t)ii }, (double)rank);
+        }
+        out->end_block(block);
+      }
+    };
+    std::vector<std::thread> threads;
+    for (std::size_t rank = 0; rank < 3; rank++) {
+      threads.emplace_back(work, rank);
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    writer->close();
+  }
+  std::ifstream in(path);
+  std::string line;
+  std::getline(in, line);
+  BOOST_TEST(line == "v0,H");
+  std::size_t ii = 0;
+  while (std::getline(in, line)) {
+    BOOST_TEST(line.substr(0, line.find(',')) == std::to_string(ii));
+    ii++;
+  }
+  BOOST_TEST(ii == ntuples);
+  boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(OrderedWriter_missing_block)
+{
+  auto path = (boost::filesystem::temp_directory_path() /
+               boost::filesystem::unique_path()).string();
+  auto file = std::make_shared<FileOutputStream>(path, "v0,H");
+  OrderedWriter writer(file, 0, 10, 2, 5);
+  std::vector<char> buffer(8, 'x');
+  writer.submit(1, buffer, 4);
+  BOOST_TEST(buffer.size() == 8);
+  BOOST_CHECK_THROW(writer.close(), OrderedWriterException);
+  BOOST_CHECK_THROW(OrderedWriter(file, 0, 10, 0), OrderedWriterException);
+  boost::filesystem::remove(path);
+}
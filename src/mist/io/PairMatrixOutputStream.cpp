@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "io/PairMatrixOutputStream.hpp"
+
+using namespace mist;
+using namespace mist::io;
+
+static const double missing = std::numeric_limits<double>::quiet_NaN();
+
+PairMatrixOutputStream::PairMatrixOutputStream(std::size_t nvar, std::size_t nplanes)
+  : OutputStream(mutex_ptr(new mutex_type))
+  , nvar(nvar)
+  , nplanes(nplanes)
+  , plane_size((nvar * (nvar - 1)) / 2)
+{
+  if (nvar < 2 || !nplanes) {
+    throw PairMatrixOutputStreamException("PairMatrixOutputStream",
+                                          "Need at least 2 variables and 1 plane");
+  }
+  auto n = nplanes * plane_size;
+  try {
+    planes.reset(new data_t[n], std::default_delete<data_t[]>());
+  } catch (std::bad_alloc const&) {
+    throw PairMatrixOutputStreamException("PairMatrixOutputStream",
+                                          "Not enough memory to init planes");
+  }
+  std::fill(planes.get(), planes.get() + n, missing);
+}
+
+PairMatrixOutputStream::PairMatrixOutputStream(std::string const& filename,
+                                               std::size_t nvar,
+                                               std::size_t nplanes)
+  : OutputStream(mutex_ptr(new mutex_type))
+  , nvar(nvar)
+  , nplanes(nplanes)
+  , plane_size((nvar * (nvar - 1)) / 2)
+  , mapped_file(filename)
+{
+  if (nvar < 2 || !nplanes) {
+    throw PairMatrixOutputStreamException("PairMatrixOutputStream",
+                                          "Need at least 2 variables and 1 plane");
+  }
+  auto n = nplanes * plane_size;
+  std::size_t bytes = n * sizeof(data_t);
+  int fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    throw PairMatrixOutputStreamException("PairMatrixOutputStream",
+                                          "Could not open file '" + filename +
+                                            "': " + std::strerror(errno));
+  }
+  void* addr = MAP_FAILED;
+  if (::ftruncate(fd, bytes) == 0) {
+    addr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  int err = errno;
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    throw PairMatrixOutputStreamException("PairMatrixOutputStream",
+                                          "Could not map file '" + filename +
+                                            "': " + std::strerror(err));
+  }
+  planes = std::shared_ptr<data_t>(static_cast<data_t*>(addr), [bytes](data_t* p) {
+    ::munmap(p, bytes);
+  });
+  std::fill(planes.get(), planes.get() + n, missing);
+}
+
+void
+PairMatrixOutputStream::write_pair(tuple_type const& tuple, data_t const* values, std::size_t n)
+{
+  if (tuple.size() != 2 || tuple[0] == tuple[1] || tuple[0] >= nvar || tuple[1] >= nvar) {
+    throw PairMatrixOutputStreamException("push", "Tuple is not a pair of the matrix");
+  }
+  if (n != nplanes) {
+    throw PairMatrixOutputStreamException("push", "Unexpected result length");
+  }
+  auto element = planes.get() + index(tuple[0], tuple[1]);
+  for (std::size_t k = 0; k < n; k++, element += plane_size) {
+    *element = values[k];
+  }
+}
+
+void
+PairMatrixOutputStream::push(std::size_t tuple_no, tuple_type const& tuple, result_type const& result)
+{
+  write_pair(tuple, result.data(), result.size());
+}
+
+void
+PairMatrixOutputStream::push(std::size_t tuple_no, tuple_type const& tuple, it::entropy_type result)
+{
+  write_pair(tuple, &result, 1);
+}
+
+void
+PairMatrixOutputStream::copy_pairs(PairMatrixOutputStream const& other)
+{
+  if (other.nplanes != nplanes || other.nvar > nvar) {
+    throw PairMatrixOutputStreamException("copy_pairs",
+                                          "Pair matrix of different planes or more variables");
+  }
+  // the pairs of the first variables come first in each plane
+  for (std::size_t k = 0; k < nplanes; k++) {
+    std::copy(other.plane(k), other.plane(k) + other.plane_size,
+              planes.get() + k * plane_size);
+  }
+}
+
+PairMatrixOutputStream::data_t
+PairMatrixOutputStream::value(std::size_t k, std::size_t i, std::size_t j) const
+{
+  if (k >= nplanes || i == j || i >= nvar || j >= nvar) {
+    return missing;
+  }
+  return plane(k)[index(i, j)];
+}
+
+void
+PairMatrixOutputStream::flush()
+{
+  if (is_mapped()) {
+    ::msync(planes.get(), nplanes * plane_size * sizeof(data_t), MS_ASYNC);
+  }
+}
+
+#if BOOST_PYTHON_EXTENSIONS
+np::ndarray
+PairMatrixOutputStream::py_get_planes()
+{
+  return np::from_data(planes.get(),
+                       np::dtype::get_builtin<data_t>(),
+                       p::make_tuple(nplanes, plane_size),
+                       p::make_tuple(sizeof(data_t) * plane_size, sizeof(data_t)),
+                       py_owner(planes));
+}
+#endif
@@ -0,0 +1,63 @@
+
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <cmath>
+#include <fstream>
+
+#include "io/PairMatrixOutputStream.hpp"
+
+using namespace mist;
+using namespace mist::io;
+
+BOOST_AUTO_TEST_CASE(PairMatrixOutputStream_packed)
+{
+  PairMatrixOutputStream out(4, 2);
+  BOOST_TEST(out.get_plane_size() == 6);
+  out.push(0, { 0, 1 }, { 0.5, 1.5 });
+  out.push(5, { 3, 2 }, { 2.5, 3.5 });
+  // Flat2D order, pairs by the larger variable
+  BOOST_TEST(out.plane(0)[0] == 0.5);
+  BOOST_TEST(out.plane(1)[5] == 3.5);
+  BOOST_TEST(out.value(0, 2, 3) == 2.5);
+  BOOST_TEST(out.value(1, 1, 0) == 1.5);
+  BOOST_TEST(std::isnan(out.value(0, 0, 2)));
+  BOOST_TEST(std::isnan(out.value(0, 1, 1)));
+  BOOST_CHECK_THROW(out.push(0, { 1, 1 }, { 0.0, 0.0 }), PairMatrixOutputStreamException);
+  BOOST_CHECK_THROW(out.push(0, { 0, 4 }, { 0.0, 0.0 }), PairMatrixOutputStreamException);
+  BOOST_CHECK_THROW(out.push(0, { 0, 1 }, 1.0), PairMatrixOutputStreamException);
+}
+
+BOOST_AUTO_TEST_CASE(PairMatrixOutputStream_copy_pairs)
+{
+  PairMatrixOutputStream small(3, 1);
+  small.push(0, { 0, 1 }, 1.0);
+  small.push(1, { 0, 2 }, 2.0);
+  small.push(2, { 1, 2 }, 3.0);
+  PairMatrixOutputStream large(5, 1);
+  large.copy_pairs(small);
+  large.push(3, { 0, 4 }, 4.0);
+  BOOST_TEST(large.value(0, 0, 1) == 1.0);
+  BOOST_TEST(large.value(0, 1, 2) == 3.0);
+  BOOST_TEST(large.value(0, 0, 4) == 4.0);
+  BOOST_TEST(std::isnan(large.value(0, 0, 3)));
+  BOOST_CHECK_THROW(small.copy_pairs(large), PairMatrixOutputStreamException);
+}
+
+BOOST_AUTO_TEST_CASE(PairMatrixOutputStream_mapped)
+{
+  auto path = (boost::filesystem::temp_directory_path() /
+               boost::filesystem::unique_path()).string();
+  {
+    PairMatrixOutputStream out(path, 3, 1);
+    BOOST_TEST(out.is_mapped());
+    out.push(0, { 2, 1 }, 0.25);
+    out.flush();
+  }
+  double values[3];
+  std::ifstream in(path, std::ios::binary);
+  in.read(reinterpret_cast<char*>(values), sizeof(values));
+  BOOST_TEST(in.good());
+  BOOST_TEST(std::isnan(values[0]));
+  BOOST_TEST(values[2] == 0.25);
+  boost::filesystem::remove(path);
+}
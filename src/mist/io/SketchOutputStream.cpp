@@ -0,0 +1,259 @@
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include "io/SketchOutputStream.hpp"
+
+using namespace mist;
+using namespace mist::io;
+
+constexpr double SketchOutputStream::ACCURACY_DEFAULT;
+
+// file signature for write_file/merge_file
+static const char sketch_magic[8] = { 'M', 'I', 'S', 'T', 'S', 'K', 'C', 'H' };
+
+SketchOutputStream::SketchOutputStream(double accuracy)
+  : OutputStream(mutex_ptr(new mutex_type))
+  , accuracy(accuracy)
+  , min_value(std::numeric_limits<double>::infinity())
+  , max_value(-std::numeric_limits<double>::infinity())
+{
+  if (!(accuracy > 0 && accuracy < 1)) {
+    throw SketchOutputStreamException("SketchOutputStream",
+                                      "Accuracy must be between 0 and 1");
+  }
+  gamma = (1 + accuracy) / (1 - accuracy);
+  log_gamma = std::log(gamma);
+}
+
+int
+SketchOutputStream::index(double magnitude) const
+{
+  return (int)std::ceil(std::log(magnitude) / log_gamma);
+}
+
+double
+SketchOutputStream::bucket_value(int index) const
+{
+  // the midpoint in relative terms of (gamma^(i-1), gamma^i]
+  return 2 * std::pow(gamma, index) / (gamma + 1);
+}
+
+void
+SketchOutputStream::add(double value, count_t n)
+{
+  if (std::isnan(value) || !n) {
+    return;
+  }
+  if (value > 0) {
+    positive[index(value)] += n;
+  } else if (value < 0) {
+    negative[index(-value)] += n;
+  } else {
+    zero += n;
+  }
+  total += n;
+  min_value = std::min(min_value, value);
+  max_value = std::max(max_value, value);
+}
+
+void
+SketchOutputStream::push(std::size_t tuple_no, tuple_type const& tuple, result_type const& result)
+{
+  add(result.back());
+}
+
+void
+SketchOutputStream::push(std::size_t tuple_no, tuple_type const& tuple, it::entropy_type result)
+{
+  add(result);
+}
+
+void
+SketchOutputStream::merge(SketchOutputStream const& other)
+{
+  if (other.accuracy != accuracy) {
+    throw SketchOutputStreamException("merge", "Sketches of different accuracy");
+  }
+  for (auto const& b : other.positive) {
+    positive[b.first] += b.second;
+  }
+  for (auto const& b : other.negative) {
+    negative[b.first] += b.second;
+  }
+  zero += other.zero;
+  total += other.total;
+  min_value = std::min(min_value, other.min_value);
+  max_value = std::max(max_value, other.max_value);
+}
+
+SketchOutputStream::buckets_t
+SketchOutputStream::buckets() const
+{
+  buckets_t buckets;
+  buckets.reserve(negative.size() + positive.size() + 1);
+  for (auto it = negative.rbegin(); it != negative.rend(); ++it) {
+    buckets.push_back(bucket{ -bucket_value(it->first), it->second });
+  }
+  if (zero) {
+    buckets.push_back(bucket{ 0.0, zero });
+  }
+  for (auto const& b : positive) {
+    buckets.push_back(bucket{ bucket_value(b.first), b.second });
+  }
+  // the end buckets are narrowed to the values seen
+  if (!buckets.empty()) {
+    buckets.front().value = std::max(buckets.front().value, min_value);
+    buckets.back().value = std::min(buckets.back().value, max_value);
+  }
+  return buckets;
+}
+
+double
+SketchOutputStream::quantile(double q) const
+{
+  if (!total) {
+    throw SketchOutputStreamException("quantile", "No values in the sketch");
+  }
+  if (!(q >= 0 && q <= 1)) {
+    throw SketchOutputStreamException("quantile", "Quantile must be between 0 and 1");
+  }
+  auto rank = (count_t)std::floor(q * (total - 1));
+  // the ends are known exactly
+  if (!rank) {
+    return min_value;
+  }
+  if (rank == total - 1) {
+    return max_value;
+  }
+  count_t seen = 0;
+  auto all = buckets();
+  for (auto const& b : all) {
+    seen += b.count;
+    if (seen > rank) {
+      return std::min(std::max(b.value, min_value), max_value);
+    }
+  }
+  return max_value;
+}
+
+double
+SketchOutputStream::top_fraction_cutoff(double fraction) const
+{
+  if (!(fraction >= 0 && fraction <= 1)) {
+    throw SketchOutputStreamException("top_fraction_cutoff",
+                                      "Fraction must be between 0 and 1");
+  }
+  return quantile(1 - fraction);
+}
+
+#if BOOST_PYTHON_EXTENSIONS
+np::ndarray
+SketchOutputStream::py_buckets() const
+{
+  auto all = buckets();
+  auto array = np::empty(p::make_tuple(all.size(), 2), np::dtype::get_builtin<double>());
+  auto data = reinterpret_cast<double*>(array.get_data());
+  for (std::size_t ii = 0; ii < all.size(); ii++) {
+    data[2 * ii] = all[ii].value;
+    data[2 * ii + 1] = (double)all[ii].count;
+  }
+  return array;
+}
+#endif
+
+template<typename T>
+static void
+write_value(std::ofstream& ofs, T value)
+{
+  ofs.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+static T
+read_value(std::ifstream& ifs)
+{
+  T value;
+  ifs.read(reinterpret_cast<char*>(&value), sizeof(T));
+  return value;
+}
+
+static void
+write_buckets(std::ofstream& ofs, std::map<int, SketchOutputStream::count_t> const& buckets)
+{
+  write_value<std::uint64_t>(ofs, buckets.size());
+  for (auto const& b : buckets) {
+    write_value<std::int32_t>(ofs, b.first);
+    write_value<std::uint64_t>(ofs, b.second);
+  }
+}
+
+static void
+read_buckets(std::ifstream& ifs, std::map<int, SketchOutputStream::count_t>& buckets)
+{
+  auto n = read_value<std::uint64_t>(ifs);
+  for (std::uint64_t ii = 0; ii < n && ifs; ii++) {
+    auto index = read_value<std::int32_t>(ifs);
+    auto count = read_value<std::uint64_t>(ifs);
+    if (ifs) {
+      buckets[index] += count;
+    }
+  }
+}
+
+void
+SketchOutputStream::write_file(std::string const& filename) const
+{
+  std::ofstream ofs(filename, std::ofstream::binary);
+  if (!ofs.is_open()) {
+    throw SketchOutputStreamException("write_file",
+                                      "Could not open file '" + filename +
+                                        "' for writing: " + std::strerror(errno));
+  }
+  ofs.write(sketch_magic, sizeof(sketch_magic));
+  write_value<double>(ofs, accuracy);
+  write_value<std::uint64_t>(ofs, total);
+  write_value<std::uint64_t>(ofs, zero);
+  write_value<double>(ofs, min_value);
+  write_value<double>(ofs, max_value);
+  write_buckets(ofs, positive);
+  write_buckets(ofs, negative);
+  if (!ofs) {
+    throw SketchOutputStreamException("write_file",
+                                      "Error writing file '" + filename + "'");
+  }
+}
+
+void
+SketchOutputStream::merge_file(std::string const& filename)
+{
+  std::ifstream ifs(filename, std::ifstream::binary);
+  if (!ifs.is_open()) {
+    throw SketchOutputStreamException("merge_file",
+                                      "Could not open file '" + filename +
+                                        "': " + std::strerror(errno));
+  }
+  char magic[sizeof(sketch_magic)];
+  ifs.read(magic, sizeof(magic));
+  if (!ifs || !std::equal(magic, magic + sizeof(magic), sketch_magic)) {
+    throw SketchOutputStreamException("merge_file",
+                                      "File '" + filename +
+                                        "' is not a result sketch file");
+  }
+  // read into a sketch of its own so a bad file leaves this one as it was
+  SketchOutputStream other(read_value<double>(ifs));
+  other.total = read_value<std::uint64_t>(ifs);
+  other.zero = read_value<std::uint64_t>(ifs);
+  other.min_value = read_value<double>(ifs);
+  other.max_value = read_value<double>(ifs);
+  read_buckets(ifs, other.positive);
+  read_buckets(ifs, other.negative);
+  if (!ifs) {
+    throw SketchOutputStreamException("merge_file",
+                                      "File '" + filename + "' is truncated");
+  }
+  merge(other);
+}
@@ -0,0 +1,67 @@
+
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <cmath>
+
+#include "io/SketchOutputStream.hpp"
+
+using namespace mist;
+using namespace mist::io;
+
+BOOST_AUTO_TEST_CASE(SketchOutputStream_quantiles)
+{
+  SketchOutputStream sketch(0.01);
+  for (std::uint32_t ii = 1; ii <= 1000; ii++) {
+    sketch.push(ii, { ii, ii + 1 }, (double)ii);
+  }
+  BOOST_TEST(sketch.count() == 1000);
+  BOOST_TEST(sketch.min() == 1.0);
+  BOOST_TEST(sketch.max() == 1000.0);
+  BOOST_TEST(sketch.quantile(0) == 1.0);
+  BOOST_TEST(sketch.quantile(1) == 1000.0);
+  BOOST_TEST(std::abs(sketch.quantile(0.5) - 500) <= 0.01 * 500);
+  // about the best 10% of values reach the cutoff
+  BOOST_TEST(std::abs(sketch.top_fraction_cutoff(0.1) - 900) <= 0.01 * 900);
+  BOOST_CHECK_THROW(sketch.quantile(1.5), SketchOutputStreamException);
+  BOOST_CHECK_THROW(SketchOutputStream().quantile(0.5), SketchOutputStreamException);
+  BOOST_CHECK_THROW(SketchOutputStream(0), SketchOutputStreamException);
+}
+
+BOOST_AUTO_TEST_CASE(SketchOutputStream_signs)
+{
+  SketchOutputStream sketch;
+  double values[5] = { -2.0, -0.5, 0.0, 0.5, 2.0 };
+  for (auto v : values) {
+    sketch.add(v);
+  }
+  sketch.add(std::nan(""));
+  BOOST_TEST(sketch.count() == 5);
+  auto buckets = sketch.buckets();
+  BOOST_TEST(buckets.size() == 5);
+  for (std::size_t ii = 0; ii < 5; ii++) {
+    BOOST_TEST(std::abs(buckets[ii].value - values[ii]) <= 0.01 * std::abs(values[ii]));
+  }
+  BOOST_TEST(sketch.quantile(0.5) == 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(SketchOutputStream_merge_file)
+{
+  // merging sketches of parts is the same as sketching the whole
+  SketchOutputStream whole, a, b;
+  for (std::uint32_t ii = 0; ii < 500; ii++) {
+    double v = std::sin(ii) * ii;
+    whole.add(v);
+    ((ii % 3) ? a : b).add(v);
+  }
+  auto path = boost::filesystem::temp_directory_path() /
+              boost::filesystem::unique_path();
+  b.write_file(path.string());
+  a.merge_file(path.string());
+  boost::filesystem::remove(path);
+  BOOST_TEST(a.count() == whole.count());
+  for (double q : { 0.0, 0.1, 0.5, 0.9, 1.0 }) {
+    BOOST_TEST(a.quantile(q) == whole.quantile(q));
+  }
+  BOOST_CHECK_THROW(a.merge(SketchOutputStream(0.05)), SketchOutputStreamException);
+  BOOST_CHECK_THROW(a.merge_file(path.string()), SketchOutputStreamException);
+}
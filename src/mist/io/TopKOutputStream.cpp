@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#include "io/TopKOutputStream.hpp"
+#include "it/Entropy.hpp"
+
+using namespace mist;
+using namespace mist::io;
+
+// file signature for write_file/merge_file
+static const char topk_magic[8] = { 'M', 'I', 'S', 'T', 'T', 'O', 'P', 'K' };
+
+// a is a better result than b
+static inline bool
+better(it::entropy_type a_value,
+       TopKOutputStream::count_t a_no,
+       it::entropy_type b_value,
+       TopKOutputStream::count_t b_no)
+{
+  return a_value > b_value || (a_value == b_value && a_no < b_no);
+}
+
+// heap order, worst result at the front
+static inline bool
+heap_compare(TopKOutputStream::entry const& a, TopKOutputStream::entry const& b)
+{
+  return better(a.value, a.tuple_no, b.value, b.tuple_no);
+}
+
+TopKOutputStream::TopKOutputStream(std::size_t k)
+  : OutputStream(mutex_ptr(new mutex_type))
+  , k(k)
+{
+  if (!k) {
+    throw TopKOutputStreamException("TopKOutputStream", "K must be greater than zero");
+  }
+  heap.reserve(k);
+};
+
+TopKOutputStream::~TopKOutputStream(){};
+
+void
+TopKOutputStream::push_entry(it::entropy_type value,
+                             count_t tuple_no,
+                             tuple_type const& tuple,
+                             result_type const* result)
+{
+  // NaN cannot be ordered
+  if (std::isnan(value)) {
+    return;
+  }
+  if (heap.size() < k) {
+    heap.push_back(entry{ value, tuple_no, tuple, (result) ? *result : result_type(1, value) });
+    std::push_heap(heap.begin(), heap.end(), heap_compare);
+    return;
+  }
+  auto const& worst = heap.front();
+  if (!better(value, tuple_no, worst.value, worst.tuple_no)) {
+    return;
+  }
+  // replace the worst entry in place, reusing its buffers
+  std::pop_heap(heap.begin(), heap.end(), heap_compare);
+  auto& e = heap.back();
+  e.value = value;
+  e.tuple_no = tuple_no;
+  e.tuple = tuple;
+  if (result) {
+    e.result = *result;
+  } else {
+    e.result.assign(1, value);
+  }
+  std::push_heap(heap.begin(), heap.end(), heap_compare);
+}
+
+void
+TopKOutputStream::push(std::size_t tuple_no, tuple_type const& tuple, result_type const& result)
+{
+  push_entry(result.back(), tuple_no, tuple, &result);
+}
+
+void
+TopKOutputStream::push(std::size_t tuple_no, tuple_type const& tuple, it::entropy_type result)
+{
+  push_entry(result, tuple_no, tuple, nullptr);
+}
+
+it::entropy_type
+TopKOutputStream::min_value() const
+{
+  if (heap.size() < k) {
+    return -std::numeric_limits<it::entropy_type>::infinity();
+  }
+  return heap.front().value;
+}
+
+void
+TopKOutputStream::merge(TopKOutputStream const& other)
+{
+  for (auto const& e : other.heap) {
+    push_entry(e.value, e.tuple_no, e.tuple, &e.result);
+  }
+}
+
+TopKOutputStream::entries_t
+TopKOutputStream::sorted() const
+{
+  entries_t entries(heap);
+  std::sort_heap(entries.begin(), entries.end(), heap_compare);
+  return entries;
+}
+
+std::size_t
+TopKOutputStream::size() const
+{
+  return heap.size();
+}
+
+std::size_t
+TopKOutputStream::get_k() const
+{
+  return k;
+}
+
+template<typename T>
+static void
+write_value(std::ofstream& ofs, T value)
+{
+  ofs.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+static T
+read_value(std::ifstream& ifs)
+{
+  T value;
+  ifs.read(reinterpret_cast<char*>(&value), sizeof(T));
+  return value;
+}
+
+void
+TopKOutputStream::write_file(std::string const& filename) const
+{
+  std::ofstream ofs(filename, std::ofstream::binary);
+  if (!ofs.is_open()) {
+    throw TopKOutputStreamException("write_file",
+                                    "Could not open file '" + filename +
+                                      "' for writing: " + std::strerror(errno));
+  }
+  ofs.write(topk_magic, sizeof(topk_magic));
+  write_value<std::uint64_t>(ofs, k);
+  write_value<std::uint64_t>(ofs, heap.size());
+  for (auto const& e : heap) {
+    write_value<it::entropy_type>(ofs, e.value);
+    write_value<std::uint64_t>(ofs, e.tuple_no);
+    write_value<std::uint32_t>(ofs, e.tuple.size());
+    ofs.write(reinterpret_cast<const char*>(e.tuple.data()),
+              e.tuple.size() * sizeof(tuple_type::value_type));
+    write_value<std::uint32_t>(ofs, e.result.size());
+    ofs.write(reinterpret_cast<const char*>(e.result.data()),
+              e.result.size() * sizeof(data_t));
+  }
+  if (!ofs) {
+    throw TopKOutputStreamException("write_file",
+                                    "Error writing file '" + filename + "'");
+  }
+}
+
+void
+TopKOutputStream::merge_file(std::string const& filename)
+{
+  std::ifstream ifs(filename, std::ifstream::binary);
+  if (!ifs.is_open()) {
+    throw TopKOutputStreamException("merge_file",
+                                    "Could not open file '" + filename +
+                                      "': " + std::strerror(errno));
+  }
+  char magic[sizeof(topk_magic)];
+  ifs.read(magic, sizeof(magic));
+  if (!ifs || !std::equal(magic, magic + sizeof(magic), topk_magic)) {
+    throw TopKOutputStreamException("merge_file",
+                                    "File '" + filename +
+                                      "' is not a top-K results file");
+  }
+  read_value<std::uint64_t>(ifs); // k of the other heap
+  auto n = read_value<std::uint64_t>(ifs);
+  tuple_type tuple;
+  result_type result;
+  for (std::uint64_t ii = 0; ii < n && ifs; ii++) {
+    auto value = read_value<it::entropy_type>(ifs);
+    auto tuple_no = read_value<std::uint64_t>(ifs);
+    tuple.resize(read_value<std::uint32_t>(ifs));
+    ifs.read(reinterpret_cast<char*>(tuple.data()),
+             tuple.size() * sizeof(tuple_type::value_type));
+    result.resize(read_value<std::uint32_t>(ifs));
+    ifs.read(reinterpret_cast<char*>(result.data()),
+             result.size() * sizeof(data_t));
+    if (ifs) {
+      push_entry(value, tuple_no, tuple, &result);
+    }
+  }
+  if (!ifs) {
+    throw TopKOutputStreamException("merge_file",
+                                    "File '" + filename + "' is truncated");
+  }
+}
@@ -0,0 +1,62 @@
+
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+
+#include "io/TopKOutputStream.hpp"
+
+using namespace mist;
+using namespace mist::io;
+
+BOOST_AUTO_TEST_CASE(TopKOutputStream_keeps_best)
+{
+  TopKOutputStream topk(3);
+  BOOST_TEST(topk.min_value() == -std::numeric_limits<double>::infinity());
+  double values[6] = { 0.5, 0.1, 0.9, 0.3, 0.7, 0.2 };
+  for (std::uint32_t ii = 0; ii < 6; ii++) {
+    topk.push(ii, { ii, ii + 1 }, values[ii]);
+  }
+  BOOST_TEST(topk.size() == 3);
+  BOOST_TEST(topk.min_value() == 0.5);
+  auto entries = topk.sorted();
+  BOOST_TEST(entries[0].value == 0.9);
+  BOOST_TEST(entries[1].value == 0.7);
+  BOOST_TEST(entries[2].value == 0.5);
+  BOOST_TEST(entries[0].tuple_no == 2);
+}
+
+BOOST_AUTO_TEST_CASE(TopKOutputStream_merge_ties)
+{
+  // equal values keep the lowest tuple numbers regardless of merge order
+  TopKOutputStream a(2);
+  TopKOutputStream b(2);
+  a.push(5, { 0, 1 }, 1.0);
+  a.push(1, { 0, 2 }, 1.0);
+  b.push(3, { 1, 2 }, 1.0);
+  b.push(0, { 0, 3 }, 1.0);
+  a.merge(b);
+  auto entries = a.sorted();
+  BOOST_TEST(entries.size() == 2);
+  BOOST_TEST(entries[0].tuple_no == 0);
+  BOOST_TEST(entries[1].tuple_no == 1);
+}
+
+BOOST_AUTO_TEST_CASE(TopKOutputStream_file_roundtrip)
+{
+  auto path = boost::filesystem::temp_directory_path() /
+              boost::filesystem::unique_path();
+  TopKOutputStream a(4);
+  a.push(0, { 0, 1 }, { 0.25, 0.5 });
+  a.push(1, { 0, 2 }, { 0.125, 0.75 });
+  a.write_file(path.string());
+  TopKOutputStream b(4);
+  b.push(2, { 1, 2 }, { 0.0, 0.625 });
+  b.merge_file(path.string());
+  boost::filesystem::remove(path);
+  auto entries = b.sorted();
+  BOOST_TEST(entries.size() == 3);
+  BOOST_TEST(entries[0].tuple_no == 1);
+  BOOST_TEST(entries[0].result[0] == 0.125);
+  BOOST_TEST(entries[1].tuple_no == 2);
+  BOOST_TEST(entries[2].tuple_no == 0);
+  BOOST_CHECK_THROW(b.merge_file(path.string()), TopKOutputStreamException);
+}
@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+#include "it/BootstrapMeasure.hpp"
+
+using namespace mist;
+using namespace mist::it;
+
+std::vector<BootstrapMeasure::weight_t>
+BootstrapMeasure::poisson_weights(std::size_t nrow,
+                                  std::size_t replicates,
+                                  unsigned seed)
+{
+  std::mt19937 gen(seed);
+  std::vector<weight_t> w(nrow * replicates);
+  const double p0 = std::exp(-1.0);
+  for (auto& weight : w) {
+    double u = gen() * (1.0 / 4294967296.0);
+    unsigned k = 0;
+    double p = p0;
+    double cdf = p;
+    while (u >= cdf && k < 255) {
+      k++;
+      p /= k;
+      cdf += p;
+    }
+    weight = k;
+  }
+  return w;
+}
+
+BootstrapMeasure::BootstrapMeasure(measure_ptr const& measure,
+                                   variables_ptr const& vars,
+                                   std::size_t replicates,
+                                   double confidence,
+                                   unsigned seed)
+  : measure(measure)
+  , vars(vars)
+  , replicates(replicates)
+  , confidence(confidence)
+{
+  if (!replicates) {
+    throw BootstrapMeasureException("BootstrapMeasure", "No replicates.");
+  }
+  if (!(confidence > 0 && confidence < 1)) {
+    throw BootstrapMeasureException(
+      "BootstrapMeasure",
+      "Confidence " + std::to_string(confidence) + " out of range (0,1)");
+  }
+  auto nrow = (vars->empty()) ? 0 : vars->front().size();
+  weights = poisson_weights(nrow, replicates, seed);
+  auto n = measure->num_values();
+  // tuple columns once, then the sub calculations, the replicate summaries
+  // and the final values
+  for (int d = 1; d <= 4; d++) {
+    std::vector<std::string> all;
+    try {
+      all = measure->names(d, true);
+    } catch (std::exception const& e) {
+      continue;
+    }
+    std::vector<std::string> summary;
+    for (auto it = all.end() - n; it != all.end(); it++) {
+      summary.push_back(*it + "_mean");
+      summary.push_back(*it + "_lo");
+      summary.push_back(*it + "_hi");
+    }
+    auto& brief = names_d[d - 1];
+    auto& full_names = names_d_full[d - 1];
+    brief.assign(all.begin(), all.begin() + d);
+    brief.insert(brief.end(), summary.begin(), summary.end());
+    brief.insert(brief.end(), all.end() - n, all.end());
+    full_names.assign(all.begin(), all.end() - n);
+    full_names.insert(full_names.end(), summary.begin(), summary.end());
+    full_names.insert(full_names.end(), all.end() - n, all.end());
+  }
+}
+
+// Per-thread buffers, the measure is shared by all Workers
+static thread_local MarginalCountTable table;
+static thread_local Entropy entropy_buffer;
+static thread_local Measure::result_type replicate_result;
+static thread_local std::vector<Measure::result_type> replicate_buffer;
+
+// Layer 0 counts the data, layer 1 + b replicate b
+void
+BootstrapMeasure::count(Variable::indexes const& tuple) const
+{
+  table.reset(*vars, tuple, replicates + 1);
+  auto w = weights.data();
+  auto B = replicates;
+  table.count([w, B](std::size_t row, MarginalCountTable::count_t* counts) {
+    ++counts[0];
+    auto rw = w + row * B;
+    for (std::size_t b = 0; b < B; b++) {
+      counts[b + 1] += rw[b];
+    }
+  });
+}
+
+void
+BootstrapMeasure::replicate_values(EntropyCalculator& ecalc,
+                                   Variable::indexes const& tuple,
+                                   std::vector<result_type>& values) const
+{
+  count(tuple);
+  auto n = measure->num_values();
+  values.resize(n);
+  for (auto& v : values) {
+    v.resize(replicates);
+  }
+  auto& e = entropy_buffer;
+  auto& r = replicate_result;
+  for (std::size_t b = 0; b < replicates; b++) {
+    table.entropies(b + 1, e);
+    measure->compute(ecalc, tuple, e, r);
+    for (std::size_t ii = 0; ii < n; ii++) {
+      values[ii][b] = r[r.size() - n + ii];
+    }
+  }
+}
+
+// Percentile by linear interpolation between order statistics
+static Measure::data_t
+percentile(Measure::result_type const& sorted, double q)
+{
+  double pos = q * (sorted.size() - 1);
+  auto lo = static_cast<std::size_t>(std::floor(pos));
+  auto hi = std::min(lo + 1, sorted.size() - 1);
+  return sorted[lo] + (pos - lo) * (sorted[hi] - sorted[lo]);
+}
+
+BootstrapMeasure::result_type
+BootstrapMeasure::compute(EntropyCalculator& ecalc,
+                          Variable::indexes const& tuple) const
+{
+  result_type result;
+  compute(ecalc, tuple, result);
+  return result;
+}
+
+void
+BootstrapMeasure::compute(EntropyCalculator& ecalc,
+                          Variable::indexes const& tuple,
+                          result_type& result) const
+{
+  auto& values = replicate_buffer;
+  replicate_values(ecalc, tuple, values);
+  // the table still holds the data in layer 0
+  table.entropies(0, entropy_buffer);
+  measure->compute(ecalc, tuple, entropy_buffer, result);
+
+  auto n = measure->num_values();
+  auto nsub = result.size() - n;
+  result.resize(nsub + 4 * n);
+  // final values go after the summaries
+  std::copy_backward(result.begin() + nsub,
+                     result.begin() + nsub + n,
+                     result.end());
+  double alpha = (1 - confidence) / 2;
+  auto out = result.begin() + nsub;
+  for (auto& v : values) {
+    double sum = 0;
+    for (auto x : v) {
+      sum += x;
+    }
+    std::sort(v.begin(), v.end());
+    *out++ = sum / replicates;
+    *out++ = percentile(v, alpha);
+    *out++ = percentile(v, 1 - alpha);
+  }
+}
+
+BootstrapMeasure::result_type
+BootstrapMeasure::compute(EntropyCalculator& ecalc,
+                          Variable::indexes const& tuple,
+                          Entropy const& e) const
+{
+  return compute(ecalc, tuple);
+}
+
+void
+BootstrapMeasure::compute(EntropyCalculator& ecalc,
+                          Variable::indexes const& tuple,
+                          Entropy const& e,
+                          result_type& result) const
+{
+  compute(ecalc, tuple, result);
+}
+
+std::vector<std::string> const&
+BootstrapMeasure::names(int d, bool full_output) const
+{
+  if (d < 1 || d > 4 || names_d[d - 1].empty()) {
+    throw BootstrapMeasureException("names",
+                                    "Unsupported tuple size " +
+                                      std::to_string(d));
+  }
+  return (full_output) ? names_d_full[d - 1] : names_d[d - 1];
+}
+
+std::string
+BootstrapMeasure::header(int d, bool full_output) const
+{
+  auto n = names(d, full_output);
+  std::string h = n.front();
+  auto N = n.size();
+  for (std::size_t ii = 1; ii < N; ii++) {
+    h += "," + n[ii];
+  }
+  return h;
+}
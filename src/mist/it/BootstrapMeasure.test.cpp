@@ -0,0 +1,113 @@
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+
+#include "io/DataMatrix.hpp"
+#include "it/BootstrapMeasure.hpp"
+#include "it/Entropy.hpp"
+#include "it/EntropyCalculator.hpp"
+#include "it/SymmetricDelta.hpp"
+
+using namespace mist;
+
+using measure_ptr = it::BootstrapMeasure::measure_ptr;
+
+// 3 variables over 16 samples, column major, with a missing value
+io::DataMatrix::data_t bootstrap_data[3 * 16] = {
+  0, 1, 1, 0, 1, 1, 1, 0, 0, 0, 1, 0, 0, 1, 1, 0,
+  1, 0, 1, 0, 1, 1, 0, 1, 1, 1, -1, 0, 1, 0, 0, 1,
+  1, 0, 2, 0, 0, 0, 1, 1, 1, 0, 1, 1, 0, 2, 1, 1
+};
+
+BOOST_AUTO_TEST_CASE(BootstrapMeasure_poisson_weights)
+{
+  auto w = it::BootstrapMeasure::poisson_weights(1000, 20, 7);
+  BOOST_TEST(w.size() == 20000);
+  BOOST_TEST((w == it::BootstrapMeasure::poisson_weights(1000, 20, 7)));
+  BOOST_TEST((w != it::BootstrapMeasure::poisson_weights(1000, 20, 8)));
+  double sum = 0;
+  std::size_t zeros = 0;
+  for (auto x : w) {
+    sum += x;
+    zeros += (x == 0);
+  }
+  // mean 1, P(0) = 1/e
+  BOOST_TEST(std::abs(sum / w.size() - 1) < 0.05);
+  BOOST_TEST(std::abs((double)zeros / w.size() - std::exp(-1.0)) < 0.02);
+}
+
+BOOST_AUTO_TEST_CASE(BootstrapMeasure_names)
+{
+  io::DataMatrix matrix(bootstrap_data, 3, 16);
+  auto sd = measure_ptr(new it::SymmetricDelta());
+  it::BootstrapMeasure measure(sd, matrix.variables(), 10, 0.9, 1);
+  BOOST_TEST(measure.num_values() == 4);
+  BOOST_TEST(measure.header(2, false) ==
+             "v0,v1,SymmetricDelta_mean,SymmetricDelta_lo,SymmetricDelta_hi,"
+             "SymmetricDelta");
+  BOOST_TEST(measure.names(3, true).size() == sd->names(3, true).size() + 3);
+  BOOST_CHECK_THROW(measure.names(1, false), it::BootstrapMeasureException);
+  BOOST_CHECK_THROW(it::BootstrapMeasure(sd, matrix.variables(), 0, 0.9, 1),
+                    it::BootstrapMeasureException);
+  BOOST_CHECK_THROW(it::BootstrapMeasure(sd, matrix.variables(), 10, 1, 1),
+                    it::BootstrapMeasureException);
+}
+
+BOOST_AUTO_TEST_CASE(BootstrapMeasure_compute)
+{
+  io::DataMatrix matrix(bootstrap_data, 3, 16);
+  auto vars = matrix.variables();
+  it::EntropyCalculator calc(vars);
+  auto sd = measure_ptr(new it::SymmetricDelta());
+  std::size_t B = 5;
+  unsigned seed = 3;
+  it::BootstrapMeasure measure(sd, vars, B, 0.9, seed);
+  auto weights = it::BootstrapMeasure::poisson_weights(16, B, seed);
+
+  for (Variable::indexes tuple : { Variable::indexes{ 0, 1 },
+                                   Variable::indexes{ 0, 1, 2 } }) {
+    std::vector<it::Measure::result_type> values;
+    measure.replicate_values(calc, tuple, values);
+    BOOST_TEST(values.size() == 1);
+    BOOST_TEST(values[0].size() == B);
+
+    // a replicate is the measure on the data with each row repeated by its
+    // weight
+    for (std::size_t b = 0; b < B; b++) {
+      std::vector<io::DataMatrix::data_t> data;
+      std::size_t nrow = 0;
+      for (int row = 0; row < 16; row++) {
+        nrow += weights[row * B + b];
+      }
+      for (int col = 0; col < 3; col++) {
+        for (int row = 0; row < 16; row++) {
+          data.insert(data.end(), weights[row * B + b],
+                      bootstrap_data[col * 16 + row]);
+        }
+      }
+      io::DataMatrix resampled(data.data(), 3, nrow);
+      it::EntropyCalculator rcalc(resampled.variables());
+      auto expect = sd->compute(rcalc, tuple).back();
+      BOOST_TEST(std::abs(values[0][b] - expect) < 1e-12);
+    }
+
+    auto expect = sd->compute(calc, tuple);
+    auto res = measure.compute(calc, tuple);
+    auto nsub = expect.size() - 1;
+    BOOST_TEST(res.size() == nsub + 4);
+    for (std::size_t ii = 0; ii < nsub; ii++) {
+      BOOST_TEST(std::abs(res[ii] - expect[ii]) < 1e-12);
+    }
+    BOOST_TEST(std::abs(res.back() - expect.back()) < 1e-12);
+    auto sorted = values[0];
+    std::sort(sorted.begin(), sorted.end());
+    double mean = 0;
+    for (auto x : sorted) {
+      mean += x / B;
+    }
+    BOOST_TEST(std::abs(res[nsub] - mean) < 1e-12);
+    BOOST_TEST(res[nsub + 1] >= sorted.front());
+    BOOST_TEST(res[nsub + 1] <= res[nsub + 2]);
+    BOOST_TEST(res[nsub + 2] <= sorted.back());
+  }
+}
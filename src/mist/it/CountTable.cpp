@@ -0,0 +1,124 @@
+#include <cmath>
+#include <string>
+
+#include "it/CountTable.hpp"
+
+using namespace mist;
+using namespace mist::it;
+
+CountTable::CountTable() {}
+
+CountTable::CountTable(std::vector<std::size_t> const& bins)
+  : bins(bins)
+{
+  std::size_t size = 1;
+  for (auto b : bins) {
+    strides.push_back(size);
+    size *= b;
+  }
+  counts.assign(size, 0);
+}
+
+static std::vector<std::size_t>
+tuple_bins(Variable::tuple const& vars, CountTable::tuple_t const& tuple)
+{
+  std::vector<std::size_t> bins;
+  for (auto index : tuple) {
+    bins.push_back(vars[index].bins());
+  }
+  return bins;
+}
+
+CountTable::CountTable(Variable::tuple const& vars, tuple_t const& tuple)
+  : CountTable(tuple_bins(vars, tuple))
+{
+  add(vars, tuple);
+}
+
+template<int Sign>
+void
+CountTable::update(Variable::tuple const& vars, tuple_t const& tuple)
+{
+  if (tuple.size() != bins.size()) {
+    throw CountTableException("update",
+                              "Tuple size " + std::to_string(tuple.size()) +
+                                " does not match the table size " +
+                                std::to_string(bins.size()));
+  }
+  auto d = tuple.size();
+  auto nrow = vars[tuple[0]].size();
+  for (std::size_t row = 0; row < nrow; row++) {
+    std::size_t index = 0;
+    bool missing = false;
+    for (std::size_t ii = 0; ii < d; ii++) {
+      auto val = vars[tuple[ii]][row];
+      if (VARIABLE_MISSING_VAL(val)) {
+        missing = true;
+        break;
+      }
+      if (static_cast<std::size_t>(val) >= bins[ii]) {
+        throw CountTableException(
+          "update",
+          "Value " + std::to_string(val) + " of variable " +
+            std::to_string(tuple[ii]) + " is outside of the table bins [0," +
+            std::to_string(bins[ii]) + ")");
+      }
+      index += strides[ii] * val;
+    }
+    if (!missing) {
+      counts[index] += Sign;
+      _total += Sign;
+    }
+  }
+}
+
+void
+CountTable::add(Variable::tuple const& vars, tuple_t const& tuple)
+{
+  update<1>(vars, tuple);
+}
+
+void
+CountTable::remove(Variable::tuple const& vars, tuple_t const& tuple)
+{
+  update<-1>(vars, tuple);
+}
+
+// Same operations as Distribution::normalize and
+// EntropyCalculator::entropy_it_distribution, so the results are bitwise
+// identical to a full recount.
+entropy_type
+CountTable::entropy() const
+{
+  entropy_type entropy = 0.0;
+  if (!_total) {
+    return entropy;
+  }
+  double factor = 1.0 / _total;
+  for (auto count : counts) {
+    if (count) {
+      double prob = count;
+      prob *= factor;
+      entropy += prob * std::log2(prob);
+    }
+  }
+  return (entropy) ? -entropy : entropy;
+}
+
+std::size_t
+CountTable::total() const
+{
+  return _total;
+}
+
+std::size_t
+CountTable::size() const
+{
+  return counts.size();
+}
+
+CountTable::count_t
+CountTable::operator[](std::size_t index) const
+{
+  return counts[index];
+}
@@ -0,0 +1,66 @@
+#include <boost/test/unit_test.hpp>
+#include <random>
+
+#include "io/DataMatrix.hpp"
+#include "it/CountTable.hpp"
+#include "it/EntropyCalculator.hpp"
+
+using namespace mist;
+
+// column major, 3 variables with 3 bins and some missing values
+static io::DataMatrix
+make_data(std::size_t nrow, unsigned seed)
+{
+  std::mt19937 gen(seed);
+  std::vector<io::DataMatrix::data_t> data(3 * nrow);
+  for (auto& val : data) {
+    val = gen() % 3;
+    if (gen() % 10 == 0) {
+      val = -1;
+    }
+  }
+  // fix the bins at 3 for every column
+  data[0] = data[nrow] = data[2 * nrow] = 2;
+  return io::DataMatrix(data.data(), 3, nrow);
+}
+
+BOOST_AUTO_TEST_CASE(entropy_matches_calculator)
+{
+  auto data = make_data(50, 1);
+  auto vars = data.variables();
+  it::EntropyCalculator calc(vars);
+  for (auto tuple : std::vector<Variable::indexes>{ { 0 }, { 0, 2 }, { 0, 1, 2 } }) {
+    it::CountTable table(*vars, tuple);
+    BOOST_TEST(table.entropy() == calc.entropy(tuple));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(add_remove)
+{
+  auto a = make_data(40, 2);
+  auto b = make_data(25, 3);
+  auto va = a.variables();
+  auto vb = b.variables();
+  Variable::indexes tuple = { 0, 1, 2 };
+
+  it::CountTable table(*va, tuple);
+  it::CountTable only_b(*vb, tuple);
+  table.add(*vb, tuple);
+  table.remove(*va, tuple);
+
+  BOOST_TEST(table.total() == only_b.total());
+  for (std::size_t ii = 0; ii < table.size(); ii++) {
+    BOOST_TEST(table[ii] == only_b[ii]);
+  }
+  BOOST_TEST(table.entropy() == only_b.entropy());
+}
+
+BOOST_AUTO_TEST_CASE(value_out_of_bins)
+{
+  io::DataMatrix::data_t small[4] = { 0, 1, 0, 1 };
+  io::DataMatrix::data_t large[4] = { 0, 1, 2, 1 };
+  io::DataMatrix a(small, 1, 4);
+  io::DataMatrix b(large, 1, 4);
+  it::CountTable table(*a.variables(), { 0 });
+  BOOST_CHECK_THROW(table.add(*b.variables(), { 0 }), it::CountTableException);
+}
@@ -56,6 +56,9 @@ EntropyCalculator::init_caches(std::vector<cache_ptr_type> const& caches)
   if (num_caches >= 3) {
     this->cache3d = caches[2];
   }
+  if (num_caches >= 4) {
+    this->cache4d = caches[3];
+  }
 }
 
 entropy_type
@@ -108,6 +111,8 @@ EntropyCalculator::entropy(tuple_t const& tuple)
         return entropy_cache(tuple, this->cache2d);
       case 3:
         return entropy_cache(tuple, this->cache3d);
+      case 4:
+        return entropy_cache(tuple, this->cache4d);
       default:
         this->counter->count(*vars, tuple, dist);
         dist.normalize();
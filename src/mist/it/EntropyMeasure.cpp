@@ -40,6 +40,12 @@ EntropyMeasure::compute(EntropyCalculator& ecalc,
                         Entropy const& e,
                         result_type& result) const
 {
+  // the full joint entropy is the last of all sub-tuple entropies
+  if (e.size() == (1u << tuple.size()) - 1) {
+    result.resize(1);
+    result[0] = e.back();
+    return;
+  }
   compute(ecalc, tuple, result);
 }
 
@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "it/MarginalCountTable.hpp"
+
+using namespace mist;
+using namespace mist::it;
+
+// Sub-tuples of a d-tuple as position bitmasks in the it::d layout, by size
+// then lexicographic
+static std::vector<unsigned>
+sub_tuple_masks(int d)
+{
+  std::vector<unsigned> masks;
+  for (int k = 1; k <= d; k++) {
+    std::vector<bool> mask(d, false);
+    std::fill(mask.begin(), mask.begin() + k, true);
+    do {
+      unsigned bits = 0;
+      for (int ii = 0; ii < d; ii++) {
+        if (mask[ii]) {
+          bits |= 1u << ii;
+        }
+      }
+      masks.push_back(bits);
+    } while (std::prev_permutation(mask.begin(), mask.end()));
+  }
+  return masks;
+}
+
+static const std::vector<unsigned> masks_d[4] = { sub_tuple_masks(1),
+                                                  sub_tuple_masks(2),
+                                                  sub_tuple_masks(3),
+                                                  sub_tuple_masks(4) };
+
+void
+MarginalCountTable::reset(Variable::tuple const& variables,
+                          tuple_t const& tuple,
+                          std::size_t layers)
+{
+  if (tuple.size() < 1 || tuple.size() > 4) {
+    throw MarginalCountTableException("reset",
+                                      "Unsupported tuple size " +
+                                        std::to_string(tuple.size()) +
+                                        ", valid range [1,4]");
+  }
+  d = tuple.size();
+  cells = 1;
+  for (std::size_t ii = 0; ii < d; ii++) {
+    vars[ii] = &variables[tuple[ii]];
+    bins[ii] = vars[ii]->bins();
+    strides[ii] = cells;
+    cells *= bins[ii] + 1;
+  }
+  nlayers = layers;
+  counts.assign(cells * nlayers, 0);
+  if (map_bins.size() != d || !std::equal(map_bins.begin(), map_bins.end(), bins)) {
+    make_cell_map();
+  }
+}
+
+void
+MarginalCountTable::make_cell_map()
+{
+  map_bins.assign(bins, bins + d);
+  auto const& masks = masks_d[d - 1];
+  auto nsub = masks.size();
+  sub_size.resize(nsub);
+  cell_map.resize(nsub * cells);
+  for (std::size_t m = 0; m < nsub; m++) {
+    std::size_t sub_strides[4] = { 0, 0, 0, 0 };
+    std::size_t size = 1;
+    for (std::size_t ii = 0; ii < d; ii++) {
+      if (masks[m] & (1u << ii)) {
+        sub_strides[ii] = size;
+        size *= bins[ii];
+      }
+    }
+    sub_size[m] = size;
+    auto map = cell_map.data() + m * cells;
+    for (std::size_t cell = 0; cell < cells; cell++) {
+      int index = 0;
+      auto rest = cell;
+      for (std::size_t ii = 0; ii < d; ii++) {
+        auto v = rest % (bins[ii] + 1);
+        rest /= bins[ii] + 1;
+        if (!sub_strides[ii]) {
+          continue;
+        }
+        if (v == bins[ii]) {
+          index = -1;
+          break;
+        }
+        index += sub_strides[ii] * v;
+      }
+      map[cell] = index;
+    }
+  }
+}
+
+void
+MarginalCountTable::entropies(std::size_t layer, Entropy& e)
+{
+  auto nsub = sub_size.size();
+  e.resize(nsub);
+  auto table = counts.data() + layer;
+  for (std::size_t m = 0; m < nsub; m++) {
+    marginal.assign(sub_size[m], 0);
+    auto map = cell_map.data() + m * cells;
+    std::size_t total = 0;
+    for (std::size_t cell = 0; cell < cells; cell++) {
+      auto n = table[cell * nlayers];
+      if (n && map[cell] >= 0) {
+        marginal[map[cell]] += n;
+        total += n;
+      }
+    }
+    // same arithmetic as a normalized Distribution
+    entropy_type entropy = 0.0;
+    if (total) {
+      double scale = 1.0 / total;
+      for (auto n : marginal) {
+        double prob = n * scale;
+        entropy = (prob) ? entropy + prob * std::log2(prob) : entropy;
+      }
+    }
+    e[m] = (entropy) ? -entropy : entropy;
+  }
+}
@@ -0,0 +1,63 @@
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+
+#include "io/DataMatrix.hpp"
+#include "it/Entropy.hpp"
+#include "it/EntropyCalculator.hpp"
+#include "it/MarginalCountTable.hpp"
+
+using namespace mist;
+
+// 4 variables over 12 samples, column major, with missing values
+io::DataMatrix::data_t marginal_data[4 * 12] = {
+  0, 1, 1, 0, 1, 1, 1, 0, 0, -1, 1, 0,
+  0, 1, 1, 0, 1, 0, 1, 0, 1, 1, 0, 1,
+  1, 1, 0, 2, 1, 0, 0, 1, -1, 0, 1, 2,
+  0, 0, 1, 1, 1, 0, 1, 1, 0, 0, 1, 1
+};
+
+BOOST_AUTO_TEST_CASE(MarginalCountTable_entropies)
+{
+  io::DataMatrix matrix(marginal_data, 4, 12);
+  auto vars = matrix.variables();
+  it::EntropyCalculator calc(vars);
+  it::MarginalCountTable table;
+
+  Variable::indexes tuple{ 0, 1, 2, 3 };
+  table.reset(*vars, tuple, 2);
+  BOOST_TEST(table.layers() == 2);
+  // layer 1 counts each row twice
+  table.count([](std::size_t row, it::MarginalCountTable::count_t* counts) {
+    counts[0] += 1;
+    counts[1] += 2;
+  });
+  it::Entropy e0, e1;
+  table.entropies(0, e0);
+  table.entropies(1, e1);
+  BOOST_TEST(e0.size() == (std::size_t)it::d4::size);
+
+  std::vector<Variable::indexes> subs = {
+    { 0 }, { 1 }, { 2 }, { 3 }, { 0, 1 }, { 0, 2 }, { 0, 3 }, { 1, 2 },
+    { 1, 3 }, { 2, 3 }, { 0, 1, 2 }, { 0, 1, 3 }, { 0, 2, 3 }, { 1, 2, 3 },
+    { 0, 1, 2, 3 }
+  };
+  for (std::size_t ii = 0; ii < subs.size(); ii++) {
+    auto expect = calc.entropy(subs[ii]);
+    BOOST_TEST(std::abs(e0[ii] - expect) < 1e-12);
+    BOOST_TEST(std::abs(e1[ii] - expect) < 1e-12);
+  }
+
+  // smaller tuple reuses the buffers
+  table.reset(*vars, { 2, 0 }, 1);
+  table.count([](std::size_t row, it::MarginalCountTable::count_t* counts) {
+    ++counts[0];
+  });
+  table.entropies(0, e0);
+  BOOST_TEST(e0.size() == 3);
+  BOOST_TEST(std::abs(e0[0] - calc.entropy({ 2 })) < 1e-12);
+  BOOST_TEST(std::abs(e0[1] - calc.entropy({ 0 })) < 1e-12);
+  BOOST_TEST(std::abs(e0[2] - calc.entropy({ 2, 0 })) < 1e-12);
+
+  BOOST_CHECK_THROW(table.reset(*vars, {}, 1), it::MarginalCountTableException);
+}
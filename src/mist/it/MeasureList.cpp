@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "it/MeasureList.hpp"
+
+using namespace mist;
+using namespace mist::it;
+
+MeasureList::MeasureList(std::vector<measure_ptr> const& measures)
+  : measures(measures)
+{
+  if (measures.empty()) {
+    throw MeasureListException("MeasureList", "No measures given");
+  }
+  for (auto const& m : measures) {
+    full = full || m->full_entropy();
+    nvalues += m->num_values();
+  }
+  // tuple columns once, then sub calculations, then final values
+  for (int d = 1; d <= 4; d++) {
+    std::vector<std::string> subs;
+    std::vector<std::string> values;
+    try {
+      for (auto const& m : measures) {
+        auto const& all = m->names(d, true);
+        auto n = m->num_values();
+        subs.insert(subs.end(), all.begin() + d, all.end() - n);
+        values.insert(values.end(), all.end() - n, all.end());
+      }
+    } catch (std::exception const& e) {
+      continue;
+    }
+    auto& brief = names_d[d - 1];
+    auto& full_names = names_d_full[d - 1];
+    for (int ii = 0; ii < d; ii++) {
+      brief.push_back("v" + std::to_string(ii));
+    }
+    full_names = brief;
+    full_names.insert(full_names.end(), subs.begin(), subs.end());
+    full_names.insert(full_names.end(), values.begin(), values.end());
+    brief.insert(brief.end(), values.begin(), values.end());
+  }
+}
+
+// Per-thread buffers for the member results, the measure is shared by all
+// Workers
+static thread_local std::vector<MeasureList::result_type> member_results;
+
+void
+MeasureList::gather(std::vector<result_type> const& results,
+                    result_type& result) const
+{
+  std::size_t size = 0;
+  for (auto const& r : results) {
+    size += r.size();
+  }
+  result.resize(size);
+  auto out = result.begin();
+  auto nmeasures = measures.size();
+  for (std::size_t ii = 0; ii < nmeasures; ii++) {
+    auto const& r = results[ii];
+    out = std::copy(r.begin(), r.end() - measures[ii]->num_values(), out);
+  }
+  for (std::size_t ii = 0; ii < nmeasures; ii++) {
+    auto const& r = results[ii];
+    out = std::copy(r.end() - measures[ii]->num_values(), r.end(), out);
+  }
+}
+
+MeasureList::result_type
+MeasureList::compute(EntropyCalculator& ecalc,
+                     Variable::indexes const& tuple) const
+{
+  result_type result;
+  compute(ecalc, tuple, result);
+  return result;
+}
+
+void
+MeasureList::compute(EntropyCalculator& ecalc,
+                     Variable::indexes const& tuple,
+                     result_type& result) const
+{
+  auto& results = member_results;
+  results.resize(measures.size());
+  for (std::size_t ii = 0; ii < measures.size(); ii++) {
+    measures[ii]->compute(ecalc, tuple, results[ii]);
+  }
+  gather(results, result);
+}
+
+MeasureList::result_type
+MeasureList::compute(EntropyCalculator& ecalc,
+                     Variable::indexes const& tuple,
+                     Entropy const& e) const
+{
+  result_type result;
+  compute(ecalc, tuple, e, result);
+  return result;
+}
+
+void
+MeasureList::compute(EntropyCalculator& ecalc,
+                     Variable::indexes const& tuple,
+                     Entropy const& e,
+                     result_type& result) const
+{
+  auto& results = member_results;
+  results.resize(measures.size());
+  for (std::size_t ii = 0; ii < measures.size(); ii++) {
+    measures[ii]->compute(ecalc, tuple, e, results[ii]);
+  }
+  gather(results, result);
+}
+
+MeasureList::data_t
+MeasureList::upper_bound(Entropy const& partial, int d) const
+{
+  return measures.back()->upper_bound(partial, d);
+}
+
+std::vector<std::string> const&
+MeasureList::names(int d, bool full_output) const
+{
+  if (d < 1 || d > 4 || names_d[d - 1].empty()) {
+    throw MeasureListException("names",
+                               "Unsupported tuple size " + std::to_string(d) +
+                                 " for all measures in the list");
+  }
+  return (full_output) ? names_d_full[d - 1] : names_d[d - 1];
+}
+
+std::string
+MeasureList::header(int d, bool full_output) const
+{
+  auto n = names(d, full_output);
+  std::string h = n.front();
+  auto N = n.size();
+  for (std::size_t ii = 1; ii < N; ii++) {
+    h += "," + n[ii];
+  }
+  return h;
+}
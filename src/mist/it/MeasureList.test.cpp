@@ -0,0 +1,64 @@
+#include <boost/test/unit_test.hpp>
+
+#include "io/DataMatrix.hpp"
+#include "it/Entropy.hpp"
+#include "it/EntropyCalculator.hpp"
+#include "it/EntropyMeasure.hpp"
+#include "it/MeasureList.hpp"
+#include "it/SymmetricDelta.hpp"
+
+using namespace mist;
+
+io::DataMatrix::data_t test_data[4 * 12] = {
+  0, 1, 1, 0, 1, 1, 1, 0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 0, 1, 0, 1, 1, 0, 1,
+  1, 1, 0, 0, 1, 0, 0, 1, 1, 0, 1, 0, 0, 0, 1, 1, 1, 0, 1, 1, 0, 0, 1, 1
+};
+io::DataMatrix test_matrix(test_data, 4, 12);
+
+using measure_ptr = it::MeasureList::measure_ptr;
+
+BOOST_AUTO_TEST_CASE(MeasureList_names)
+{
+  auto sd = measure_ptr(new it::SymmetricDelta());
+  auto je = measure_ptr(new it::EntropyMeasure());
+  it::MeasureList list({ sd, je });
+  BOOST_TEST(list.full_entropy());
+  BOOST_TEST(list.num_values() == 2);
+  BOOST_TEST(list.header(3, false) == "v0,v1,v2,SymmetricDelta,entropy012");
+  auto const& full = list.names(3, true);
+  BOOST_TEST(full.size() == sd->names(3, true).size() + 1);
+  BOOST_TEST(full[3] == "entropy0");
+  BOOST_TEST(full.back() == "entropy012");
+  // SymmetricDelta has no single variable form
+  BOOST_CHECK_THROW(list.names(1, false), it::MeasureListException);
+}
+
+BOOST_AUTO_TEST_CASE(MeasureList_compute)
+{
+  it::EntropyCalculator calc(
+    it::EntropyCalculator::variables_ptr(test_matrix.variables()));
+  auto sd = measure_ptr(new it::SymmetricDelta());
+  auto je = measure_ptr(new it::EntropyMeasure());
+  it::MeasureList list({ sd, je });
+
+  for (Variable::indexes tuple : { Variable::indexes{ 0, 1, 2 },
+                                   Variable::indexes{ 0, 1, 2, 3 } }) {
+    auto expect_sd = sd->compute(calc, tuple);
+    auto expect_je = je->compute(calc, tuple);
+    auto res = list.compute(calc, tuple);
+    BOOST_TEST(res.size() == expect_sd.size() + expect_je.size());
+    BOOST_TEST(res[res.size() - 2] == expect_sd.back());
+    BOOST_TEST(res.back() == expect_je.back());
+
+    // from precomputed entropies, as given by the traversals
+    it::Entropy e;
+    if (tuple.size() == 3) {
+      e.assign(expect_sd.begin(), expect_sd.begin() + (int)it::d3::size);
+    } else {
+      e.assign(expect_sd.begin(), expect_sd.begin() + (int)it::d4::size);
+    }
+    it::Measure::result_type res_e;
+    list.compute(calc, tuple, e, res_e);
+    BOOST_TEST(res_e == res);
+  }
+}
@@ -0,0 +1,20 @@
+#include "it/Screen.hpp"
+
+using namespace mist;
+using namespace mist::it;
+
+bool
+MutualInformationScreen::pass(entropy_type e0,
+                              entropy_type e1,
+                              entropy_type e01) const
+{
+  return (e0 + e1 - e01) >= threshold;
+}
+
+bool
+JointEntropyScreen::pass(entropy_type e0,
+                         entropy_type e1,
+                         entropy_type e01) const
+{
+  return e01 >= threshold;
+}
@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "it/StratifiedMeasure.hpp"
+
+using namespace mist;
+using namespace mist::it;
+
+StratifiedMeasure::StratifiedMeasure(measure_ptr const& measure,
+                                     variables_ptr const& vars,
+                                     Variable const& strata,
+                                     bool differences,
+                                     weights_ptr const& weights)
+  : measure(measure)
+  , vars(vars)
+  , strata(strata)
+  , nstrata(strata.bins())
+  , differences(differences)
+  , weights(weights)
+{
+  if (!vars->empty() && vars->front().size() != strata.size()) {
+    throw StratifiedMeasureException(
+      "StratifiedMeasure",
+      "Strata has " + std::to_string(strata.size()) +
+        " samples, the variables have " +
+        std::to_string(vars->front().size()));
+  }
+  if (differences && nstrata < 2) {
+    throw StratifiedMeasureException(
+      "StratifiedMeasure", "Differences need at least two strata.");
+  }
+  auto n = measure->num_values();
+  nvalues = nstrata * n + ((differences) ? (nstrata - 1) * n : 0);
+  // tuple columns once, then the sub calculations and final values of each
+  // stratum, then the differences
+  for (int d = 1; d <= 4; d++) {
+    std::vector<std::string> subs;
+    std::vector<std::string> values;
+    std::vector<std::string> diffs;
+    try {
+      auto const& all = measure->names(d, true);
+      for (std::size_t s = 0; s < nstrata; s++) {
+        auto suffix = "_s" + std::to_string(s);
+        for (auto it = all.begin() + d; it != all.end() - n; it++) {
+          subs.push_back(*it + suffix);
+        }
+        for (auto it = all.end() - n; it != all.end(); it++) {
+          values.push_back(*it + suffix);
+          if (differences && s) {
+            diffs.push_back(*it + suffix + "-s0");
+          }
+        }
+      }
+    } catch (std::exception const& e) {
+      continue;
+    }
+    auto& brief = names_d[d - 1];
+    auto& full_names = names_d_full[d - 1];
+    for (int ii = 0; ii < d; ii++) {
+      brief.push_back("v" + std::to_string(ii));
+    }
+    brief.insert(brief.end(), values.begin(), values.end());
+    brief.insert(brief.end(), diffs.begin(), diffs.end());
+    full_names = brief;
+    full_names.insert(full_names.begin() + d, subs.begin(), subs.end());
+  }
+}
+
+// Per-thread buffers, the measure is shared by all Workers
+static thread_local MarginalCountTable table;
+static thread_local std::vector<Entropy> entropy_buffer;
+static thread_local std::vector<Measure::result_type> stratum_results;
+
+void
+StratifiedMeasure::stratum_entropies(Variable::indexes const& tuple,
+                                     std::vector<Entropy>& entropies) const
+{
+  // one layer per stratum
+  table.reset(*vars, tuple, nstrata);
+  auto labels = strata.begin();
+  if (weights) {
+    auto w = weights->data();
+    table.count([labels, w](std::size_t row, MarginalCountTable::count_t* counts) {
+      auto label = labels[row];
+      if (!VARIABLE_MISSING_VAL(label)) {
+        counts[label] += w[row];
+      }
+    });
+  } else {
+    table.count([labels](std::size_t row, MarginalCountTable::count_t* counts) {
+      auto label = labels[row];
+      if (!VARIABLE_MISSING_VAL(label)) {
+        ++counts[label];
+      }
+    });
+  }
+  entropies.resize(nstrata);
+  for (std::size_t s = 0; s < nstrata; s++) {
+    table.entropies(s, entropies[s]);
+  }
+}
+
+StratifiedMeasure::result_type
+StratifiedMeasure::compute(EntropyCalculator& ecalc,
+                           Variable::indexes const& tuple) const
+{
+  result_type result;
+  compute(ecalc, tuple, result);
+  return result;
+}
+
+void
+StratifiedMeasure::compute(EntropyCalculator& ecalc,
+                           Variable::indexes const& tuple,
+                           result_type& result) const
+{
+  auto& entropies = entropy_buffer;
+  stratum_entropies(tuple, entropies);
+  auto& results = stratum_results;
+  results.resize(nstrata);
+  std::size_t size = 0;
+  for (std::size_t s = 0; s < nstrata; s++) {
+    measure->compute(ecalc, tuple, entropies[s], results[s]);
+    size += results[s].size();
+  }
+  auto n = measure->num_values();
+  if (differences) {
+    size += (nstrata - 1) * n;
+  }
+  result.resize(size);
+  auto out = result.begin();
+  for (auto const& r : results) {
+    out = std::copy(r.begin(), r.end() - n, out);
+  }
+  for (std::size_t s = 0; s < nstrata; s++) {
+    auto const& r = results[s];
+    out = std::copy(r.end() - n, r.end(), out);
+  }
+  if (differences) {
+    auto const& r0 = results.front();
+    for (std::size_t s = 1; s < nstrata; s++) {
+      auto const& r = results[s];
+      for (std::size_t ii = 0; ii < n; ii++) {
+        *out++ = r[r.size() - n + ii] - r0[r0.size() - n + ii];
+      }
+    }
+  }
+}
+
+StratifiedMeasure::result_type
+StratifiedMeasure::compute(EntropyCalculator& ecalc,
+                           Variable::indexes const& tuple,
+                           Entropy const& e) const
+{
+  return compute(ecalc, tuple);
+}
+
+void
+StratifiedMeasure::compute(EntropyCalculator& ecalc,
+                           Variable::indexes const& tuple,
+                           Entropy const& e,
+                           result_type& result) const
+{
+  compute(ecalc, tuple, result);
+}
+
+std::vector<std::string> const&
+StratifiedMeasure::names(int d, bool full_output) const
+{
+  if (d < 1 || d > 4 || names_d[d - 1].empty()) {
+    throw StratifiedMeasureException("names",
+                                     "Unsupported tuple size " +
+                                       std::to_string(d));
+  }
+  return (full_output) ? names_d_full[d - 1] : names_d[d - 1];
+}
+
+std::string
+StratifiedMeasure::header(int d, bool full_output) const
+{
+  auto n = names(d, full_output);
+  std::string h = n.front();
+  auto N = n.size();
+  for (std::size_t ii = 1; ii < N; ii++) {
+    h += "," + n[ii];
+  }
+  return h;
+}
@@ -0,0 +1,121 @@
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+
+#include "io/DataMatrix.hpp"
+#include "it/Entropy.hpp"
+#include "it/EntropyCalculator.hpp"
+#include "it/EntropyMeasure.hpp"
+#include "it/StratifiedMeasure.hpp"
+#include "it/SymmetricDelta.hpp"
+
+using namespace mist;
+
+using measure_ptr = it::StratifiedMeasure::measure_ptr;
+
+// 4 variables and a strata column over 16 samples, column major, with missing
+// values and one sample without a stratum
+io::DataMatrix::data_t strata_data[5 * 16] = {
+  0, 1, 1, 0, 1, 1, 1, 0, 0, 0, 1, 0, 0, 1, 1, 0,
+  1, 0, 1, 0, 1, 1, 0, 1, 1, 1, -1, 0, 1, 0, 0, 1,
+  1, 0, 2, 0, 0, 0, 1, 1, 1, 0, 1, 1, 0, 2, 1, 1,
+  0, 0, 1, 1, 0, 1, 0, 1, 1, 0, 0, 1, 1, 1, 0, 1,
+  0, 1, 0, 1, 0, 1, 0, 1, 1, 1, 0, 0, 1, 0, -1, 1
+};
+
+// Separate data matrix with the samples of one stratum
+static io::DataMatrix::variables_ptr
+stratum_variables(int stratum, std::vector<io::DataMatrix>& keep)
+{
+  std::vector<io::DataMatrix::data_t> data;
+  std::size_t nrow = 0;
+  for (int row = 0; row < 16; row++) {
+    nrow += (strata_data[4 * 16 + row] == stratum);
+  }
+  for (int col = 0; col < 4; col++) {
+    for (int row = 0; row < 16; row++) {
+      if (strata_data[4 * 16 + row] == stratum) {
+        data.push_back(strata_data[col * 16 + row]);
+      }
+    }
+  }
+  keep.emplace_back(data.data(), 4, nrow);
+  return keep.back().variables();
+}
+
+BOOST_AUTO_TEST_CASE(StratifiedMeasure_names)
+{
+  io::DataMatrix matrix(strata_data, 5, 16);
+  matrix.set_strata(4);
+  auto sd = measure_ptr(new it::SymmetricDelta());
+  it::StratifiedMeasure measure(sd, matrix.variables(), matrix.get_strata(), true);
+  BOOST_TEST(measure.num_strata() == 2);
+  BOOST_TEST(measure.num_values() == 3);
+  BOOST_TEST(measure.header(2, false) ==
+             "v0,v1,SymmetricDelta_s0,SymmetricDelta_s1,SymmetricDelta_s1-s0");
+  auto const& full = measure.names(2, true);
+  BOOST_TEST(full.size() == 2 + 2 * 3 + 3);
+  BOOST_TEST(full[2] == "entropy0_s0");
+  BOOST_TEST(full[5] == "entropy0_s1");
+  BOOST_CHECK_THROW(measure.names(1, false), it::StratifiedMeasureException);
+
+  it::StratifiedMeasure single(sd, matrix.variables(), matrix.get_strata(), false);
+  BOOST_TEST(single.num_values() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(StratifiedMeasure_compute)
+{
+  io::DataMatrix matrix(strata_data, 5, 16);
+  matrix.set_strata(4);
+  auto vars = matrix.variables();
+  it::EntropyCalculator calc(vars);
+  auto sd = measure_ptr(new it::SymmetricDelta());
+  it::StratifiedMeasure measure(sd, vars, matrix.get_strata(), true);
+
+  std::vector<io::DataMatrix> keep;
+  keep.reserve(2);
+  it::EntropyCalculator calc0(stratum_variables(0, keep));
+  it::EntropyCalculator calc1(stratum_variables(1, keep));
+
+  for (Variable::indexes tuple : { Variable::indexes{ 0, 1 },
+                                   Variable::indexes{ 1, 2, 3 },
+                                   Variable::indexes{ 0, 1, 2, 3 } }) {
+    auto expect0 = sd->compute(calc0, tuple);
+    auto expect1 = sd->compute(calc1, tuple);
+    auto res = measure.compute(calc, tuple);
+    auto nsub = expect0.size() - 1;
+    BOOST_TEST(res.size() == 2 * expect0.size() + 1);
+    for (std::size_t ii = 0; ii < nsub; ii++) {
+      BOOST_TEST(std::abs(res[ii] - expect0[ii]) < 1e-12);
+      BOOST_TEST(std::abs(res[nsub + ii] - expect1[ii]) < 1e-12);
+    }
+    auto n = res.size();
+    BOOST_TEST(std::abs(res[n - 3] - expect0.back()) < 1e-12);
+    BOOST_TEST(std::abs(res[n - 2] - expect1.back()) < 1e-12);
+    BOOST_TEST(res[n - 1] == res[n - 2] - res[n - 3]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(StratifiedMeasure_joint_entropy)
+{
+  io::DataMatrix matrix(strata_data, 5, 16);
+  matrix.set_strata(4);
+  auto vars = matrix.variables();
+  it::EntropyCalculator calc(vars);
+  auto je = measure_ptr(new it::EntropyMeasure());
+  it::StratifiedMeasure measure(je, vars, matrix.get_strata(), false);
+
+  std::vector<io::DataMatrix> keep;
+  keep.reserve(2);
+  it::EntropyCalculator calc0(stratum_variables(0, keep));
+  it::EntropyCalculator calc1(stratum_variables(1, keep));
+
+  for (Variable::indexes tuple : { Variable::indexes{ 1 },
+                                   Variable::indexes{ 0, 2 },
+                                   Variable::indexes{ 0, 1, 3 } }) {
+    auto res = measure.compute(calc, tuple);
+    BOOST_TEST(res.size() == 2);
+    BOOST_TEST(std::abs(res[0] - calc0.entropy(tuple)) < 1e-12);
+    BOOST_TEST(std::abs(res[1] - calc1.entropy(tuple)) < 1e-12);
+  }
+}
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <stdexcept>
 
 #include "it/SymmetricDelta.hpp"
@@ -209,14 +212,16 @@ compute_4d(EntropyCalculator& ecalc,
   auto e12 = entropy[(int)d4::e12];
   auto e012 = entropy[(int)d4::e012];
 
-  auto e3 = ecalc.entropy({ vars[3] });
-  auto e03 = ecalc.entropy({ vars[0], vars[3] });
-  auto e13 = ecalc.entropy({ vars[1], vars[3] });
-  auto e23 = ecalc.entropy({ vars[2], vars[3] });
-  auto e013 = ecalc.entropy({ vars[0], vars[1], vars[3] });
-  auto e023 = ecalc.entropy({ vars[0], vars[2], vars[3] });
-  auto e123 = ecalc.entropy({ vars[1], vars[2], vars[3] });
-  auto e0123 = ecalc.entropy({ vars[0], vars[1], vars[2], vars[3] });
+  // the traversals give all entropies, only count what is missing
+  bool all = (entropy.size() == (std::size_t)d4::size);
+  auto e3 = (all) ? entropy[(int)d4::e3] : ecalc.entropy({ vars[3] });
+  auto e03 = (all) ? entropy[(int)d4::e03] : ecalc.entropy({ vars[0], vars[3] });
+  auto e13 = (all) ? entropy[(int)d4::e13] : ecalc.entropy({ vars[1], vars[3] });
+  auto e23 = (all) ? entropy[(int)d4::e23] : ecalc.entropy({ vars[2], vars[3] });
+  auto e013 = (all) ? entropy[(int)d4::e013] : ecalc.entropy({ vars[0], vars[1], vars[3] });
+  auto e023 = (all) ? entropy[(int)d4::e023] : ecalc.entropy({ vars[0], vars[2], vars[3] });
+  auto e123 = (all) ? entropy[(int)d4::e123] : ecalc.entropy({ vars[1], vars[2], vars[3] });
+  auto e0123 = (all) ? entropy[(int)d4::e0123] : ecalc.entropy({ vars[0], vars[1], vars[2], vars[3] });
 
   auto I012 = e0 + e1 + e2 - e01 - e02 - e12 + e012;
   auto I013 = e0 + e1 + e3 - e01 - e03 - e13 + e013;
@@ -327,6 +332,108 @@ SymmetricDelta::compute(EntropyCalculator& ecalc,
   }
 }
 
+// Slack on the joint entropy interval to absorb rounding in the entropy sums
+#define BOUND_TOLERANCE 1e-9
+
+// The full joint entropy x of a 3-tuple lies in
+//   max(e01, e02, e12) <= x <= min(e01 + e2, e02 + e1, e12 + e0)
+// and the measure is the cubic -(x + a0)(x + a1)(x + a2) in x, so its
+// maximum over the interval is found exactly at the end points or the
+// turning points.
+static SymmetricDelta::data_t
+upper_bound_3d(Entropy const& e)
+{
+  auto e0 = e[(int)d3::e0];
+  auto e1 = e[(int)d3::e1];
+  auto e2 = e[(int)d3::e2];
+  auto e01 = e[(int)d3::e01];
+  auto e02 = e[(int)d3::e02];
+  auto e12 = e[(int)d3::e12];
+  auto lo = std::max({ e01, e02, e12 }) - BOUND_TOLERANCE;
+  auto hi = std::min({ e01 + e2, e02 + e1, e12 + e0 }) + BOUND_TOLERANCE;
+  hi = std::max(lo, hi);
+
+  // D_k = a_k + x
+  auto a0 = e0 - e01 - e02;
+  auto a1 = e1 - e01 - e12;
+  auto a2 = e2 - e02 - e12;
+  auto value = [a0, a1, a2](double x) { return -(x + a0) * (x + a1) * (x + a2); };
+  auto best = std::max(value(lo), value(hi));
+
+  // turning points: 3x^2 + 2(a0+a1+a2)x + (a0a1+a0a2+a1a2) = 0
+  double b = 2 * (a0 + a1 + a2);
+  double c = a0 * a1 + a0 * a2 + a1 * a2;
+  double disc = b * b - 12 * c;
+  if (disc >= 0) {
+    double root = std::sqrt(disc);
+    for (double x : { (-b - root) / 6, (-b + root) / 6 }) {
+      if (x > lo && x < hi) {
+        best = std::max(best, value(x));
+      }
+    }
+  }
+  return best;
+}
+
+// The full joint entropy x of a 4-tuple is bounded below by every 3-subset
+// and above by every split into disjoint parts. The measure is the product
+// of the four factors D_k = b_k - x, bounded by interval multiplication.
+static SymmetricDelta::data_t
+upper_bound_4d(Entropy const& e)
+{
+  auto e0 = e[(int)d4::e0];
+  auto e1 = e[(int)d4::e1];
+  auto e2 = e[(int)d4::e2];
+  auto e3 = e[(int)d4::e3];
+  auto e01 = e[(int)d4::e01];
+  auto e02 = e[(int)d4::e02];
+  auto e03 = e[(int)d4::e03];
+  auto e12 = e[(int)d4::e12];
+  auto e13 = e[(int)d4::e13];
+  auto e23 = e[(int)d4::e23];
+  auto e012 = e[(int)d4::e012];
+  auto e013 = e[(int)d4::e013];
+  auto e023 = e[(int)d4::e023];
+  auto e123 = e[(int)d4::e123];
+  auto lo = std::max({ e012, e013, e023, e123 }) - BOUND_TOLERANCE;
+  auto hi = std::min({ e012 + e3, e013 + e2, e023 + e1, e123 + e0,
+                       e01 + e23, e02 + e13, e03 + e12 }) + BOUND_TOLERANCE;
+  hi = std::max(lo, hi);
+
+  auto I012 = e0 + e1 + e2 - e01 - e02 - e12 + e012;
+  auto I013 = e0 + e1 + e3 - e01 - e03 - e13 + e013;
+  auto I023 = e0 + e2 + e3 - e02 - e03 - e23 + e023;
+  auto I123 = e1 + e2 + e3 - e12 - e13 - e23 + e123;
+  // I0123 = S - x
+  auto S = e0 + e1 + e2 + e3
+         - e01 - e02 - e03 - e12 - e13 - e23
+         + e012 + e013 + e023 + e123;
+
+  double pmin = 1;
+  double pmax = 1;
+  for (auto I : { I123, I023, I013, I012 }) {
+    double fmin = S - I - hi;
+    double fmax = S - I - lo;
+    double p[4] = { pmin * fmin, pmin * fmax, pmax * fmin, pmax * fmax };
+    pmin = *std::min_element(p, p + 4);
+    pmax = *std::max_element(p, p + 4);
+  }
+  return pmax;
+}
+
+SymmetricDelta::data_t
+SymmetricDelta::upper_bound(Entropy const& partial, int d) const
+{
+  switch (d) {
+    case 3:
+      return upper_bound_3d(partial);
+    case 4:
+      return upper_bound_4d(partial);
+    default:
+      return std::numeric_limits<data_t>::infinity();
+  }
+}
+
 const std::vector<std::string> names_d2 = {"v0","v1","SymmetricDelta"};
 const std::vector<std::string> names_d3 = {"v0","v1","v2","SymmetricDelta"};
 const std::vector<std::string> names_d4 = {"v0","v1","v2","v3","SymmetricDelta"};
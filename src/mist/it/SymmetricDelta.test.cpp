@@ -106,3 +106,36 @@ BOOST_AUTO_TEST_CASE(SymmetricDelta_compute_completion,
   sym.compute(ec, Variable::indexes({ 0, 1 }), ee, res);
   BOOST_TEST(res.back() == I01);
 }
+
+BOOST_AUTO_TEST_CASE(SymmetricDelta_upper_bound)
+{
+  it::SymmetricDelta sym;
+  it::Entropy e = { e0, e1, e2, e01, e02, e12, e012 };
+  auto bound = sym.upper_bound(e, 3);
+  BOOST_TEST(bound >= DD);
+  // the full joint entropy is ignored
+  e.back() = 0;
+  BOOST_TEST(sym.upper_bound(e, 3) == bound);
+  // no bound for pairs
+  BOOST_TEST(sym.upper_bound({ e0, e1, e01 }, 2) ==
+             std::numeric_limits<double>::infinity());
+}
+
+BOOST_AUTO_TEST_CASE(SymmetricDelta_upper_bound_4d)
+{
+  io::DataMatrix::data_t data[4 * 12] = { 0, 1, 1, 0, 1, 1, 1, 0, 0, 0, 1, 0,
+                                          0, 1, 1, 0, 1, 0, 1, 0, 1, 1, 0, 1,
+                                          1, 1, 0, 0, 1, 0, 0, 1, 1, 0, 1, 0,
+                                          0, 0, 1, 1, 1, 0, 1, 1, 0, 0, 1, 1 };
+  io::DataMatrix matrix(data, 4, 12);
+  it::EntropyCalculator calc(
+    it::EntropyCalculator::variables_ptr(matrix.variables()));
+  it::SymmetricDelta sym;
+  Variable::indexes tuple = { 0, 1, 2, 3 };
+  auto res = sym.compute(calc, tuple);
+  using sub4 = it::SymmetricDelta::sub_calc_4d;
+  // sub calculations hold the entropies in the it::d4 layout
+  it::Entropy e(res.begin() + (int)sub4::entropy0,
+                res.begin() + (int)sub4::entropy0123 + 1);
+  BOOST_TEST(sym.upper_bound(e, 4) >= res.back());
+}
@@ -11,26 +11,39 @@ using namespace mist::it;
 // Unrolled count functions are *much* faster.
 // Functions operating on a tuple are on performance critical paths
 //
+// Weighted functions add the row weight instead of one.
+//
+template<bool Weighted>
+static inline void
+add(Distribution::Data& cell, VectorCounter::weight_t const* w, std::size_t jj)
+{
+  cell += (Weighted) ? w[jj] : 1;
+}
+
+template<bool Weighted>
 static void
 count1d(std::size_t varlen,
         Variable::tuple const& vars,
         Variable::indexes const& indexes,
-        Distribution& dist)
+        Distribution& dist,
+        VectorCounter::weight_t const* w)
 {
   auto b0 = vars[indexes[0]].bins();
   for (std::size_t jj = 0; jj < varlen; jj++) {
     auto v0 = vars[indexes[0]][jj];
     if (!VARIABLE_MISSING_VAL(v0)) {
-      ++dist(v0, b0);
+      add<Weighted>(dist(v0, b0), w, jj);
     }
   }
 }
 
+template<bool Weighted>
 static void
 count2d(std::size_t varlen,
         Variable::tuple const& vars,
         Variable::indexes const& indexes,
-        Distribution& dist)
+        Distribution& dist,
+        VectorCounter::weight_t const* w)
 {
   auto b0 = vars[indexes[0]].bins();
   auto b1 = vars[indexes[1]].bins();
@@ -38,16 +51,18 @@ count2d(std::size_t varlen,
     auto v0 = vars[indexes[0]][jj];
     auto v1 = vars[indexes[1]][jj];
     if (!VARIABLE_MISSING_VAL(v0) && !VARIABLE_MISSING_VAL(v1)) {
-      ++dist(v0, v1, b0, b1);
+      add<Weighted>(dist(v0, v1, b0, b1), w, jj);
     }
   }
 }
 
+template<bool Weighted>
 static void
 count3d(std::size_t varlen,
         Variable::tuple const& vars,
         Variable::indexes const& indexes,
-        Distribution& dist)
+        Distribution& dist,
+        VectorCounter::weight_t const* w)
 {
   auto b0 = vars[indexes[0]].bins();
   auto b1 = vars[indexes[1]].bins();
@@ -58,16 +73,18 @@ count3d(std::size_t varlen,
     auto v2 = vars[indexes[2]][jj];
     if (!VARIABLE_MISSING_VAL(v0) && !VARIABLE_MISSING_VAL(v1) &&
         !VARIABLE_MISSING_VAL(v2)) {
-      ++dist(v0, v1, v2, b0, b1, b2);
+      add<Weighted>(dist(v0, v1, v2, b0, b1, b2), w, jj);
     }
   }
 }
 
+template<bool Weighted>
 static void
 count4d(std::size_t varlen,
         Variable::tuple const& vars,
         Variable::indexes const& indexes,
-        Distribution& dist)
+        Distribution& dist,
+        VectorCounter::weight_t const* w)
 {
   auto b0 = vars[indexes[0]].bins();
   auto b1 = vars[indexes[1]].bins();
@@ -80,7 +97,7 @@ count4d(std::size_t varlen,
     auto v3 = vars[indexes[3]][jj];
     if (!VARIABLE_MISSING_VAL(v0) && !VARIABLE_MISSING_VAL(v1) &&
         !VARIABLE_MISSING_VAL(v2) && !VARIABLE_MISSING_VAL(v3)) {
-      ++dist(v0, v1, v2, v3, b0, b1, b2, b3);
+      add<Weighted>(dist(v0, v1, v2, v3, b0, b1, b2, b3), w, jj);
     }
   }
 }
@@ -93,23 +110,40 @@ VectorCounter::count(Variable::tuple const& vars,
                      Variable::indexes const& indexes,
                      Distribution& dist)
 {
-   std::size_t nvars = indexes.size();
-   std::size_t varlen = vars.front().size();
+  std::size_t nvars = indexes.size();
+  std::size_t varlen = vars.front().size();
+  auto w = (weights) ? weights->data() : nullptr;
 
   dist.initialize(vars, indexes);
 
   switch (nvars) {
     case 1:
-      count1d(varlen, vars, indexes, dist);
+      if (w) {
+        count1d<true>(varlen, vars, indexes, dist, w);
+      } else {
+        count1d<false>(varlen, vars, indexes, dist, w);
+      }
       break;
     case 2:
-      count2d(varlen, vars, indexes, dist);
+      if (w) {
+        count2d<true>(varlen, vars, indexes, dist, w);
+      } else {
+        count2d<false>(varlen, vars, indexes, dist, w);
+      }
       break;
     case 3:
-      count3d(varlen, vars, indexes, dist);
+      if (w) {
+        count3d<true>(varlen, vars, indexes, dist, w);
+      } else {
+        count3d<false>(varlen, vars, indexes, dist, w);
+      }
       break;
     case 4:
-      count4d(varlen, vars, indexes, dist);
+      if (w) {
+        count4d<true>(varlen, vars, indexes, dist, w);
+      } else {
+        count4d<false>(varlen, vars, indexes, dist, w);
+      }
       break;
     default:
       throw VectorCounterException("count",
@@ -124,6 +158,7 @@ VectorCounter::count(Variable::tuple const& vars, Distribution& dist)
 {
   std::size_t nvars = vars.size();
   std::size_t varlen = vars.front().size();
+  auto w = (weights) ? weights->data() : nullptr;
 
   Variable::indexes indexes(nvars);
   for (std::size_t ii = 0; ii < nvars; ii++) {
@@ -134,13 +169,25 @@ VectorCounter::count(Variable::tuple const& vars, Distribution& dist)
 
   switch (nvars) {
     case 1:
-      count1d(varlen, vars, indexes, dist);
+      if (w) {
+        count1d<true>(varlen, vars, indexes, dist, w);
+      } else {
+        count1d<false>(varlen, vars, indexes, dist, w);
+      }
       break;
     case 2:
-      count2d(varlen, vars, indexes, dist);
+      if (w) {
+        count2d<true>(varlen, vars, indexes, dist, w);
+      } else {
+        count2d<false>(varlen, vars, indexes, dist, w);
+      }
       break;
     case 3:
-      count3d(varlen, vars, indexes, dist);
+      if (w) {
+        count3d<true>(varlen, vars, indexes, dist, w);
+      } else {
+        count3d<false>(varlen, vars, indexes, dist, w);
+      }
       break;
     default:
       throw VectorCounterException("count",
@@ -154,9 +201,14 @@ void
 VectorCounter::count(Variable const& var, Distribution& dist)
 {
   std::size_t varlen = var.size();
+  auto w = (weights) ? weights->data() : nullptr;
   Variable::tuple vars(1);
   vars[0] = var;
   Variable::indexes indexes{ 0 };
   dist.initialize(vars, indexes);
-  count1d(varlen, vars, indexes, dist);
+  if (w) {
+    count1d<true>(varlen, vars, indexes, dist, w);
+  } else {
+    count1d<false>(varlen, vars, indexes, dist, w);
+  }
 }
@@ -93,3 +93,26 @@ BOOST_AUTO_TEST_CASE(VectorCounter_polymorph)
   BOOST_TEST(pd(std::vector<Variable::data_t>{ 1, 0 }) == 2);
   BOOST_TEST(pd(std::vector<Variable::data_t>{ 1, 1 }) == 1);
 }
+
+BOOST_AUTO_TEST_CASE(VectorCounter_weights)
+{
+  auto weights = std::make_shared<std::vector<it::VectorCounter::weight_t>>(
+    std::vector<it::VectorCounter::weight_t>{ 1, 2, 3, 1, 1, 2 });
+  it::VectorCounter pdv(weights);
+
+  Variable::tuple vars;
+  vars.push_back(variable_many_bin2_a);
+  vars.push_back(variable_many_bin2_b);
+
+  it::Distribution pd1;
+  pdv.count(vars, { 0 }, pd1);
+  BOOST_TEST(pd1(std::vector<Variable::data_t>{ 0 }) == 3);
+  BOOST_TEST(pd1(std::vector<Variable::data_t>{ 1 }) == 7);
+
+  it::Distribution pd2;
+  pdv.count(vars, { 0, 1 }, pd2);
+  BOOST_TEST(pd2(std::vector<Variable::data_t>{ 0, 0 }) == 1);
+  BOOST_TEST(pd2(std::vector<Variable::data_t>{ 0, 1 }) == 2);
+  BOOST_TEST(pd2(std::vector<Variable::data_t>{ 1, 0 }) == 5);
+  BOOST_TEST(pd2(std::vector<Variable::data_t>{ 1, 1 }) == 2);
+}